@@ -33,6 +33,7 @@
 #include "gfbgraph-album.h"
 #include "gfbgraph-user.h"
 #include "gfbgraph-connectable.h"
+#include "gfbgraph-private.h"
 
 enum {
         PROP_O,
@@ -56,6 +57,9 @@ static void gfbgraph_album_finalize     (GObject *obj);
 static void gfbgraph_album_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
 static void gfbgraph_album_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
 
+static gboolean gfbgraph_album_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node);
+static void     gfbgraph_album_serialize_members  (GFBGraphNode *node, JsonBuilder *builder);
+
 static void gfbgraph_album_connectable_iface_init (GFBGraphConnectableInterface *iface);
 GHashTable* gfbgraph_album_get_connection_post_params (GFBGraphConnectable *self, GType node_type);
 
@@ -76,6 +80,7 @@ static void
 gfbgraph_album_class_init (GFBGraphAlbumClass *klass)
 {
         GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+        GFBGraphNodeClass *node_class = GFBGRAPH_NODE_CLASS (klass);
 
         parent_class            = g_type_class_peek_parent (klass);
 
@@ -83,6 +88,9 @@ gfbgraph_album_class_init (GFBGraphAlbumClass *klass)
         gobject_class->set_property = gfbgraph_album_set_property;
         gobject_class->get_property = gfbgraph_album_get_property;
 
+        node_class->deserialize_member = gfbgraph_album_deserialize_member;
+        node_class->serialize_members = gfbgraph_album_serialize_members;
+
         g_type_class_add_private (gobject_class, sizeof(GFBGraphAlbumPrivate));
 
         /**
@@ -138,6 +146,14 @@ gfbgraph_album_class_init (GFBGraphAlbumClass *klass)
 static void
 gfbgraph_album_finalize (GObject *obj)
 {
+        GFBGraphAlbumPrivate *priv;
+
+        priv = GFBGRAPH_ALBUM_GET_PRIVATE (obj);
+
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->name);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->description);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->cover_photo);
+
         G_OBJECT_CLASS(parent_class)->finalize (obj);
 }
 
@@ -148,21 +164,22 @@ gfbgraph_album_set_property (GObject *object, guint prop_id, const GValue *value
 
         priv = GFBGRAPH_ALBUM_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+        if (!gfbgraph_node_check_writable (GFBGRAPH_NODE (object)))
+                return;
+
         switch (prop_id) {
                 case PROP_NAME:
-                        if (priv->name)
-                                g_free (priv->name);
-                        priv->name = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->name);
+                        priv->name = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_DESCRIPTION:
-                        if (priv->description)
-                                g_free (priv->description);
-                        priv->description = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->description);
+                        priv->description = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_COVER_PHOTO:
-                        if (priv->cover_photo)
-                                g_free (priv->cover_photo);
-                        priv->cover_photo = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->cover_photo);
+                        priv->cover_photo = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_COUNT:
                         priv->count = g_value_get_uint (value);
@@ -180,6 +197,8 @@ gfbgraph_album_get_property (GObject *object, guint prop_id, GValue *value, GPar
 
         priv = GFBGRAPH_ALBUM_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+
         switch (prop_id) {
                 case PROP_NAME:
                         g_value_set_string (value, priv->name);
@@ -199,6 +218,40 @@ gfbgraph_album_get_property (GObject *object, guint prop_id, GValue *value, GPar
         }
 }
 
+static gboolean
+gfbgraph_album_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node)
+{
+        GFBGraphAlbumPrivate *priv;
+
+        priv = GFBGRAPH_ALBUM (node)->priv;
+
+        if (g_strcmp0 (member_name, "name") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->name);
+        else if (g_strcmp0 (member_name, "description") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->description);
+        else if (g_strcmp0 (member_name, "cover_photo") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->cover_photo);
+        else if (g_strcmp0 (member_name, "count") == 0)
+                return gfbgraph_node_deserialize_uint (node, member_node, &priv->count);
+
+        return parent_class->deserialize_member (node, member_name, member_node);
+}
+
+static void
+gfbgraph_album_serialize_members (GFBGraphNode *node, JsonBuilder *builder)
+{
+        GFBGraphAlbumPrivate *priv;
+
+        priv = GFBGRAPH_ALBUM (node)->priv;
+
+        parent_class->serialize_members (node, builder);
+
+        gfbgraph_node_serialize_string (builder, "name", priv->name);
+        gfbgraph_node_serialize_string (builder, "description", priv->description);
+        gfbgraph_node_serialize_string (builder, "cover_photo", priv->cover_photo);
+        gfbgraph_node_serialize_uint (builder, "count", priv->count);
+}
+
 static void
 gfbgraph_album_connectable_iface_init (GFBGraphConnectableInterface *iface)
 {
@@ -209,7 +262,7 @@ gfbgraph_album_connectable_iface_init (GFBGraphConnectableInterface *iface)
 
         iface->connections = connections;
         iface->get_connection_post_params = gfbgraph_album_get_connection_post_params;
-        iface->parse_connected_data = gfbgraph_connectable_default_parse_connected_data;
+        iface->parse_connected_data_array = gfbgraph_connectable_default_parse_connected_data_array;
 }
 
 GHashTable*
@@ -220,6 +273,8 @@ gfbgraph_album_get_connection_post_params (GFBGraphConnectable *self, GType node
 
         priv = GFBGRAPH_ALBUM_GET_PRIVATE (self);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (self));
+
         params = g_hash_table_new (g_str_hash, g_str_equal);
         g_hash_table_insert (params, "name", priv->name);
         if (priv->description != NULL)
@@ -269,6 +324,8 @@ gfbgraph_album_get_name (GFBGraphAlbum *album)
 {
         g_return_val_if_fail (GFBGRAPH_IS_ALBUM (album), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (album));
+
         return album->priv->name;
 }
 
@@ -283,6 +340,8 @@ gfbgraph_album_get_description (GFBGraphAlbum *album)
 {
         g_return_val_if_fail (GFBGRAPH_IS_ALBUM (album), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (album));
+
         return album->priv->description;
 }
 
@@ -297,6 +356,8 @@ gfbgraph_album_get_cover_photo_id (GFBGraphAlbum *album)
 {
         g_return_val_if_fail (GFBGRAPH_IS_ALBUM (album), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (album));
+
         return album->priv->cover_photo;
 }
 
@@ -311,6 +372,8 @@ gfbgraph_album_get_count (GFBGraphAlbum *album)
 {
         g_return_val_if_fail (GFBGRAPH_IS_ALBUM (album), -1);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (album));
+
         return album->priv->count;
 }
 
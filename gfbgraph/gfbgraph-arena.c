@@ -0,0 +1,159 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A reference counted string arena. All the nodes deserialized from the same
+ * page share one, so their strings are carved from a few big blocks instead
+ * of one malloc per field, and they are released at once when the last node
+ * of the page is finalized. */
+
+#include <string.h>
+
+#include "gfbgraph-private.h"
+
+#define ARENA_BLOCK_SIZE 16384
+
+typedef struct {
+        gchar *start;
+        gsize  size;
+} GFBGraphArenaBlock;
+
+struct _GFBGraphArena {
+        volatile gint ref_count;
+
+        GMutex  mutex;
+        GArray *blocks;
+        gchar  *current;
+        gsize   current_left;
+};
+
+GFBGraphArena*
+gfbgraph_arena_new (void)
+{
+        GFBGraphArena *arena;
+
+        arena = g_slice_new0 (GFBGraphArena);
+        arena->ref_count = 1;
+        g_mutex_init (&arena->mutex);
+        arena->blocks = g_array_new (FALSE, FALSE, sizeof (GFBGraphArenaBlock));
+
+        return arena;
+}
+
+GFBGraphArena*
+gfbgraph_arena_ref (GFBGraphArena *arena)
+{
+        g_return_val_if_fail (arena != NULL, NULL);
+
+        g_atomic_int_inc (&arena->ref_count);
+
+        return arena;
+}
+
+void
+gfbgraph_arena_unref (GFBGraphArena *arena)
+{
+        guint i;
+
+        g_return_if_fail (arena != NULL);
+
+        if (!g_atomic_int_dec_and_test (&arena->ref_count))
+                return;
+
+        for (i = 0; i < arena->blocks->len; i++)
+                g_free (g_array_index (arena->blocks, GFBGraphArenaBlock, i).start);
+
+        g_array_free (arena->blocks, TRUE);
+        g_mutex_clear (&arena->mutex);
+
+        g_slice_free (GFBGraphArena, arena);
+}
+
+static gchar*
+gfbgraph_arena_alloc_block (GFBGraphArena *arena, gsize size)
+{
+        GFBGraphArenaBlock block;
+
+        block.start = g_malloc (size);
+        block.size = size;
+        g_array_append_val (arena->blocks, block);
+
+        return block.start;
+}
+
+/* Copies @str into @arena. The copy lives until the arena is released. */
+gchar*
+gfbgraph_arena_strdup (GFBGraphArena *arena, const gchar *str)
+{
+        gchar *copy;
+        gsize len;
+
+        g_return_val_if_fail (arena != NULL, NULL);
+
+        if (str == NULL)
+                return NULL;
+
+        len = strlen (str) + 1;
+
+        g_mutex_lock (&arena->mutex);
+
+        if (len > ARENA_BLOCK_SIZE / 4) {
+                /* Big strings get their own block, so they don't waste the current one */
+                copy = gfbgraph_arena_alloc_block (arena, len);
+        } else {
+                if (len > arena->current_left) {
+                        arena->current = gfbgraph_arena_alloc_block (arena, ARENA_BLOCK_SIZE);
+                        arena->current_left = ARENA_BLOCK_SIZE;
+                }
+
+                copy = arena->current;
+                arena->current += len;
+                arena->current_left -= len;
+        }
+
+        memcpy (copy, str, len);
+
+        g_mutex_unlock (&arena->mutex);
+
+        return copy;
+}
+
+/* Checks if @mem was allocated by @arena. It scans every block, so it is
+ * only meant for checks, the nodes know their strings live in their arena. */
+gboolean
+gfbgraph_arena_contains (GFBGraphArena *arena, gconstpointer mem)
+{
+        const gchar *ptr = mem;
+        gboolean found;
+        guint i;
+
+        g_return_val_if_fail (arena != NULL, FALSE);
+
+        found = FALSE;
+
+        g_mutex_lock (&arena->mutex);
+        for (i = 0; i < arena->blocks->len && !found; i++) {
+                GFBGraphArenaBlock *block;
+
+                block = &g_array_index (arena->blocks, GFBGraphArenaBlock, i);
+                found = (ptr >= block->start && ptr < block->start + block->size);
+        }
+        g_mutex_unlock (&arena->mutex);
+
+        return found;
+}
@@ -28,12 +28,32 @@
  **/
 
 #include "gfbgraph-authorizer.h"
+#include "gfbgraph-request.h"
+#include "gfbgraph-private.h"
+#include "gfbgraph-trace.h"
 
 G_DEFINE_INTERFACE (GFBGraphAuthorizer, gfbgraph_authorizer, G_TYPE_OBJECT);
 
 static void
 gfbgraph_authorizer_default_init (GFBGraphAuthorizerInterface *iface)
 {
+        /**
+         * GFBGraphAuthorizer::request-finished:
+         * @authorizer: the #GFBGraphAuthorizer which authorized the request.
+         * @record: a #GFBGraphRequestRecord describing the request.
+         *
+         * Emitted when a request done with @authorizer finishes, successfully or not.
+         * The signal is emitted in the thread which did the request, so the handlers
+         * must be thread safe when the asynchronous functions are used.
+         **/
+        g_signal_new ("request-finished",
+                      G_TYPE_FROM_INTERFACE (iface),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL, NULL,
+                      g_cclosure_marshal_VOID__BOXED,
+                      G_TYPE_NONE, 1,
+                      GFBGRAPH_TYPE_REQUEST_RECORD | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 /**
@@ -49,7 +69,10 @@ void
 gfbgraph_authorizer_process_call (GFBGraphAuthorizer *iface, RestProxyCall *call)
 {
         g_return_if_fail (GFBGRAPH_IS_AUTHORIZER (iface));
+
+        GFBGRAPH_TRACE1 (auth__start, rest_proxy_call_get_function (call));
         GFBGRAPH_AUTHORIZER_GET_IFACE (iface)->process_call (iface, call);
+        GFBGRAPH_TRACE1 (auth__end, rest_proxy_call_get_function (call));
 }
 
 /**
@@ -86,5 +109,8 @@ gboolean
 gfbgraph_authorizer_refresh_authorization (GFBGraphAuthorizer *iface, GCancellable *cancellable, GError **error)
 {
         g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (iface), FALSE);
+
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_TOKEN_REFRESHES, 1);
+
         return GFBGRAPH_AUTHORIZER_GET_IFACE (iface)->refresh_authorization (iface, cancellable, error);
 }
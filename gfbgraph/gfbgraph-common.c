@@ -18,34 +18,316 @@
  */
 
 #include "gfbgraph-common.h"
+#include "gfbgraph-album.h"
+#include "gfbgraph-photo.h"
+#include "gfbgraph-user.h"
+#include "gfbgraph-private.h"
 
-#include <rest/rest-proxy.h>
+/* A request being executed, shared by all the callers asking for the same */
+typedef struct {
+        gint ref_count;
+        gboolean done;
+        gpointer result;
+        GError *error;
+        GDestroyNotify free_func;
+} GFBGraphFlight;
 
-#define FACEBOOK_ENDPOINT "https://graph.facebook.com/v2.3"
+static GMutex flights_mutex;
+static GCond flights_cond;
+static GHashTable *flights = NULL;
+
+static volatile gint string_pooling = TRUE;
+static volatile gint lazy_deserialization = FALSE;
 
 /**
  * gfbgraph_new_rest_call:
  * @authorizer: a #GFBGraphAuthorizer.
  *
  * Create a new #RestProxyCall pointing to the Facebook Graph API url (https://graph.facebook.com)
- * and processed by the authorizer to allow queries.
+ * and processed by the authorizer to allow queries. All the calls share the same connections,
+ * and their responses are transferred compressed.
  *
  * Returns: (transfer full): a new #RestProxyCall or %NULL in case of error.
  **/
 RestProxyCall*
 gfbgraph_new_rest_call (GFBGraphAuthorizer *authorizer)
 {
-        RestProxy *proxy;
         RestProxyCall *rest_call;
 
         g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
 
-        proxy = rest_proxy_new (FACEBOOK_ENDPOINT, FALSE);
-        rest_call = rest_proxy_new_call (proxy);
+        rest_call = rest_proxy_new_call (gfbgraph_transfer_get_proxy ());
 
         gfbgraph_authorizer_process_call (authorizer, rest_call);
 
-        g_object_unref (proxy);
+        return rest_call;
+}
+
+/* Like gfbgraph_new_rest_call(), for a @method request to @function. Both are
+ * set before the authorization, so the auth probes see the function. */
+RestProxyCall*
+gfbgraph_new_function_call (GFBGraphAuthorizer *authorizer, const gchar *method, const gchar *function)
+{
+        RestProxyCall *rest_call;
+
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
+
+        rest_call = rest_proxy_new_call (gfbgraph_transfer_get_proxy ());
+        rest_proxy_call_set_method (rest_call, method);
+        rest_proxy_call_set_function (rest_call, function);
+
+        gfbgraph_authorizer_process_call (authorizer, rest_call);
 
         return rest_call;
 }
+
+/**
+ * gfbgraph_set_string_pooling:
+ * @enabled: %TRUE to share the string storage between the nodes of a page.
+ *
+ * When enabled (the default), the nodes returned from a single connection request
+ * allocate their strings from one shared pool, which is released when the last of
+ * those nodes is finalized. This avoids an allocation per string field on big pages,
+ * but a single node kept alive retains the memory of its whole page. Disable it if
+ * you keep a few nodes around for a long time and drop the rest.
+ *
+ * This setting only affects the nodes created after the call.
+ **/
+void
+gfbgraph_set_string_pooling (gboolean enabled)
+{
+        g_atomic_int_set (&string_pooling, enabled ? TRUE : FALSE);
+}
+
+/**
+ * gfbgraph_get_string_pooling:
+ *
+ * Checks if the nodes from the same connection request share their string storage.
+ * See gfbgraph_set_string_pooling().
+ *
+ * Returns: %TRUE if string pooling is enabled.
+ **/
+gboolean
+gfbgraph_get_string_pooling (void)
+{
+        return g_atomic_int_get (&string_pooling);
+}
+
+/**
+ * gfbgraph_set_lazy_deserialization:
+ * @enabled: %TRUE to decode the node fields on first access.
+ *
+ * When enabled, the nodes retrieved from the Graph API only decode their ID up front,
+ * and keep the JSON response until any other field is read, through a getter or a
+ * property. It saves time and memory when only a few fields of big pages are used,
+ * like in list views. Disabled by default.
+ *
+ * This setting only affects the nodes created after the call.
+ **/
+void
+gfbgraph_set_lazy_deserialization (gboolean enabled)
+{
+        g_atomic_int_set (&lazy_deserialization, enabled ? TRUE : FALSE);
+}
+
+/**
+ * gfbgraph_get_lazy_deserialization:
+ *
+ * Checks if the nodes decode their fields on first access.
+ * See gfbgraph_set_lazy_deserialization().
+ *
+ * Returns: %TRUE if lazy deserialization is enabled.
+ **/
+gboolean
+gfbgraph_get_lazy_deserialization (void)
+{
+        return g_atomic_int_get (&lazy_deserialization);
+}
+
+/* Converts the ISO 8601 dates used by the Graph API, like "2013-05-01T10:00:00+0000",
+ * into seconds since the Epoch. Returns 0 if @iso_time is %NULL or invalid. */
+gint64
+gfbgraph_iso8601_to_unix (const gchar *iso_time)
+{
+        GTimeVal time_val;
+
+        if (iso_time == NULL || !g_time_val_from_iso8601 (iso_time, &time_val))
+                return 0;
+
+        return time_val.tv_sec;
+}
+
+/* Looks up the #GFBGraphNode type named @type_name, as stored with the nodes
+ * saved to disk. The library node types are registered first, as they may not
+ * have been used yet in this process. Returns %G_TYPE_INVALID if unknown. */
+GType
+gfbgraph_node_type_from_name (const gchar *type_name)
+{
+        GType node_type;
+
+        if (type_name == NULL)
+                return G_TYPE_INVALID;
+
+        g_type_ensure (GFBGRAPH_TYPE_ALBUM);
+        g_type_ensure (GFBGRAPH_TYPE_PHOTO);
+        g_type_ensure (GFBGRAPH_TYPE_USER);
+
+        node_type = g_type_from_name (type_name);
+        if (node_type == G_TYPE_INVALID || !g_type_is_a (node_type, GFBGRAPH_TYPE_NODE))
+                return G_TYPE_INVALID;
+
+        return node_type;
+}
+
+static gint
+compare_strings (gconstpointer a, gconstpointer b)
+{
+        return g_strcmp0 ((const gchar *) a, (const gchar *) b);
+}
+
+/* Builds the key identifying a GET request to @function with @params done
+ * through @authorizer, for gfbgraph_single_flight() */
+gchar*
+gfbgraph_request_key (GFBGraphAuthorizer *authorizer, const gchar *function, GHashTable *params)
+{
+        GString *key;
+
+        key = g_string_new (NULL);
+        g_string_printf (key, "%p\n%s\n", (gpointer) authorizer, function);
+
+        if (params != NULL) {
+                GList *names;
+                GList *l;
+
+                /* The same params can be inserted in different order */
+                names = g_list_sort (g_hash_table_get_keys (params), compare_strings);
+                for (l = names; l != NULL; l = l->next)
+                        g_string_append_printf (key, "%s=%s&", (const gchar *) l->data, (const gchar *) g_hash_table_lookup (params, l->data));
+                g_list_free (names);
+        }
+
+        return g_string_free (key, FALSE);
+}
+
+static void
+gfbgraph_flight_unref_locked (GFBGraphFlight *flight)
+{
+        if (--flight->ref_count > 0)
+                return;
+
+        if (flight->result != NULL)
+                flight->free_func (flight->result);
+        if (flight->error != NULL)
+                g_error_free (flight->error);
+
+        g_slice_free (GFBGraphFlight, flight);
+}
+
+/* Joins @flight, waiting until it is done or until the deadline of the request
+ * of the calling thread. Returns %FALSE, with @flight already released, if the
+ * deadline passed first. */
+static gboolean
+gfbgraph_flight_wait_locked (GFBGraphFlight *flight, GError **error)
+{
+        GFBGraphRequestRecord *record;
+
+        record = gfbgraph_request_record_get_current ();
+        if (record != NULL)
+                record->cache_hit = TRUE;
+
+        flight->ref_count++;
+        while (!flight->done) {
+                if (record == NULL || record->deadline == 0) {
+                        g_cond_wait (&flights_cond, &flights_mutex);
+                } else if (!g_cond_wait_until (&flights_cond, &flights_mutex, record->deadline)) {
+                        /* The shared request is late for this caller */
+                        gfbgraph_request_record_check_deadline (record, error);
+                        gfbgraph_flight_unref_locked (flight);
+
+                        return FALSE;
+                }
+        }
+
+        return TRUE;
+}
+
+/* Runs @func as a new flight for @key, which the others can join meanwhile */
+static GFBGraphFlight*
+gfbgraph_flight_run_locked (const gchar *key, GFBGraphFlightFunc func, gpointer user_data, GDestroyNotify free_func)
+{
+        GFBGraphRequestRecord *record;
+        GFBGraphFlight *flight;
+        GError *func_error = NULL;
+        gpointer func_result;
+
+        /* It could have joined an earlier flight before */
+        record = gfbgraph_request_record_get_current ();
+        if (record != NULL)
+                record->cache_hit = FALSE;
+
+        flight = g_slice_new0 (GFBGraphFlight);
+        flight->ref_count = 1;
+        flight->free_func = free_func;
+        g_hash_table_insert (flights, g_strdup (key), flight);
+
+        g_mutex_unlock (&flights_mutex);
+        func_result = func (user_data, &func_error);
+        g_mutex_lock (&flights_mutex);
+
+        flight->result = func_result;
+        flight->error = func_error;
+        flight->done = TRUE;
+
+        /* From now on, new callers will do a new request */
+        g_hash_table_remove (flights, key);
+        g_cond_broadcast (&flights_cond);
+
+        return flight;
+}
+
+/* Runs @func unless another thread is already running it for the same @key,
+ * in which case it waits for that one and shares its result. Every caller gets
+ * its own copy of the result made with @copy_func, so objects are shared
+ * by reference between the callers. A flight which missed the deadline of the
+ * thread running it isn't shared: the waiting callers try again, and one of
+ * them runs a new flight. */
+gpointer
+gfbgraph_single_flight (const gchar *key, GFBGraphFlightFunc func, gpointer user_data, GBoxedCopyFunc copy_func, GDestroyNotify free_func, GError **error)
+{
+        GFBGraphFlight *flight;
+        gpointer result;
+
+        g_mutex_lock (&flights_mutex);
+
+        if (flights == NULL)
+                flights = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        while (TRUE) {
+                flight = g_hash_table_lookup (flights, key);
+                if (flight == NULL) {
+                        flight = gfbgraph_flight_run_locked (key, func, user_data, free_func);
+                        break;
+                }
+
+                if (!gfbgraph_flight_wait_locked (flight, error)) {
+                        g_mutex_unlock (&flights_mutex);
+                        return NULL;
+                }
+
+                /* That deadline was the one of the leader, not of this caller */
+                if (!g_error_matches (flight->error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+                        break;
+
+                gfbgraph_flight_unref_locked (flight);
+        }
+
+        result = flight->result ? copy_func (flight->result) : NULL;
+        if (flight->error != NULL)
+                g_propagate_error (error, g_error_copy (flight->error));
+
+        gfbgraph_flight_unref_locked (flight);
+
+        g_mutex_unlock (&flights_mutex);
+
+        return result;
+}
@@ -23,6 +23,25 @@
 #include <rest/rest-proxy-call.h>
 #include <gfbgraph/gfbgraph-authorizer.h>
 
-RestProxyCall* gfbgraph_new_rest_call (GFBGraphAuthorizer *authorizer);
+G_BEGIN_DECLS
+
+RestProxyCall* gfbgraph_new_rest_call      (GFBGraphAuthorizer *authorizer);
+
+void           gfbgraph_set_string_pooling (gboolean enabled);
+gboolean       gfbgraph_get_string_pooling (void);
+
+void           gfbgraph_set_lazy_deserialization (gboolean enabled);
+gboolean       gfbgraph_get_lazy_deserialization (void);
+
+void           gfbgraph_get_transfer_stats (guint64 *wire_bytes, guint64 *decoded_bytes);
+
+gboolean       gfbgraph_warmup              (const gchar * const *uris, GCancellable *cancellable, GError **error);
+void           gfbgraph_warmup_async        (const gchar * const *uris, GCancellable *cancellable,
+                                             GAsyncReadyCallback callback, gpointer user_data);
+gboolean       gfbgraph_warmup_async_finish (GAsyncResult *result, GError **error);
+
+gboolean       gfbgraph_set_image_cache    (const gchar *directory, guint64 max_size, GError **error);
+
+G_END_DECLS
 
 #endif /* __GFBGRAPH_COMMON_H__ */
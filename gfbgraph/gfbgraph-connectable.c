@@ -29,11 +29,32 @@
  * <ulink url="https://developers.facebook.com/docs/reference/api/">Facebook Graph API documentation</ulink>
  **/
 
+#include "gfbgraph-common.h"
 #include "gfbgraph-connectable.h"
 #include "gfbgraph-node.h"
+#include "gfbgraph-private.h"
+#include "gfbgraph-trace.h"
 
 #include <json-glib/json-glib.h>
 
+/* The connections of a connectable type, resolved to GTypes the first time
+ * they are requested, so lookups don't need an instance or string hashing */
+typedef struct {
+        GType        node_type;
+        const gchar *path;
+} GFBGraphConnection;
+
+typedef struct {
+        guint              n_connections;
+        GFBGraphConnection connections[1];
+} GFBGraphConnectionTable;
+
+G_LOCK_DEFINE_STATIC (connection_tables);
+
+static GPtrArray* gfbgraph_connectable_parse_type_data_array (GType node_type, const gchar *payload, gchar **next_url, gint64 *total_count, GError **error);
+static gchar*     gfbgraph_connectable_get_paging_next      (JsonObject *main_jobject);
+static gint64     gfbgraph_connectable_get_total_count      (JsonObject *main_jobject);
+
 G_DEFINE_INTERFACE (GFBGraphConnectable, gfbgraph_connectable, GFBGRAPH_TYPE_NODE)
 
 static void
@@ -43,6 +64,7 @@ gfbgraph_connectable_default_init (GFBGraphConnectableInterface *iface)
 
         iface->get_connection_post_params = NULL;
         iface->parse_connected_data = NULL;
+        iface->parse_connected_data_array = NULL;
 }
 
 static GHashTable*
@@ -62,6 +84,71 @@ get_connections (GFBGraphConnectableInterface *iface)
         return connections;
 }
 
+static GQuark
+connection_table_quark (void)
+{
+        return g_quark_from_static_string ("gfbgraph-connection-table");
+}
+
+static const GFBGraphConnectionTable*
+get_connection_table (GType self_type)
+{
+        GFBGraphConnectionTable *table;
+
+        table = g_type_get_qdata (self_type, connection_table_quark ());
+        if (table != NULL)
+                return table;
+
+        G_LOCK (connection_tables);
+
+        table = g_type_get_qdata (self_type, connection_table_quark ());
+        if (table == NULL) {
+                GFBGraphConnectableInterface *iface;
+                GHashTable *connections;
+                GHashTableIter iter;
+                gpointer klass;
+                gpointer key, value;
+                guint i;
+
+                /* Static types never release their class, so this reference is kept */
+                klass = g_type_class_ref (self_type);
+                iface = g_type_interface_peek (klass, GFBGRAPH_TYPE_CONNECTABLE);
+
+                connections = get_connections (iface);
+                table = g_malloc (sizeof (GFBGraphConnectionTable) + (g_hash_table_size (connections) - 1) * sizeof (GFBGraphConnection));
+                table->n_connections = g_hash_table_size (connections);
+
+                i = 0;
+                g_hash_table_iter_init (&iter, connections);
+                while (g_hash_table_iter_next (&iter, &key, &value)) {
+                        table->connections[i].node_type = g_type_from_name ((const gchar *) key);
+                        table->connections[i].path = (const gchar *) value;
+                        i++;
+                }
+
+                g_type_set_qdata (self_type, connection_table_quark (), table);
+        }
+
+        G_UNLOCK (connection_tables);
+
+        return table;
+}
+
+static const GFBGraphConnection*
+lookup_connection (GType self_type, GType node_type)
+{
+        const GFBGraphConnectionTable *table;
+        guint i;
+
+        table = get_connection_table (self_type);
+        for (i = 0; i < table->n_connections; i++) {
+                if (table->connections[i].node_type == node_type)
+                        return &table->connections[i];
+        }
+
+        return NULL;
+}
+
 /**
  * gfbgraph_connectable_get_connection_post_params:
  * @self: a #GFBGraphConnectable.
@@ -106,9 +193,50 @@ gfbgraph_connectable_parse_connected_data (GFBGraphConnectable *self, const gcha
         g_return_val_if_fail (GFBGRAPH_IS_CONNECTABLE (self), NULL);
 
         iface = GFBGRAPH_CONNECTABLE_GET_IFACE (self);
-        g_assert (iface->parse_connected_data != NULL);
+        g_assert (iface->parse_connected_data != NULL || iface->parse_connected_data_array != NULL);
+
+        if (iface->parse_connected_data != NULL)
+                return iface->parse_connected_data (self, payload, error);
 
-        return iface->parse_connected_data (self, payload, error);
+        return gfbgraph_ptr_array_steal_to_list (iface->parse_connected_data_array (self, payload, error));
+}
+
+/**
+ * gfbgraph_connectable_parse_connected_data_array:
+ * @self: a #GFBGraphConnectable.
+ * @payload: a const #gchar with the response string from the Facebook Graph API.
+ * @error: (allow-none): a #GError.
+ *
+ * Like gfbgraph_connectable_parse_connected_data(), but returning the nodes in
+ * an array, which is cheaper to build and to index for big responses.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray of #GFBGraphNode created
+ * from the @payload, or %NULL. Free it with g_ptr_array_unref().
+ **/
+GPtrArray*
+gfbgraph_connectable_parse_connected_data_array (GFBGraphConnectable *self, const gchar *payload, GError **error)
+{
+        GFBGraphConnectableInterface *iface;
+        GList *nodes_list;
+        GError *parse_error = NULL;
+
+        g_return_val_if_fail (GFBGRAPH_IS_CONNECTABLE (self), NULL);
+
+        iface = GFBGRAPH_CONNECTABLE_GET_IFACE (self);
+        g_assert (iface->parse_connected_data != NULL || iface->parse_connected_data_array != NULL);
+
+        /* Implementers only overriding the list based parser keep working */
+        if (iface->parse_connected_data_array != NULL)
+                return iface->parse_connected_data_array (self, payload, error);
+
+        nodes_list = iface->parse_connected_data (self, payload, &parse_error);
+        if (parse_error != NULL) {
+                g_list_free_full (nodes_list, g_object_unref);
+                g_propagate_error (error, parse_error);
+                return NULL;
+        }
+
+        return gfbgraph_list_steal_to_ptr_array (nodes_list);
 }
 
 
@@ -126,16 +254,29 @@ gfbgraph_connectable_parse_connected_data (GFBGraphConnectable *self, const gcha
 gboolean
 gfbgraph_connectable_is_connectable_to (GFBGraphConnectable *self, GType node_type)
 {
-        GFBGraphConnectableInterface *iface;
-        GHashTable *connections;
-
         g_return_val_if_fail (GFBGRAPH_IS_CONNECTABLE (self), FALSE);
         g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), FALSE);
 
-        iface = GFBGRAPH_CONNECTABLE_GET_IFACE (self);
+        return lookup_connection (G_OBJECT_TYPE (self), node_type) != NULL;
+}
 
-        connections = get_connections (iface);
-        return g_hash_table_contains (connections, g_type_name (node_type));
+/**
+ * gfbgraph_connectable_type_is_connectable_to:
+ * @self_type: a #GType implementing #GFBGraphConnectable.
+ * @node_type: a #GType, required a #GFBGRAPH_TYPE_NODE or children.
+ *
+ * Like gfbgraph_connectable_is_connectable_to(), but without an instance of @self_type.
+ *
+ * Returns: %TRUE in case that nodes of type @self_type can be connected to a node of
+ * type @node_type, %FALSE otherwise.
+ **/
+gboolean
+gfbgraph_connectable_type_is_connectable_to (GType self_type, GType node_type)
+{
+        g_return_val_if_fail (g_type_is_a (self_type, GFBGRAPH_TYPE_CONNECTABLE), FALSE);
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), FALSE);
+
+        return lookup_connection (self_type, node_type) != NULL;
 }
 
 /**
@@ -151,17 +292,89 @@ gfbgraph_connectable_is_connectable_to (GFBGraphConnectable *self, GType node_ty
 const gchar*
 gfbgraph_connectable_get_connection_path (GFBGraphConnectable *self, GType node_type)
 {
-        GFBGraphConnectableInterface *iface;
-        GHashTable *connections;
-
         g_return_val_if_fail (GFBGRAPH_IS_CONNECTABLE (self), NULL);
+
+        return gfbgraph_connectable_type_get_connection_path (G_OBJECT_TYPE (self), node_type);
+}
+
+/**
+ * gfbgraph_connectable_type_get_connection_path:
+ * @self_type: a #GType implementing #GFBGraphConnectable.
+ * @node_type: a #GType, required a #GFBGRAPH_TYPE_NODE or children.
+ *
+ * Like gfbgraph_connectable_get_connection_path(), but without an instance of @self_type.
+ *
+ * Returns: (transfer none): a const #gchar with the function path or %NULL.
+ **/
+const gchar*
+gfbgraph_connectable_type_get_connection_path (GType self_type, GType node_type)
+{
+        const GFBGraphConnection *connection;
+
+        g_return_val_if_fail (g_type_is_a (self_type, GFBGRAPH_TYPE_CONNECTABLE), NULL);
         g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
-        g_return_val_if_fail (gfbgraph_connectable_is_connectable_to (self, node_type), NULL);
 
-        iface = GFBGRAPH_CONNECTABLE_GET_IFACE (self);
+        connection = lookup_connection (self_type, node_type);
+        g_return_val_if_fail (connection != NULL, NULL);
+
+        return connection->path;
+}
+
+/* Parses the connected nodes of @self_type from @payload, creating a dummy
+ * instance only when the type brings its own parser. When @next_url isn't
+ * %NULL, it's set to the URL of the next page, or %NULL on the last one.
+ * When @total_count isn't %NULL, it's set to the number of connected nodes
+ * from the response summary, or -1 if there isn't one. */
+GPtrArray*
+gfbgraph_connectable_type_parse_connected_data_array (GType self_type, const gchar *payload, gchar **next_url, gint64 *total_count, GError **error)
+{
+        GFBGraphConnectableInterface *iface;
+        GFBGraphConnectable *dummy;
+        GPtrArray *nodes_array;
+        gpointer klass;
+
+        klass = g_type_class_ref (self_type);
+        iface = g_type_interface_peek (klass, GFBGRAPH_TYPE_CONNECTABLE);
+        g_type_class_unref (klass);
+
+        if (iface->parse_connected_data_array == gfbgraph_connectable_default_parse_connected_data_array
+            || (iface->parse_connected_data_array == NULL
+                && iface->parse_connected_data == gfbgraph_connectable_default_parse_connected_data))
+                return gfbgraph_connectable_parse_type_data_array (self_type, payload, next_url, total_count, error);
+
+        GFBGRAPH_TRACE1 (parse__start, g_type_name (self_type));
+
+        dummy = g_object_new (self_type, NULL);
+        nodes_array = gfbgraph_connectable_parse_connected_data_array (dummy, payload, error);
+        g_object_unref (dummy);
+
+        GFBGRAPH_TRACE2 (parse__end, g_type_name (self_type), nodes_array ? nodes_array->len : 0);
+
+        if (next_url != NULL)
+                *next_url = NULL;
+        if (total_count != NULL)
+                *total_count = -1;
+
+        if (next_url != NULL || total_count != NULL) {
+                JsonParser *jparser;
+
+                /* Custom parsers don't know about paging nor summaries, so look for them apart */
+                jparser = json_parser_new ();
+                if (nodes_array != NULL
+                    && json_parser_load_from_data (jparser, payload, -1, NULL)
+                    && JSON_NODE_HOLDS_OBJECT (json_parser_get_root (jparser))) {
+                        JsonObject *main_jobject;
+
+                        main_jobject = json_node_get_object (json_parser_get_root (jparser));
+                        if (next_url != NULL)
+                                *next_url = gfbgraph_connectable_get_paging_next (main_jobject);
+                        if (total_count != NULL)
+                                *total_count = gfbgraph_connectable_get_total_count (main_jobject);
+                }
+                g_object_unref (jparser);
+        }
 
-        connections = get_connections (iface);
-        return (const gchar *) g_hash_table_lookup (connections, g_type_name (node_type));
+        return nodes_array;
 }
 
 /**
@@ -182,33 +395,151 @@ gfbgraph_connectable_get_connection_path (GFBGraphConnectable *self, GType node_
 GList*
 gfbgraph_connectable_default_parse_connected_data (GFBGraphConnectable *self, const gchar *payload, GError **error)
 {
-        GList *nodes_list = NULL;
+        return gfbgraph_ptr_array_steal_to_list (gfbgraph_connectable_default_parse_connected_data_array (self, payload, error));
+}
+
+/**
+ * gfbgraph_connectable_default_parse_connected_data_array:
+ * @self: a #GFBGraphConnectable.
+ * @payload: a const #gchar with the response string from the Facebook Graph API.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * The array version of gfbgraph_connectable_default_parse_connected_data().
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray of #GFBGraphNode with
+ * the same #GType as @self, or %NULL. Free it with g_ptr_array_unref().
+ **/
+GPtrArray*
+gfbgraph_connectable_default_parse_connected_data_array (GFBGraphConnectable *self, const gchar *payload, GError **error)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_CONNECTABLE (self), NULL);
+
+        return gfbgraph_connectable_parse_type_data_array (G_OBJECT_TYPE (self), payload, NULL, NULL, error);
+}
+
+static GPtrArray*
+gfbgraph_connectable_parse_type_data_array (GType node_type, const gchar *payload, gchar **next_url, gint64 *total_count, GError **error)
+{
+        GPtrArray *nodes_array = NULL;
         JsonParser *jparser;
-        GType node_type;
 
-        node_type = G_OBJECT_TYPE (self);
+        if (next_url != NULL)
+                *next_url = NULL;
+        if (total_count != NULL)
+                *total_count = -1;
+
+        GFBGRAPH_TRACE1 (parse__start, g_type_name (node_type));
 
         jparser = json_parser_new ();
         if (json_parser_load_from_data (jparser, payload, -1, error)) {
                 JsonNode *root_jnode;
                 JsonObject *main_jobject;
                 JsonArray *nodes_jarray;
-                int i = 0;
+                GFBGraphArena *arena;
+                guint i, n_nodes;
+
+                /* All the nodes in the page share the same string storage */
+                arena = gfbgraph_get_string_pooling () ? gfbgraph_arena_new () : NULL;
 
                 root_jnode = json_parser_get_root (jparser);
                 main_jobject = json_node_get_object (root_jnode);
                 nodes_jarray = json_object_get_array_member (main_jobject, "data");
-                for (i = 0; i < json_array_get_length (nodes_jarray); i++) {
+                n_nodes = json_array_get_length (nodes_jarray);
+
+                nodes_array = g_ptr_array_new_full (n_nodes, g_object_unref);
+                for (i = 0; i < n_nodes; i++) {
                         JsonNode *jnode;
-                        GFBGraphNode *node;
 
                         jnode = json_array_get_element (nodes_jarray, i);
-                        node = GFBGRAPH_NODE (json_gobject_deserialize (node_type, jnode));
-                        nodes_list = g_list_append (nodes_list, node);
+                        g_ptr_array_add (nodes_array, gfbgraph_node_deserialize (node_type, jnode, arena));
                 }
+
+                if (arena)
+                        gfbgraph_arena_unref (arena);
+
+                if (next_url != NULL)
+                        *next_url = gfbgraph_connectable_get_paging_next (main_jobject);
+                if (total_count != NULL)
+                        *total_count = gfbgraph_connectable_get_total_count (main_jobject);
         }
 
         g_clear_object (&jparser);
 
-        return nodes_list;
+        GFBGRAPH_TRACE2 (parse__end, g_type_name (node_type), nodes_array ? nodes_array->len : 0);
+
+        return nodes_array;
+}
+
+/* The Graph API returns the URL to the next page of a connection in the
+ * "paging" object, unless the current page is the last one */
+static gchar*
+gfbgraph_connectable_get_paging_next (JsonObject *main_jobject)
+{
+        JsonNode *paging_jnode;
+        JsonObject *paging_jobject;
+
+        paging_jnode = json_object_get_member (main_jobject, "paging");
+        if (paging_jnode == NULL || JSON_NODE_HOLDS_OBJECT (paging_jnode) == FALSE)
+                return NULL;
+
+        paging_jobject = json_node_get_object (paging_jnode);
+        if (json_object_has_member (paging_jobject, "next") == FALSE)
+                return NULL;
+
+        return g_strdup (json_object_get_string_member (paging_jobject, "next"));
+}
+
+/* The "total_count" of the response "summary", only present when requested
+ * with the "summary" param, or -1 if missing */
+static gint64
+gfbgraph_connectable_get_total_count (JsonObject *main_jobject)
+{
+        JsonNode *summary_jnode;
+        JsonObject *summary_jobject;
+
+        summary_jnode = json_object_get_member (main_jobject, "summary");
+        if (summary_jnode == NULL || JSON_NODE_HOLDS_OBJECT (summary_jnode) == FALSE)
+                return -1;
+
+        summary_jobject = json_node_get_object (summary_jnode);
+        if (json_object_has_member (summary_jobject, "total_count") == FALSE)
+                return -1;
+
+        return json_object_get_int_member (summary_jobject, "total_count");
+}
+
+/* Converts an array of nodes, as returned by the array based parsers, into a
+ * GList, keeping the references. @array is released. */
+GList*
+gfbgraph_ptr_array_steal_to_list (GPtrArray *array)
+{
+        GList *list = NULL;
+        guint i;
+
+        if (array == NULL)
+                return NULL;
+
+        for (i = array->len; i > 0; i--)
+                list = g_list_prepend (list, g_ptr_array_index (array, i - 1));
+
+        g_ptr_array_set_free_func (array, NULL);
+        g_ptr_array_unref (array);
+
+        return list;
+}
+
+/* The opposite of gfbgraph_ptr_array_steal_to_list(). @list is released. */
+GPtrArray*
+gfbgraph_list_steal_to_ptr_array (GList *list)
+{
+        GPtrArray *array;
+        GList *l;
+
+        array = g_ptr_array_new_full (g_list_length (list), g_object_unref);
+        for (l = list; l != NULL; l = l->next)
+                g_ptr_array_add (array, l->data);
+
+        g_list_free (list);
+
+        return array;
 }
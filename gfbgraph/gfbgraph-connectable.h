@@ -40,16 +40,21 @@ struct _GFBGraphConnectableInterface {
 
         GHashTable   *(*get_connection_post_params) (GFBGraphConnectable *self, GType node_type);
         GList        *(*parse_connected_data) (GFBGraphConnectable *self, const gchar *payload, GError **error);
+        GPtrArray    *(*parse_connected_data_array) (GFBGraphConnectable *self, const gchar *payload, GError **error);
 };
 
 GType gfbgraph_connectable_get_type (void) G_GNUC_CONST;
 
 GHashTable*  gfbgraph_connectable_get_connection_post_params   (GFBGraphConnectable *self, GType node_type);
 GList*       gfbgraph_connectable_parse_connected_data         (GFBGraphConnectable *self, const gchar *payload, GError **error);
+GPtrArray*   gfbgraph_connectable_parse_connected_data_array   (GFBGraphConnectable *self, const gchar *payload, GError **error);
 
 gboolean     gfbgraph_connectable_is_connectable_to            (GFBGraphConnectable *self, GType node_type);
 const gchar* gfbgraph_connectable_get_connection_path          (GFBGraphConnectable *self, GType node_type);
+gboolean     gfbgraph_connectable_type_is_connectable_to       (GType self_type, GType node_type);
+const gchar* gfbgraph_connectable_type_get_connection_path     (GType self_type, GType node_type);
 GList*       gfbgraph_connectable_default_parse_connected_data (GFBGraphConnectable *self, const gchar *payload, GError **error);
+GPtrArray*   gfbgraph_connectable_default_parse_connected_data_array (GFBGraphConnectable *self, const gchar *payload, GError **error);
 
 G_END_DECLS
 
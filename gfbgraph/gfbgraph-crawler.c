@@ -0,0 +1,620 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-crawler
+ * @short_description: Parallel traversal of the node connections
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * #GFBGraphCrawler walks the connections starting from a root node, like the albums of
+ * a user and then the photos of every album, breadth-first. The node types to follow are
+ * given with gfbgraph_crawler_add_type(), and every connection of a crawled node to one
+ * of those types is followed.
+ *
+ * Every page of every connection is a unit of work, done by a pool of up to
+ * #GFBGraphCrawler:max-concurrency threads taking the next pending unit of the
+ * shallowest level, so the pages of a big album are spread between the threads
+ * instead of waiting for each other. The nodes are given to a #GFBGraphCrawlerFunc
+ * as soon as their page arrives.
+ *
+ * A crawl interrupted by an error or by its #GCancellable can be continued calling
+ * gfbgraph_crawler_run() again, even in another session saving the pending work with
+ * gfbgraph_crawler_save_checkpoint() and restoring it with gfbgraph_crawler_load_checkpoint().
+ **/
+
+#include "gfbgraph-crawler.h"
+#include "gfbgraph-connectable.h"
+#include "gfbgraph-private.h"
+
+#define CRAWLER_CHECKPOINT_FORMAT "a(sssa{ss}u)"
+
+#define CRAWLER_DEFAULT_MAX_CONCURRENCY 4
+
+enum
+{
+        PROP_0,
+
+        PROP_ROOT,
+        PROP_MAX_CONCURRENCY
+};
+
+/* A page of the @node_type nodes connected to @node */
+typedef struct {
+        GFBGraphNode *node;
+        GType node_type;
+        GHashTable *params;
+        guint depth;
+} GFBGraphCrawlerUnit;
+
+struct _GFBGraphCrawlerPrivate {
+        GFBGraphNode *root;
+        guint max_concurrency;
+        GArray *types;
+
+        GMutex mutex;
+        GCond cond;
+        GHashTable *pending;
+        GHashTable *seen;
+        GThreadPool *pool;
+        gboolean stopping;
+        GError *error;
+
+        /* Only valid while running */
+        GFBGraphAuthorizer *authorizer;
+        GFBGraphPriority priority;
+        gint64 deadline;
+        GMutex func_mutex;
+        GFBGraphCrawlerFunc func;
+        gpointer user_data;
+};
+
+static void gfbgraph_crawler_init         (GFBGraphCrawler *obj);
+static void gfbgraph_crawler_class_init   (GFBGraphCrawlerClass *klass);
+static void gfbgraph_crawler_finalize     (GObject *obj);
+static void gfbgraph_crawler_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
+static void gfbgraph_crawler_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+static GFBGraphCrawlerUnit* gfbgraph_crawler_unit_new  (GFBGraphNode *node, GType node_type, GHashTable *params, guint depth);
+static void                 gfbgraph_crawler_unit_free (GFBGraphCrawlerUnit *unit);
+
+static void gfbgraph_crawler_add_unit_locked   (GFBGraphCrawler *crawler, GFBGraphCrawlerUnit *unit);
+static void gfbgraph_crawler_add_children_locked (GFBGraphCrawler *crawler, GFBGraphNode *node, guint depth);
+static void gfbgraph_crawler_worker            (GFBGraphCrawlerUnit *unit, GFBGraphCrawler *crawler);
+static gint gfbgraph_crawler_unit_compare      (gconstpointer a, gconstpointer b, gpointer user_data);
+
+#define GFBGRAPH_CRAWLER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE((o), GFBGRAPH_TYPE_CRAWLER, GFBGraphCrawlerPrivate))
+
+static GObjectClass *parent_class = NULL;
+
+G_DEFINE_TYPE (GFBGraphCrawler, gfbgraph_crawler, G_TYPE_OBJECT);
+
+static void
+gfbgraph_crawler_init (GFBGraphCrawler *obj)
+{
+        obj->priv = GFBGRAPH_CRAWLER_GET_PRIVATE(obj);
+
+        obj->priv->max_concurrency = CRAWLER_DEFAULT_MAX_CONCURRENCY;
+        obj->priv->types = g_array_new (FALSE, FALSE, sizeof (GType));
+        g_mutex_init (&obj->priv->mutex);
+        g_cond_init (&obj->priv->cond);
+        g_mutex_init (&obj->priv->func_mutex);
+        obj->priv->pending = g_hash_table_new_full (g_direct_hash, g_direct_equal, (GDestroyNotify) gfbgraph_crawler_unit_free, NULL);
+        obj->priv->seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+gfbgraph_crawler_class_init (GFBGraphCrawlerClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        parent_class            = g_type_class_peek_parent (klass);
+        gobject_class->finalize = gfbgraph_crawler_finalize;
+        gobject_class->set_property = gfbgraph_crawler_set_property;
+        gobject_class->get_property = gfbgraph_crawler_get_property;
+
+        g_type_class_add_private (gobject_class, sizeof(GFBGraphCrawlerPrivate));
+
+        /**
+         * GFBGraphCrawler:root:
+         *
+         * The node where the crawl starts.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_ROOT,
+                                         g_param_spec_object ("root",
+                                                              "The root node", "The node where the crawl starts",
+                                                              GFBGRAPH_TYPE_NODE,
+                                                              G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphCrawler:max-concurrency:
+         *
+         * The maximum number of pages requested at the same time.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_MAX_CONCURRENCY,
+                                         g_param_spec_uint ("max-concurrency",
+                                                            "Maximum concurrency", "The maximum number of pages requested at the same time",
+                                                            1, G_MAXUINT, CRAWLER_DEFAULT_MAX_CONCURRENCY,
+                                                            G_PARAM_READABLE | G_PARAM_WRITABLE));
+}
+
+static void
+gfbgraph_crawler_finalize (GObject *obj)
+{
+        GFBGraphCrawlerPrivate *priv;
+
+        priv = GFBGRAPH_CRAWLER_GET_PRIVATE (obj);
+
+        g_clear_object (&priv->root);
+        g_array_unref (priv->types);
+        g_hash_table_unref (priv->pending);
+        g_hash_table_unref (priv->seen);
+        g_mutex_clear (&priv->mutex);
+        g_cond_clear (&priv->cond);
+        g_mutex_clear (&priv->func_mutex);
+
+        G_OBJECT_CLASS(parent_class)->finalize (obj);
+}
+
+static void
+gfbgraph_crawler_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+        GFBGraphCrawlerPrivate *priv;
+
+        priv = GFBGRAPH_CRAWLER_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_ROOT:
+                        priv->root = g_value_dup_object (value);
+                        break;
+                case PROP_MAX_CONCURRENCY:
+                        priv->max_concurrency = g_value_get_uint (value);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_crawler_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+        GFBGraphCrawlerPrivate *priv;
+
+        priv = GFBGRAPH_CRAWLER_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_ROOT:
+                        g_value_set_object (value, priv->root);
+                        break;
+                case PROP_MAX_CONCURRENCY:
+                        g_value_set_uint (value, priv->max_concurrency);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static GFBGraphCrawlerUnit*
+gfbgraph_crawler_unit_new (GFBGraphNode *node, GType node_type, GHashTable *params, guint depth)
+{
+        GFBGraphCrawlerUnit *unit;
+
+        unit = g_slice_new (GFBGraphCrawlerUnit);
+        unit->node = g_object_ref (node);
+        unit->node_type = node_type;
+        unit->params = params;
+        unit->depth = depth;
+
+        return unit;
+}
+
+static void
+gfbgraph_crawler_unit_free (GFBGraphCrawlerUnit *unit)
+{
+        g_object_unref (unit->node);
+        if (unit->params != NULL)
+                g_hash_table_unref (unit->params);
+
+        g_slice_free (GFBGraphCrawlerUnit, unit);
+}
+
+/* Breadth-first: the shallowest units first */
+static gint
+gfbgraph_crawler_unit_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+        const GFBGraphCrawlerUnit *unit_a = a;
+        const GFBGraphCrawlerUnit *unit_b = b;
+
+        return (unit_a->depth > unit_b->depth) - (unit_a->depth < unit_b->depth);
+}
+
+/* Takes @unit as pending work, and queues it unless the crawl is stopping */
+static void
+gfbgraph_crawler_add_unit_locked (GFBGraphCrawler *crawler, GFBGraphCrawlerUnit *unit)
+{
+        GFBGraphCrawlerPrivate *priv;
+
+        priv = crawler->priv;
+
+        g_hash_table_add (priv->pending, unit);
+
+        if (priv->pool != NULL && !priv->stopping)
+                g_thread_pool_push (priv->pool, unit, NULL);
+}
+
+/* Adds the first page of every followed connection of @node */
+static void
+gfbgraph_crawler_add_children_locked (GFBGraphCrawler *crawler, GFBGraphNode *node, guint depth)
+{
+        GFBGraphCrawlerPrivate *priv;
+        const gchar *id;
+        guint i;
+
+        priv = crawler->priv;
+
+        id = gfbgraph_node_get_id (node);
+        if (id == NULL)
+                return;
+
+        for (i = 0; i < priv->types->len; i++) {
+                GType node_type;
+                gchar *key;
+
+                node_type = g_array_index (priv->types, GType, i);
+                if (!gfbgraph_connectable_type_is_connectable_to (node_type, G_OBJECT_TYPE (node)))
+                        continue;
+
+                /* The same connection is never crawled twice in a run */
+                key = g_strdup_printf ("%s/%s", id, g_type_name (node_type));
+                if (!g_hash_table_add (priv->seen, key))
+                        continue;
+
+                gfbgraph_crawler_add_unit_locked (crawler, gfbgraph_crawler_unit_new (node, node_type, NULL, depth));
+        }
+}
+
+static void
+gfbgraph_crawler_worker (GFBGraphCrawlerUnit *unit, GFBGraphCrawler *crawler)
+{
+        GFBGraphCrawlerPrivate *priv;
+        GFBGraphPriority previous;
+        gint64 previous_deadline;
+        GHashTable *next_params = NULL;
+        GPtrArray *nodes;
+        GError *error = NULL;
+        guint i;
+
+        priv = crawler->priv;
+
+        /* A stopped crawl keeps the unit pending for the next run */
+        g_mutex_lock (&priv->mutex);
+        if (priv->stopping) {
+                g_mutex_unlock (&priv->mutex);
+                return;
+        }
+        g_mutex_unlock (&priv->mutex);
+
+        previous = gfbgraph_set_thread_priority (priv->priority);
+        previous_deadline = gfbgraph_set_thread_deadline (priv->deadline);
+        nodes = gfbgraph_node_fetch_connection_page (unit->node, unit->node_type, priv->authorizer,
+                                                     unit->params, &next_params, NULL, &error);
+        gfbgraph_set_thread_deadline (previous_deadline);
+        gfbgraph_set_thread_priority (previous);
+
+        if (nodes == NULL) {
+                g_mutex_lock (&priv->mutex);
+                if (priv->error == NULL)
+                        priv->error = error;
+                else
+                        g_error_free (error);
+                priv->stopping = TRUE;
+                g_cond_broadcast (&priv->cond);
+                g_mutex_unlock (&priv->mutex);
+                return;
+        }
+
+        if (priv->func != NULL) {
+                g_mutex_lock (&priv->func_mutex);
+                for (i = 0; i < nodes->len; i++)
+                        priv->func (crawler, unit->node, g_ptr_array_index (nodes, i), priv->user_data);
+                g_mutex_unlock (&priv->func_mutex);
+        }
+
+        g_mutex_lock (&priv->mutex);
+
+        if (next_params != NULL)
+                gfbgraph_crawler_add_unit_locked (crawler, gfbgraph_crawler_unit_new (unit->node, unit->node_type, next_params, unit->depth));
+
+        for (i = 0; i < nodes->len; i++)
+                gfbgraph_crawler_add_children_locked (crawler, g_ptr_array_index (nodes, i), unit->depth + 1);
+
+        g_hash_table_remove (priv->pending, unit);
+        g_cond_broadcast (&priv->cond);
+
+        g_mutex_unlock (&priv->mutex);
+
+        g_ptr_array_unref (nodes);
+}
+
+static void
+gfbgraph_crawler_cancelled_cb (GCancellable *cancellable, GFBGraphCrawler *crawler)
+{
+        g_mutex_lock (&crawler->priv->mutex);
+        crawler->priv->stopping = TRUE;
+        g_cond_broadcast (&crawler->priv->cond);
+        g_mutex_unlock (&crawler->priv->mutex);
+}
+
+/**
+ * gfbgraph_crawler_new:
+ * @root: a #GFBGraphNode where the crawl starts.
+ *
+ * Creates a crawler of the connections of @root. Add the node types to follow
+ * with gfbgraph_crawler_add_type().
+ *
+ * Returns: (transfer full): a new #GFBGraphCrawler.
+ **/
+GFBGraphCrawler*
+gfbgraph_crawler_new (GFBGraphNode *root)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (root), NULL);
+
+        return GFBGRAPH_CRAWLER (g_object_new (GFBGRAPH_TYPE_CRAWLER, "root", root, NULL));
+}
+
+/**
+ * gfbgraph_crawler_add_type:
+ * @crawler: a #GFBGraphCrawler.
+ * @node_type: a #GFBGraphNode type implementing #GFBGraphConnectable.
+ *
+ * Makes @crawler follow the connections to the @node_type nodes from any crawled node
+ * which has them. For example, adding %GFBGRAPH_TYPE_ALBUM and %GFBGRAPH_TYPE_PHOTO to
+ * a crawler of a user gets the albums of the user and the photos of every album.
+ **/
+void
+gfbgraph_crawler_add_type (GFBGraphCrawler *crawler, GType node_type)
+{
+        g_return_if_fail (GFBGRAPH_IS_CRAWLER (crawler));
+        g_return_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE));
+        g_return_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_CONNECTABLE));
+
+        g_array_append_val (crawler->priv->types, node_type);
+}
+
+/**
+ * gfbgraph_crawler_run:
+ * @crawler: a #GFBGraphCrawler.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @func: (scope call) (allow-none): a #GFBGraphCrawlerFunc receiving the nodes found, or %NULL.
+ * @user_data: (closure): the data to pass to @func.
+ * @cancellable: (allow-none): An optional #GCancellable object, or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Crawls the connections, blocking until all of them are done, a request fails or
+ * @cancellable is cancelled. In the last two cases the pending work is kept, and the
+ * next call continues from there. Otherwise the next call crawls again from the root.
+ *
+ * The requests have the priority and the deadline of the calling thread, see
+ * gfbgraph_set_thread_priority() and gfbgraph_set_thread_deadline().
+ *
+ * Returns: %TRUE if the crawl finished, %FALSE otherwise.
+ **/
+gboolean
+gfbgraph_crawler_run (GFBGraphCrawler *crawler, GFBGraphAuthorizer *authorizer, GFBGraphCrawlerFunc func, gpointer user_data, GCancellable *cancellable, GError **error)
+{
+        GFBGraphCrawlerPrivate *priv;
+        GHashTableIter iter;
+        GThreadPool *pool;
+        gpointer unit;
+        gulong cancelled_id = 0;
+
+        g_return_val_if_fail (GFBGRAPH_IS_CRAWLER (crawler), FALSE);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), FALSE);
+        g_return_val_if_fail (crawler->priv->pool == NULL, FALSE);
+
+        priv = crawler->priv;
+
+        pool = g_thread_pool_new ((GFunc) gfbgraph_crawler_worker, crawler, priv->max_concurrency, FALSE, error);
+        if (pool == NULL)
+                return FALSE;
+        g_thread_pool_set_sort_function (pool, gfbgraph_crawler_unit_compare, NULL);
+
+        priv->authorizer = authorizer;
+        priv->priority = gfbgraph_get_thread_priority ();
+        priv->deadline = gfbgraph_get_thread_deadline ();
+        priv->func = func;
+        priv->user_data = user_data;
+
+        g_mutex_lock (&priv->mutex);
+
+        priv->pool = pool;
+        priv->stopping = FALSE;
+
+        if (g_hash_table_size (priv->pending) == 0) {
+                g_hash_table_remove_all (priv->seen);
+                gfbgraph_crawler_add_children_locked (crawler, priv->root, 0);
+        } else {
+                g_hash_table_iter_init (&iter, priv->pending);
+                while (g_hash_table_iter_next (&iter, &unit, NULL))
+                        g_thread_pool_push (pool, unit, NULL);
+        }
+
+        g_mutex_unlock (&priv->mutex);
+
+        if (cancellable != NULL)
+                cancelled_id = g_cancellable_connect (cancellable, G_CALLBACK (gfbgraph_crawler_cancelled_cb), crawler, NULL);
+
+        g_mutex_lock (&priv->mutex);
+        while (g_hash_table_size (priv->pending) > 0 && !priv->stopping)
+                g_cond_wait (&priv->cond, &priv->mutex);
+        priv->stopping = TRUE;
+        g_mutex_unlock (&priv->mutex);
+
+        /* Waits for the units in progress, the queued ones stay pending */
+        g_thread_pool_free (pool, TRUE, TRUE);
+        priv->pool = NULL;
+
+        if (cancellable != NULL)
+                g_cancellable_disconnect (cancellable, cancelled_id);
+
+        priv->authorizer = NULL;
+        priv->func = NULL;
+        priv->user_data = NULL;
+
+        if (priv->error != NULL) {
+                g_propagate_error (error, priv->error);
+                priv->error = NULL;
+                return FALSE;
+        }
+
+        if (g_cancellable_set_error_if_cancelled (cancellable, error))
+                return FALSE;
+
+        return TRUE;
+}
+
+/**
+ * gfbgraph_crawler_save_checkpoint:
+ * @crawler: a #GFBGraphCrawler.
+ *
+ * Saves the work pending after an interrupted gfbgraph_crawler_run(), so the crawl
+ * can continue in another session with gfbgraph_crawler_load_checkpoint(). It must
+ * not be called while the crawler is running.
+ *
+ * Returns: (transfer full): a floating #GVariant with the pending work.
+ **/
+GVariant*
+gfbgraph_crawler_save_checkpoint (GFBGraphCrawler *crawler)
+{
+        GVariantBuilder builder;
+        GHashTableIter iter;
+        gpointer key;
+
+        g_return_val_if_fail (GFBGRAPH_IS_CRAWLER (crawler), NULL);
+        g_return_val_if_fail (crawler->priv->pool == NULL, NULL);
+
+        g_variant_builder_init (&builder, G_VARIANT_TYPE (CRAWLER_CHECKPOINT_FORMAT));
+
+        g_hash_table_iter_init (&iter, crawler->priv->pending);
+        while (g_hash_table_iter_next (&iter, &key, NULL)) {
+                GFBGraphCrawlerUnit *unit = key;
+                GVariantBuilder params_builder;
+
+                g_variant_builder_init (&params_builder, G_VARIANT_TYPE ("a{ss}"));
+                if (unit->params != NULL) {
+                        GHashTableIter params_iter;
+                        gpointer name, value;
+
+                        g_hash_table_iter_init (&params_iter, unit->params);
+                        while (g_hash_table_iter_next (&params_iter, &name, &value))
+                                g_variant_builder_add (&params_builder, "{ss}", name, value);
+                }
+
+                g_variant_builder_add (&builder, "(sssa{ss}u)",
+                                       G_OBJECT_TYPE_NAME (unit->node),
+                                       gfbgraph_node_get_id (unit->node),
+                                       g_type_name (unit->node_type),
+                                       &params_builder,
+                                       unit->depth);
+        }
+
+        return g_variant_builder_end (&builder);
+}
+
+/**
+ * gfbgraph_crawler_load_checkpoint:
+ * @crawler: a #GFBGraphCrawler.
+ * @checkpoint: a #GVariant returned by gfbgraph_crawler_save_checkpoint().
+ *
+ * Restores the pending work of a crawl, replacing the current one, so the next
+ * gfbgraph_crawler_run() continues it.
+ *
+ * Returns: %TRUE if @checkpoint was loaded, %FALSE if it isn't a valid checkpoint.
+ **/
+gboolean
+gfbgraph_crawler_load_checkpoint (GFBGraphCrawler *crawler, GVariant *checkpoint)
+{
+        GFBGraphCrawlerPrivate *priv;
+        GPtrArray *units;
+        GVariantIter iter;
+        GVariantIter *params_iter;
+        const gchar *node_type_name;
+        const gchar *id;
+        const gchar *connection_type_name;
+        guint depth;
+        guint i;
+
+        g_return_val_if_fail (GFBGRAPH_IS_CRAWLER (crawler), FALSE);
+        g_return_val_if_fail (crawler->priv->pool == NULL, FALSE);
+        g_return_val_if_fail (checkpoint != NULL, FALSE);
+
+        if (g_variant_is_of_type (checkpoint, G_VARIANT_TYPE (CRAWLER_CHECKPOINT_FORMAT)) == FALSE)
+                return FALSE;
+
+        priv = crawler->priv;
+
+        units = g_ptr_array_new_with_free_func ((GDestroyNotify) gfbgraph_crawler_unit_free);
+
+        g_variant_iter_init (&iter, checkpoint);
+        while (g_variant_iter_next (&iter, "(&s&s&sa{ss}u)", &node_type_name, &id, &connection_type_name, &params_iter, &depth)) {
+                GFBGraphNode *node;
+                GHashTable *params = NULL;
+                GType node_type;
+                GType connection_type;
+                const gchar *name;
+                const gchar *value;
+
+                node_type = gfbgraph_node_type_from_name (node_type_name);
+                connection_type = gfbgraph_node_type_from_name (connection_type_name);
+                if (node_type == G_TYPE_INVALID
+                    || connection_type == G_TYPE_INVALID
+                    || !g_type_is_a (connection_type, GFBGRAPH_TYPE_CONNECTABLE)) {
+                        g_variant_iter_free (params_iter);
+                        g_ptr_array_unref (units);
+                        return FALSE;
+                }
+
+                if (g_variant_iter_n_children (params_iter) > 0) {
+                        params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+                        while (g_variant_iter_next (params_iter, "{&s&s}", &name, &value))
+                                g_hash_table_insert (params, g_strdup (name), g_strdup (value));
+                }
+                g_variant_iter_free (params_iter);
+
+                node = GFBGRAPH_NODE (g_object_new (node_type, NULL));
+                gfbgraph_node_set_id (node, id);
+                g_ptr_array_add (units, gfbgraph_crawler_unit_new (node, connection_type, params, depth));
+                g_object_unref (node);
+        }
+
+        g_hash_table_remove_all (priv->pending);
+        g_hash_table_remove_all (priv->seen);
+        for (i = 0; i < units->len; i++)
+                g_hash_table_add (priv->pending, g_ptr_array_index (units, i));
+
+        /* The hash table owns the units now */
+        g_ptr_array_set_free_func (units, NULL);
+        g_ptr_array_unref (units);
+
+        return TRUE;
+}
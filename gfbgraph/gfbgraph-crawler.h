@@ -0,0 +1,81 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_CRAWLER_H__
+#define __GFBGRAPH_CRAWLER_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gfbgraph/gfbgraph-authorizer.h>
+#include <gfbgraph/gfbgraph-node.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_CRAWLER             (gfbgraph_crawler_get_type())
+#define GFBGRAPH_CRAWLER(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GFBGRAPH_TYPE_CRAWLER,GFBGraphCrawler))
+#define GFBGRAPH_CRAWLER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass),GFBGRAPH_TYPE_CRAWLER,GFBGraphCrawlerClass))
+#define GFBGRAPH_IS_CRAWLER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj),GFBGRAPH_TYPE_CRAWLER))
+#define GFBGRAPH_IS_CRAWLER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass),GFBGRAPH_TYPE_CRAWLER))
+#define GFBGRAPH_CRAWLER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj),GFBGRAPH_TYPE_CRAWLER,GFBGraphCrawlerClass))
+
+typedef struct _GFBGraphCrawler        GFBGraphCrawler;
+typedef struct _GFBGraphCrawlerClass   GFBGraphCrawlerClass;
+typedef struct _GFBGraphCrawlerPrivate GFBGraphCrawlerPrivate;
+
+struct _GFBGraphCrawler {
+        GObject parent;
+
+        /*< private >*/
+        GFBGraphCrawlerPrivate *priv;
+};
+
+struct _GFBGraphCrawlerClass {
+        GObjectClass parent_class;
+};
+
+/**
+ * GFBGraphCrawlerFunc:
+ * @crawler: the #GFBGraphCrawler.
+ * @parent: the node @node is connected to.
+ * @node: a node found by @crawler.
+ * @user_data: the data given to gfbgraph_crawler_run().
+ *
+ * Receives each node found by gfbgraph_crawler_run(). It's called from the crawler
+ * threads, but never concurrently. Take a reference on @node to keep it.
+ **/
+typedef void (*GFBGraphCrawlerFunc) (GFBGraphCrawler *crawler, GFBGraphNode *parent, GFBGraphNode *node, gpointer user_data);
+
+GType            gfbgraph_crawler_get_type (void) G_GNUC_CONST;
+GFBGraphCrawler* gfbgraph_crawler_new      (GFBGraphNode *root);
+
+void             gfbgraph_crawler_add_type (GFBGraphCrawler *crawler, GType node_type);
+
+gboolean         gfbgraph_crawler_run      (GFBGraphCrawler     *crawler,
+                                            GFBGraphAuthorizer  *authorizer,
+                                            GFBGraphCrawlerFunc  func,
+                                            gpointer             user_data,
+                                            GCancellable        *cancellable,
+                                            GError             **error);
+
+GVariant*        gfbgraph_crawler_save_checkpoint (GFBGraphCrawler *crawler);
+gboolean         gfbgraph_crawler_load_checkpoint (GFBGraphCrawler *crawler, GVariant *checkpoint);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_CRAWLER_H__ */
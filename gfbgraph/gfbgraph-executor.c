@@ -0,0 +1,251 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The worker threads of the asynchronous functions. Instead of the GIO thread
+ * pool, shared with every other user in the process, the jobs run in a pool
+ * owned by the library, sized with gfbgraph_set_executor_limits(). The jobs
+ * wait in one queue per priority class, and are handed to the pool only when
+ * a thread is free and their class is under its limit, so a thread never
+ * blocks waiting for its turn. A job carries the priority and the deadline of
+ * the thread which started it. */
+
+#include "gfbgraph-request.h"
+#include "gfbgraph-private.h"
+
+#define EXECUTOR_DEFAULT_MAX_THREADS 8
+
+typedef struct {
+        GSimpleAsyncResult *simple_async;
+        GSimpleAsyncThreadFunc func;
+        GCancellable *cancellable;
+        GFBGraphPriority priority;
+        gint64 deadline;
+        gint64 queued_time;
+} GFBGraphExecutorJob;
+
+static GMutex       executor_mutex;
+static GThreadPool *executor_pool;
+static guint        executor_max_threads = EXECUTOR_DEFAULT_MAX_THREADS;
+static guint        executor_max_queued;
+static guint        executor_limit[GFBGRAPH_N_PRIORITIES];
+static GQueue       executor_queue[GFBGRAPH_N_PRIORITIES];
+static guint        executor_running[GFBGRAPH_N_PRIORITIES];
+static guint        executor_dispatched;
+static GFBGraphExecutorStats executor_stats;
+
+static void gfbgraph_executor_dispatch_locked (void);
+
+static void
+gfbgraph_executor_job_free (GFBGraphExecutorJob *job)
+{
+        g_object_unref (job->simple_async);
+        if (job->cancellable)
+                g_object_unref (job->cancellable);
+
+        g_slice_free (GFBGraphExecutorJob, job);
+}
+
+static void
+gfbgraph_executor_thread (gpointer data, gpointer user_data)
+{
+        GFBGraphExecutorJob *job = data;
+        GFBGraphPriority previous;
+        GError *error = NULL;
+        gint64 start_time;
+        gint64 wait_time;
+
+        start_time = g_get_monotonic_time ();
+        wait_time = start_time - job->queued_time;
+
+        g_mutex_lock (&executor_mutex);
+        executor_stats.total_wait_time += wait_time;
+        executor_stats.max_wait_time = MAX (executor_stats.max_wait_time, wait_time);
+        g_mutex_unlock (&executor_mutex);
+
+        if (g_cancellable_set_error_if_cancelled (job->cancellable, &error)) {
+                g_simple_async_result_take_error (job->simple_async, error);
+        } else if (job->deadline > 0 && start_time >= job->deadline) {
+                /* It waited too long to be worth starting */
+                g_simple_async_result_set_error (job->simple_async, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                                                 "The operation missed its deadline");
+        } else {
+                GObject *source_object;
+                gint64 previous_deadline;
+
+                source_object = g_async_result_get_source_object (G_ASYNC_RESULT (job->simple_async));
+
+                previous = gfbgraph_set_thread_priority (job->priority);
+                previous_deadline = gfbgraph_set_thread_deadline (job->deadline);
+                job->func (job->simple_async, source_object, job->cancellable);
+                gfbgraph_set_thread_deadline (previous_deadline);
+                gfbgraph_set_thread_priority (previous);
+
+                if (source_object)
+                        g_object_unref (source_object);
+        }
+
+        g_simple_async_result_complete_in_idle (job->simple_async);
+
+        g_mutex_lock (&executor_mutex);
+        executor_running[job->priority]--;
+        executor_dispatched--;
+        executor_stats.completed++;
+        gfbgraph_executor_dispatch_locked ();
+        g_mutex_unlock (&executor_mutex);
+
+        gfbgraph_executor_job_free (job);
+}
+
+/* Hands the queued jobs to the pool, the most urgent first, while there are
+ * free threads and their class is under its limit */
+static void
+gfbgraph_executor_dispatch_locked (void)
+{
+        GFBGraphPriority priority;
+
+        if (executor_pool == NULL)
+                executor_pool = g_thread_pool_new (gfbgraph_executor_thread, NULL, executor_max_threads, FALSE, NULL);
+
+        for (priority = 0; priority < GFBGRAPH_N_PRIORITIES; priority++) {
+                while (executor_dispatched < executor_max_threads
+                       && !g_queue_is_empty (&executor_queue[priority])
+                       && (executor_limit[priority] == 0 || executor_running[priority] < executor_limit[priority])) {
+                        GFBGraphExecutorJob *job;
+
+                        job = g_queue_pop_head (&executor_queue[priority]);
+                        executor_running[priority]++;
+                        executor_dispatched++;
+                        g_thread_pool_push (executor_pool, job, NULL);
+                }
+        }
+}
+
+/* Like g_simple_async_result_run_in_thread(), but the job runs in the library
+ * pool, with the priority and the deadline of the calling thread */
+void
+gfbgraph_simple_async_run_in_thread (GSimpleAsyncResult *simple_async, GSimpleAsyncThreadFunc func, GCancellable *cancellable)
+{
+        GFBGraphExecutorJob *job;
+        guint queued;
+        guint i;
+
+        job = g_slice_new (GFBGraphExecutorJob);
+        job->simple_async = g_object_ref (simple_async);
+        job->func = func;
+        job->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+        job->priority = gfbgraph_get_thread_priority ();
+        job->deadline = gfbgraph_get_thread_deadline ();
+        job->queued_time = g_get_monotonic_time ();
+
+        g_mutex_lock (&executor_mutex);
+
+        queued = 0;
+        for (i = 0; i < GFBGRAPH_N_PRIORITIES; i++)
+                queued += g_queue_get_length (&executor_queue[i]);
+
+        if (executor_max_queued > 0 && queued >= executor_max_queued) {
+                executor_stats.rejected++;
+                g_mutex_unlock (&executor_mutex);
+
+                g_simple_async_result_set_error (simple_async, G_IO_ERROR, G_IO_ERROR_BUSY,
+                                                 "Too many operations waiting to run");
+                g_simple_async_result_complete_in_idle (simple_async);
+                gfbgraph_executor_job_free (job);
+                return;
+        }
+
+        g_queue_push_tail (&executor_queue[job->priority], job);
+        gfbgraph_executor_dispatch_locked ();
+
+        g_mutex_unlock (&executor_mutex);
+}
+
+/**
+ * gfbgraph_set_executor_limits:
+ * @max_threads: the maximum number of worker threads, greater than 0.
+ * @max_queued: the maximum number of operations waiting for a thread, or 0 for no limit.
+ *
+ * Sizes the thread pool where the asynchronous functions of the library run, which
+ * isn't shared with the rest of the process. By default it has 8 threads and no limit
+ * of waiting operations. The operations started when @max_queued are already waiting
+ * fail with %G_IO_ERROR_BUSY.
+ **/
+void
+gfbgraph_set_executor_limits (guint max_threads, guint max_queued)
+{
+        g_return_if_fail (max_threads > 0);
+
+        g_mutex_lock (&executor_mutex);
+
+        executor_max_threads = max_threads;
+        executor_max_queued = max_queued;
+        if (executor_pool != NULL)
+                g_thread_pool_set_max_threads (executor_pool, max_threads, NULL);
+
+        gfbgraph_executor_dispatch_locked ();
+
+        g_mutex_unlock (&executor_mutex);
+}
+
+/**
+ * gfbgraph_set_executor_priority_limit:
+ * @priority: a #GFBGraphPriority.
+ * @max_threads: the maximum threads running operations of @priority, or 0 for no limit.
+ *
+ * Limits how many threads of the pool of the asynchronous functions can be taken by
+ * the operations of the @priority class, so the rest stay available for the others.
+ * The operations of higher classes are always started first. There are no limits by
+ * default.
+ **/
+void
+gfbgraph_set_executor_priority_limit (GFBGraphPriority priority, guint max_threads)
+{
+        g_return_if_fail (priority < GFBGRAPH_N_PRIORITIES);
+
+        g_mutex_lock (&executor_mutex);
+
+        executor_limit[priority] = max_threads;
+        gfbgraph_executor_dispatch_locked ();
+
+        g_mutex_unlock (&executor_mutex);
+}
+
+/**
+ * gfbgraph_get_executor_stats:
+ * @stats: (out caller-allocates): a #GFBGraphExecutorStats to fill.
+ *
+ * Fills @stats with the current state of the pool of the asynchronous functions.
+ **/
+void
+gfbgraph_get_executor_stats (GFBGraphExecutorStats *stats)
+{
+        guint i;
+
+        g_return_if_fail (stats != NULL);
+
+        g_mutex_lock (&executor_mutex);
+
+        *stats = executor_stats;
+        stats->queued = 0;
+        stats->running = executor_dispatched;
+        for (i = 0; i < GFBGRAPH_N_PRIORITIES; i++)
+                stats->queued += g_queue_get_length (&executor_queue[i]);
+
+        g_mutex_unlock (&executor_mutex);
+}
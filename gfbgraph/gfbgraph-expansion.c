@@ -0,0 +1,283 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-expansion
+ * @short_description: Nested connections fetched in one request
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * A #GFBGraphExpansion describes a node and the connections to retrieve along with it,
+ * which can be nested, like the albums of a user with the photos of every album. It's
+ * turned into a single Graph API field expansion, like
+ * "name,albums.limit(50){name,count,photos.limit(100){images,source}}", so the whole
+ * tree comes in one request instead of one per node.
+ *
+ * |[
+ * GFBGraphExpansion *expansion, *albums;
+ * GFBGraphNode *me;
+ *
+ * expansion = gfbgraph_expansion_new (GFBGRAPH_TYPE_USER, "name");
+ * albums = gfbgraph_expansion_add_connection (expansion, GFBGRAPH_TYPE_ALBUM, 50, "name,count");
+ * gfbgraph_expansion_add_connection (albums, GFBGRAPH_TYPE_PHOTO, 100, "images,source");
+ *
+ * me = gfbgraph_node_new_from_id_expanded (authorizer, "me", expansion, &error);
+ * ]|
+ *
+ * The connected nodes are then available with gfbgraph_node_get_expanded_nodes(). Only
+ * the first page of every connection is retrieved, up to its limit.
+ **/
+
+#include "gfbgraph-expansion.h"
+#include "gfbgraph-connectable.h"
+#include "gfbgraph-private.h"
+
+struct _GFBGraphExpansion {
+        volatile gint ref_count;
+
+        GType node_type;
+        gchar *path;
+        gchar *fields;
+        guint limit;
+        GPtrArray *children;
+};
+
+G_DEFINE_BOXED_TYPE (GFBGraphExpansion, gfbgraph_expansion, gfbgraph_expansion_ref, gfbgraph_expansion_unref)
+
+static GFBGraphExpansion*
+gfbgraph_expansion_alloc (GType node_type, const gchar *path, guint limit, const gchar *fields)
+{
+        GFBGraphExpansion *expansion;
+
+        expansion = g_slice_new0 (GFBGraphExpansion);
+        expansion->ref_count = 1;
+        expansion->node_type = node_type;
+        expansion->path = g_strdup (path);
+        expansion->limit = limit;
+        expansion->fields = g_strdup (fields);
+        expansion->children = g_ptr_array_new_with_free_func ((GDestroyNotify) gfbgraph_expansion_unref);
+
+        return expansion;
+}
+
+/**
+ * gfbgraph_expansion_new:
+ * @node_type: the #GFBGraphNode type of the requested node.
+ * @fields: (allow-none): the comma separated fields of the node to retrieve, or %NULL for only its ID.
+ *
+ * Creates the expansion of a node of type @node_type. Add the connections to retrieve
+ * with it with gfbgraph_expansion_add_connection().
+ *
+ * Returns: (transfer full): a new #GFBGraphExpansion. Free it with gfbgraph_expansion_unref().
+ **/
+GFBGraphExpansion*
+gfbgraph_expansion_new (GType node_type, const gchar *fields)
+{
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+
+        return gfbgraph_expansion_alloc (node_type, NULL, 0, fields);
+}
+
+/**
+ * gfbgraph_expansion_ref:
+ * @expansion: a #GFBGraphExpansion.
+ *
+ * Returns: (transfer full): @expansion with its reference count increased.
+ **/
+GFBGraphExpansion*
+gfbgraph_expansion_ref (GFBGraphExpansion *expansion)
+{
+        g_return_val_if_fail (expansion != NULL, NULL);
+
+        g_atomic_int_inc (&expansion->ref_count);
+
+        return expansion;
+}
+
+/**
+ * gfbgraph_expansion_unref:
+ * @expansion: a #GFBGraphExpansion.
+ *
+ * Decreases the reference count of @expansion, freeing it when it reaches zero.
+ **/
+void
+gfbgraph_expansion_unref (GFBGraphExpansion *expansion)
+{
+        g_return_if_fail (expansion != NULL);
+
+        if (!g_atomic_int_dec_and_test (&expansion->ref_count))
+                return;
+
+        g_free (expansion->path);
+        g_free (expansion->fields);
+        g_ptr_array_unref (expansion->children);
+
+        g_slice_free (GFBGraphExpansion, expansion);
+}
+
+/**
+ * gfbgraph_expansion_add_connection:
+ * @expansion: a #GFBGraphExpansion.
+ * @node_type: a #GFBGraphNode type implementing #GFBGraphConnectable, which must be
+ *  connectable to the nodes of @expansion.
+ * @limit: the maximum number of connected nodes to retrieve, or 0 for the default of the Graph API.
+ * @fields: (allow-none): the comma separated fields of the connected nodes, or %NULL for the default ones.
+ *
+ * Adds to @expansion the connection to the @node_type nodes. The returned expansion
+ * can be used to add connections of the connected nodes.
+ *
+ * Returns: (transfer none): the #GFBGraphExpansion of the connected nodes, owned by @expansion.
+ **/
+GFBGraphExpansion*
+gfbgraph_expansion_add_connection (GFBGraphExpansion *expansion, GType node_type, guint limit, const gchar *fields)
+{
+        GFBGraphExpansion *child;
+        const gchar *path;
+
+        g_return_val_if_fail (expansion != NULL, NULL);
+        g_return_val_if_fail (gfbgraph_connectable_type_is_connectable_to (node_type, expansion->node_type), NULL);
+
+        path = gfbgraph_connectable_type_get_connection_path (node_type, expansion->node_type);
+
+        child = gfbgraph_expansion_alloc (node_type, path, limit, fields);
+        g_ptr_array_add (expansion->children, child);
+
+        return child;
+}
+
+/**
+ * gfbgraph_expansion_get_node_type:
+ * @expansion: a #GFBGraphExpansion.
+ *
+ * Returns: the #GFBGraphNode type of the nodes of @expansion.
+ **/
+GType
+gfbgraph_expansion_get_node_type (GFBGraphExpansion *expansion)
+{
+        g_return_val_if_fail (expansion != NULL, G_TYPE_INVALID);
+
+        return expansion->node_type;
+}
+
+/* Appends the fields of @expansion and its connections, comma separated */
+static void
+gfbgraph_expansion_append_fields (GFBGraphExpansion *expansion, GString *str)
+{
+        gboolean first = TRUE;
+        guint i;
+
+        if (expansion->fields != NULL && expansion->fields[0] != '\0') {
+                g_string_append (str, expansion->fields);
+                first = FALSE;
+        }
+
+        for (i = 0; i < expansion->children->len; i++) {
+                GFBGraphExpansion *child;
+
+                child = g_ptr_array_index (expansion->children, i);
+
+                if (!first)
+                        g_string_append_c (str, ',');
+                first = FALSE;
+
+                g_string_append (str, child->path);
+                if (child->limit > 0)
+                        g_string_append_printf (str, ".limit(%u)", child->limit);
+
+                if ((child->fields != NULL && child->fields[0] != '\0') || child->children->len > 0) {
+                        g_string_append_c (str, '{');
+                        gfbgraph_expansion_append_fields (child, str);
+                        g_string_append_c (str, '}');
+                }
+        }
+}
+
+/**
+ * gfbgraph_expansion_to_string:
+ * @expansion: a #GFBGraphExpansion.
+ *
+ * Builds the value of the "fields" param of the Graph API for @expansion.
+ *
+ * Returns: (transfer full): a new string, free it with g_free().
+ **/
+gchar*
+gfbgraph_expansion_to_string (GFBGraphExpansion *expansion)
+{
+        GString *str;
+
+        g_return_val_if_fail (expansion != NULL, NULL);
+
+        str = g_string_new (NULL);
+        gfbgraph_expansion_append_fields (expansion, str);
+
+        return g_string_free (str, FALSE);
+}
+
+/* Deserializes the connections of @expansion from @json_object, the JSON of
+ * @node, and attaches them to @node. Returns the number of nodes created. */
+guint
+gfbgraph_expansion_apply (GFBGraphExpansion *expansion, GFBGraphNode *node, JsonObject *json_object, GFBGraphArena *arena)
+{
+        guint n_nodes = 0;
+        guint i, j;
+
+        for (i = 0; i < expansion->children->len; i++) {
+                GFBGraphExpansion *child;
+                JsonNode *connection_jnode;
+                JsonObject *connection_jobject;
+                JsonArray *data_jarray;
+                GPtrArray *nodes;
+                guint length;
+
+                child = g_ptr_array_index (expansion->children, i);
+
+                connection_jnode = json_object_get_member (json_object, child->path);
+                if (connection_jnode == NULL || !JSON_NODE_HOLDS_OBJECT (connection_jnode))
+                        continue;
+
+                connection_jobject = json_node_get_object (connection_jnode);
+                if (!json_object_has_member (connection_jobject, "data"))
+                        continue;
+
+                data_jarray = json_object_get_array_member (connection_jobject, "data");
+                if (data_jarray == NULL)
+                        continue;
+
+                length = json_array_get_length (data_jarray);
+                nodes = g_ptr_array_new_full (length, g_object_unref);
+
+                for (j = 0; j < length; j++) {
+                        GFBGraphNode *connected_node;
+                        JsonNode *element;
+
+                        element = json_array_get_element (data_jarray, j);
+                        if (!JSON_NODE_HOLDS_OBJECT (element))
+                                continue;
+
+                        connected_node = gfbgraph_node_deserialize (child->node_type, element, arena);
+                        n_nodes += gfbgraph_expansion_apply (child, connected_node, json_node_get_object (element), arena);
+                        g_ptr_array_add (nodes, connected_node);
+                }
+
+                n_nodes += nodes->len;
+                gfbgraph_node_set_expanded_nodes (node, child->node_type, nodes);
+        }
+
+        return n_nodes;
+}
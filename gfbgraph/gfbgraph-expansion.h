@@ -0,0 +1,46 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_EXPANSION_H__
+#define __GFBGRAPH_EXPANSION_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_EXPANSION (gfbgraph_expansion_get_type ())
+
+typedef struct _GFBGraphExpansion GFBGraphExpansion;
+
+GType              gfbgraph_expansion_get_type       (void) G_GNUC_CONST;
+GFBGraphExpansion* gfbgraph_expansion_new            (GType node_type, const gchar *fields);
+GFBGraphExpansion* gfbgraph_expansion_ref            (GFBGraphExpansion *expansion);
+void               gfbgraph_expansion_unref          (GFBGraphExpansion *expansion);
+
+GFBGraphExpansion* gfbgraph_expansion_add_connection (GFBGraphExpansion *expansion,
+                                                      GType              node_type,
+                                                      guint              limit,
+                                                      const gchar       *fields);
+
+GType              gfbgraph_expansion_get_node_type  (GFBGraphExpansion *expansion);
+gchar*             gfbgraph_expansion_to_string      (GFBGraphExpansion *expansion);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_EXPANSION_H__ */
@@ -0,0 +1,434 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The on-disk cache of the photo images. The files are named after a hash of
+ * the photo ID and the image size, not after the CDN URL, which changes
+ * between sessions. They are written atomically, so a crash never leaves a
+ * truncated image, and the least recently used ones are removed when the cache
+ * grows over its limit. The modification time of the files keeps the usage
+ * order between sessions. Only the files with the names the cache writes are
+ * ever indexed or removed, the others in the directory are left alone. */
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <libsoup/soup.h>
+
+#include "gfbgraph-common.h"
+#include "gfbgraph-private.h"
+
+/* The length of the names, the hex SHA-1 of the key */
+#define CACHE_NAME_LENGTH 40
+
+typedef struct {
+        gchar   *name;
+        guint64  size;
+        gint64   mtime;
+        GList   *link;
+} GFBGraphImageCacheEntry;
+
+static GMutex      cache_mutex;
+static gchar      *cache_dir = NULL;
+static guint64     cache_max_size = 0;
+static guint64     cache_size = 0;
+static GHashTable *cache_entries = NULL;
+/* The most recently used entry first */
+static GQueue      cache_lru = G_QUEUE_INIT;
+
+static void
+gfbgraph_image_cache_entry_free (GFBGraphImageCacheEntry *entry)
+{
+        g_free (entry->name);
+        g_slice_free (GFBGraphImageCacheEntry, entry);
+}
+
+static gint
+gfbgraph_image_cache_entry_compare (gconstpointer a, gconstpointer b)
+{
+        const GFBGraphImageCacheEntry *entry_a = *((GFBGraphImageCacheEntry **) a);
+        const GFBGraphImageCacheEntry *entry_b = *((GFBGraphImageCacheEntry **) b);
+
+        /* Newest first */
+        return (entry_a->mtime < entry_b->mtime) - (entry_a->mtime > entry_b->mtime);
+}
+
+/* Removes all the entries from memory, the files are kept. Called with the lock held. */
+static void
+gfbgraph_image_cache_clear_locked (void)
+{
+        GList *l;
+
+        for (l = cache_lru.head; l != NULL; l = l->next)
+                gfbgraph_image_cache_entry_free (l->data);
+        g_queue_clear (&cache_lru);
+
+        g_clear_pointer (&cache_entries, g_hash_table_unref);
+        g_clear_pointer (&cache_dir, g_free);
+        cache_size = 0;
+}
+
+/* Removes the least recently used files until the cache fits in its limit.
+ * Called with the lock held. */
+static void
+gfbgraph_image_cache_evict_locked (void)
+{
+        while (cache_size > cache_max_size && cache_lru.length > 1) {
+                GFBGraphImageCacheEntry *entry;
+                GList *link;
+                gchar *path;
+
+                link = g_queue_peek_tail_link (&cache_lru);
+                entry = link->data;
+
+                path = g_build_filename (cache_dir, entry->name, NULL);
+                g_unlink (path);
+                g_free (path);
+
+                g_queue_unlink (&cache_lru, link);
+                g_list_free (link);
+                cache_size -= entry->size;
+                g_hash_table_remove (cache_entries, entry->name);
+                gfbgraph_image_cache_entry_free (entry);
+        }
+}
+
+/* Checks if @name is one of the files written by the cache */
+static gboolean
+gfbgraph_image_cache_is_entry_name (const gchar *name)
+{
+        guint i;
+
+        for (i = 0; i < CACHE_NAME_LENGTH; i++) {
+                if (!g_ascii_isxdigit (name[i]) || g_ascii_isupper (name[i]))
+                        return FALSE;
+        }
+
+        return name[CACHE_NAME_LENGTH] == '\0';
+}
+
+/* Loads the index of the files already in @directory. Called with the lock held. */
+static gboolean
+gfbgraph_image_cache_scan_locked (const gchar *directory, GError **error)
+{
+        GPtrArray *found;
+        const gchar *name;
+        GDir *dir;
+        guint i;
+
+        dir = g_dir_open (directory, 0, error);
+        if (dir == NULL)
+                return FALSE;
+
+        found = g_ptr_array_new ();
+        while ((name = g_dir_read_name (dir)) != NULL) {
+                GFBGraphImageCacheEntry *entry;
+                GStatBuf stat_buf;
+                gchar *path;
+
+                /* Only the hashes, not the temporary files of interrupted writes
+                 * nor anything else living in the same directory */
+                if (!gfbgraph_image_cache_is_entry_name (name))
+                        continue;
+
+                path = g_build_filename (directory, name, NULL);
+                if (g_stat (path, &stat_buf) == 0 && S_ISREG (stat_buf.st_mode)) {
+                        entry = g_slice_new0 (GFBGraphImageCacheEntry);
+                        entry->name = g_strdup (name);
+                        entry->size = stat_buf.st_size;
+                        entry->mtime = stat_buf.st_mtime;
+                        g_ptr_array_add (found, entry);
+                }
+                g_free (path);
+        }
+        g_dir_close (dir);
+
+        g_ptr_array_sort (found, gfbgraph_image_cache_entry_compare);
+        for (i = 0; i < found->len; i++) {
+                GFBGraphImageCacheEntry *entry;
+
+                entry = g_ptr_array_index (found, i);
+                entry->link = g_list_alloc ();
+                entry->link->data = entry;
+                g_queue_push_tail_link (&cache_lru, entry->link);
+                g_hash_table_insert (cache_entries, entry->name, entry);
+                cache_size += entry->size;
+        }
+        g_ptr_array_free (found, TRUE);
+
+        return TRUE;
+}
+
+/**
+ * gfbgraph_set_image_cache:
+ * @directory: (allow-none): the directory to keep the images in, or %NULL to disable the cache.
+ * @max_size: the maximum size in bytes of the images kept.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Enables a disk cache for the photo images. When enabled, gfbgraph_photo_download_default_size()
+ * and gfbgraph_photo_download_image() look for the image in the cache before downloading it, and
+ * store the downloaded ones. The images are identified by the photo ID and their size, so they are
+ * found again even when Facebook changes their URL. When the cache grows over @max_size, the least
+ * recently used images are removed. gfbgraph_photo_prefetch() fills the cache in advance.
+ *
+ * The directory is created if it doesn't exist. The cache only removes the files it wrote,
+ * named after a SHA-1 in hexadecimal, the other files in @directory are left alone. The
+ * cache is disabled by default.
+ *
+ * Returns: %TRUE on success, %FALSE if the directory can't be used.
+ **/
+gboolean
+gfbgraph_set_image_cache (const gchar *directory, guint64 max_size, GError **error)
+{
+        gboolean result = TRUE;
+
+        g_mutex_lock (&cache_mutex);
+
+        gfbgraph_image_cache_clear_locked ();
+
+        if (directory != NULL) {
+                if (g_mkdir_with_parents (directory, 0700) != 0) {
+                        gint saved_errno = errno;
+
+                        g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                                     "Can't create the image cache directory %s: %s", directory, g_strerror (saved_errno));
+                        result = FALSE;
+                } else {
+                        cache_entries = g_hash_table_new (g_str_hash, g_str_equal);
+                        cache_max_size = max_size;
+
+                        result = gfbgraph_image_cache_scan_locked (directory, error);
+                        if (result) {
+                                cache_dir = g_strdup (directory);
+                                gfbgraph_image_cache_evict_locked ();
+                        } else {
+                                gfbgraph_image_cache_clear_locked ();
+                        }
+                }
+        }
+
+        g_mutex_unlock (&cache_mutex);
+
+        return result;
+}
+
+static gchar*
+gfbgraph_image_cache_key (const gchar *photo_id, guint width, guint height)
+{
+        gchar *key;
+        gchar *name;
+
+        key = g_strdup_printf ("%s@%ux%u", photo_id, width, height);
+        name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+        g_free (key);
+
+        return name;
+}
+
+/* Returns the path of the cached image @name, marking it as recently used,
+ * or %NULL if it isn't cached */
+static gchar*
+gfbgraph_image_cache_lookup (const gchar *name)
+{
+        GFBGraphImageCacheEntry *entry;
+        gchar *path = NULL;
+
+        g_mutex_lock (&cache_mutex);
+
+        if (cache_entries != NULL) {
+                entry = g_hash_table_lookup (cache_entries, name);
+                if (entry != NULL) {
+                        g_queue_unlink (&cache_lru, entry->link);
+                        g_queue_push_head_link (&cache_lru, entry->link);
+                        path = g_build_filename (cache_dir, entry->name, NULL);
+                }
+        }
+
+        g_mutex_unlock (&cache_mutex);
+
+        /* Keeps the usage order for the next sessions */
+        if (path != NULL)
+                g_utime (path, NULL);
+
+        return path;
+}
+
+static void
+gfbgraph_image_cache_store (const gchar *name, GBytes *bytes)
+{
+        GFBGraphImageCacheEntry *entry;
+        gchar *directory;
+        gchar *path;
+
+        g_mutex_lock (&cache_mutex);
+        directory = g_strdup (cache_dir);
+        g_mutex_unlock (&cache_mutex);
+
+        if (directory == NULL)
+                return;
+
+        /* Written to a temporary file and renamed, so readers never see it half
+         * done. The lock isn't held meanwhile, the other threads can go on. */
+        path = g_build_filename (directory, name, NULL);
+        if (!g_file_set_contents (path, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes), NULL)) {
+                g_free (path);
+                g_free (directory);
+                return;
+        }
+        g_free (path);
+
+        g_mutex_lock (&cache_mutex);
+
+        /* Unless the cache was moved or disabled in the meantime */
+        if (g_strcmp0 (cache_dir, directory) == 0) {
+                entry = g_hash_table_lookup (cache_entries, name);
+                if (entry != NULL) {
+                        cache_size -= entry->size;
+                        g_queue_unlink (&cache_lru, entry->link);
+                } else {
+                        entry = g_slice_new0 (GFBGraphImageCacheEntry);
+                        entry->name = g_strdup (name);
+                        entry->link = g_list_alloc ();
+                        entry->link->data = entry;
+                        g_hash_table_insert (cache_entries, entry->name, entry);
+                }
+
+                entry->size = g_bytes_get_size (bytes);
+                entry->mtime = g_get_real_time () / G_USEC_PER_SEC;
+                g_queue_push_head_link (&cache_lru, entry->link);
+                cache_size += entry->size;
+
+                gfbgraph_image_cache_evict_locked ();
+        }
+
+        g_mutex_unlock (&cache_mutex);
+
+        g_free (directory);
+}
+
+/* Downloads @uri completely and stores it in the cache as @name. An answer
+ * other than a success is an error, so its body is never taken for the image */
+static GBytes*
+gfbgraph_image_cache_fetch (GFBGraphAuthorizer *authorizer, const gchar *uri, const gchar *name, GError **error)
+{
+        GInputStream *stream;
+        GOutputStream *memory;
+        GBytes *bytes = NULL;
+        guint status_code;
+
+        stream = gfbgraph_transfer_download (authorizer, uri, &status_code, error);
+        if (stream == NULL)
+                return NULL;
+
+        if (!SOUP_STATUS_IS_SUCCESSFUL (status_code)) {
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Cannot download %s: HTTP status %u", uri, status_code);
+                g_object_unref (stream);
+                return NULL;
+        }
+
+        memory = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+        if (g_output_stream_splice (memory, stream,
+                                    G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                    NULL, error) >= 0) {
+                bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (memory));
+                gfbgraph_image_cache_store (name, bytes);
+        }
+
+        g_object_unref (memory);
+        g_object_unref (stream);
+
+        return bytes;
+}
+
+/* Opens the image @width x @height of the photo @photo_id from the cache,
+ * or downloads it from @uri if the cache is disabled or doesn't have it */
+GInputStream*
+gfbgraph_image_cache_download (GFBGraphAuthorizer *authorizer, const gchar *photo_id, guint width, guint height, const gchar *uri, GError **error)
+{
+        GInputStream *stream = NULL;
+        GBytes *bytes;
+        gchar *name;
+        gchar *path;
+
+        g_return_val_if_fail (uri != NULL, NULL);
+
+        if (photo_id == NULL || g_atomic_pointer_get (&cache_dir) == NULL)
+                return gfbgraph_transfer_download (authorizer, uri, NULL, error);
+
+        name = gfbgraph_image_cache_key (photo_id, width, height);
+
+        path = gfbgraph_image_cache_lookup (name);
+        if (path != NULL) {
+                GFile *file;
+
+                /* It could have been evicted in the meantime */
+                file = g_file_new_for_path (path);
+                stream = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
+                g_object_unref (file);
+                g_free (path);
+
+                if (stream != NULL)
+                        gfbgraph_counter_add (GFBGRAPH_COUNTER_CACHE_HITS, 1);
+        }
+
+        if (stream == NULL) {
+                bytes = gfbgraph_image_cache_fetch (authorizer, uri, name, error);
+                if (bytes != NULL) {
+                        stream = g_memory_input_stream_new_from_bytes (bytes);
+                        g_bytes_unref (bytes);
+                }
+        }
+
+        g_free (name);
+
+        return stream;
+}
+
+/* Stores the image @width x @height of the photo @photo_id in the cache,
+ * unless it's there already */
+gboolean
+gfbgraph_image_cache_prefetch (GFBGraphAuthorizer *authorizer, const gchar *photo_id, guint width, guint height, const gchar *uri, GError **error)
+{
+        GBytes *bytes;
+        gchar *name;
+        gchar *path;
+
+        g_return_val_if_fail (photo_id != NULL, FALSE);
+        g_return_val_if_fail (uri != NULL, FALSE);
+
+        if (g_atomic_pointer_get (&cache_dir) == NULL)
+                return TRUE;
+
+        name = gfbgraph_image_cache_key (photo_id, width, height);
+
+        path = gfbgraph_image_cache_lookup (name);
+        if (path != NULL) {
+                g_free (path);
+                g_free (name);
+                return TRUE;
+        }
+
+        bytes = gfbgraph_image_cache_fetch (authorizer, uri, name, error);
+        g_free (name);
+
+        if (bytes == NULL)
+                return FALSE;
+
+        g_bytes_unref (bytes);
+
+        return TRUE;
+}
@@ -33,11 +33,13 @@
 
 #include <rest/rest-proxy-call.h>
 #include <json-glib/json-glib.h>
+#include <libsoup/soup.h>
 #include <string.h>
 
 #include "gfbgraph-common.h"
 #include "gfbgraph-connectable.h"
 #include "gfbgraph-node.h"
+#include "gfbgraph-private.h"
 
 enum
 {
@@ -50,7 +52,14 @@ enum
 };
 
 struct _GFBGraphNodePrivate {
-        GList *connections;
+        GFBGraphArena *arena;
+        /* In lazy mode, the members not decoded yet */
+        JsonObject *pending;
+        gboolean materializing;
+        /* Set by gfbgraph_node_freeze(), the fields can't change after it */
+        volatile gint frozen;
+        /* Connected nodes retrieved with a field expansion, by node type */
+        GHashTable *expanded;
         gchar *id;
         gchar *link;
         gchar *created_time;
@@ -58,11 +67,29 @@ struct _GFBGraphNodePrivate {
 };
 
 typedef struct {
-        GList *list;
+        GPtrArray *array;
         GType node_type;
         GFBGraphAuthorizer *authorizer;
 } GFBGraphNodeConnectionAsyncData;
 
+typedef struct {
+        GFBGraphAuthorizer *authorizer;
+        const gchar *id;
+        GType node_type;
+        GFBGraphExpansion *expansion;
+} GFBGraphNodeRequest;
+
+typedef struct {
+        RestProxyCall *rest_call;
+} GFBGraphNodePageRequest;
+
+typedef struct {
+        GFBGraphNode *node;
+        /* Members not consumed by the node class, left for the properties */
+        JsonObject *unknown;
+        gboolean skip_id;
+} GFBGraphNodeDeserializeData;
+
 GQuark
 gfbgraph_node_error_quark (void)
 {
@@ -71,10 +98,20 @@ gfbgraph_node_error_quark (void)
 
 static void gfbgraph_node_init         (GFBGraphNode *obj);
 static void gfbgraph_node_class_init   (GFBGraphNodeClass *klass);
+static void gfbgraph_node_constructed  (GObject *object);
 static void gfbgraph_node_finalize     (GObject *object);
 static void gfbgraph_node_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
 static void gfbgraph_node_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
 
+static gboolean gfbgraph_node_real_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node);
+static void     gfbgraph_node_deserialize_member_cb   (JsonObject *json_object, const gchar *member_name, JsonNode *member_node, gpointer user_data);
+static void     gfbgraph_node_deserialize_properties  (GFBGraphNode *node, JsonObject *members);
+static void     gfbgraph_node_deserialize_members     (GFBGraphNode *node, JsonObject *json_object, gboolean skip_id);
+
+static void gfbgraph_node_real_serialize_members (GFBGraphNode *node, JsonBuilder *builder);
+static gchar*        gfbgraph_node_request_payload (GFBGraphNodeRequest *request, GError **error);
+static GFBGraphNode* gfbgraph_node_request_by_id   (GFBGraphNodeRequest *request, const gchar *key, GError **error);
+
 static void gfbgraph_node_connection_async_data_free (GFBGraphNodeConnectionAsyncData *data);
 static void gfbgraph_node_get_connection_nodes_async_thread (GSimpleAsyncResult *simple_async, GFBGraphNode *node, GCancellable cancellable);
 
@@ -82,6 +119,9 @@ static void gfbgraph_node_get_connection_nodes_async_thread (GSimpleAsyncResult
 
 static GObjectClass *parent_class = NULL;
 
+/* Shared by all the nodes, it's only taken the first time a lazy node is accessed */
+static GRecMutex materialize_mutex;
+
 G_DEFINE_TYPE (GFBGraphNode, gfbgraph_node, G_TYPE_OBJECT);
 
 static void
@@ -91,10 +131,14 @@ gfbgraph_node_class_init (GFBGraphNodeClass *klass)
 
         parent_class            = g_type_class_peek_parent (klass);
 
+        gobject_class->constructed = gfbgraph_node_constructed;
         gobject_class->finalize = gfbgraph_node_finalize;
         gobject_class->set_property = gfbgraph_node_set_property;
         gobject_class->get_property = gfbgraph_node_get_property;
 
+        klass->deserialize_member = gfbgraph_node_real_deserialize_member;
+        klass->serialize_members = gfbgraph_node_real_serialize_members;
+
         g_type_class_add_private (gobject_class, sizeof(GFBGraphNodePrivate));
 
         /**
@@ -152,6 +196,16 @@ gfbgraph_node_init (GFBGraphNode *obj)
         obj->priv = GFBGRAPH_NODE_GET_PRIVATE(obj);
 }
 
+static void
+gfbgraph_node_constructed (GObject *object)
+{
+        /* Not in the instance init, where the type is still the one of the class being initialized */
+        gfbgraph_stats_node_alive (G_OBJECT_TYPE (object), 1);
+
+        if (G_OBJECT_CLASS (parent_class)->constructed)
+                G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
 static void
 gfbgraph_node_finalize (GObject *object)
 {
@@ -159,12 +213,22 @@ gfbgraph_node_finalize (GObject *object)
 
         priv = GFBGRAPH_NODE_GET_PRIVATE (object);
 
-        if (priv->id)
-                g_free (priv->id);
-        if (priv->link)
-                g_free (priv->link);
-        if (priv->created_time)
-                g_free (priv->created_time);
+        gfbgraph_stats_node_alive (G_OBJECT_TYPE (object), -1);
+
+        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->id);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->link);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->created_time);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->updated_time);
+
+        if (priv->pending)
+                json_object_unref (priv->pending);
+
+        if (priv->expanded)
+                g_hash_table_unref (priv->expanded);
+
+        /* Subclasses already released their strings, so the page strings can go now */
+        if (priv->arena)
+                gfbgraph_arena_unref (priv->arena);
 
         G_OBJECT_CLASS(parent_class)->finalize (object);
 }
@@ -176,26 +240,26 @@ gfbgraph_node_set_property (GObject *object, guint prop_id, const GValue *value,
 
         priv = GFBGRAPH_NODE_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+        if (!gfbgraph_node_check_writable (GFBGRAPH_NODE (object)))
+                return;
+
         switch (prop_id) {
                 case PROP_ID:
-                        if (priv->id)
-                                g_free (priv->id);
-                        priv->id = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->id);
+                        priv->id = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_LINK:
-                        if (priv->link)
-                                g_free (priv->link);
-                        priv->link = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->link);
+                        priv->link = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_CREATEDTIME:
-                        if (priv->created_time)
-                                g_free (priv->created_time);
-                        priv->created_time = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->created_time);
+                        priv->created_time = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_UPDATEDTIME:
-                        if (priv->updated_time)
-                                g_free (priv->updated_time);
-                        priv->updated_time = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->updated_time);
+                        priv->updated_time = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 default:
                         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -210,6 +274,8 @@ gfbgraph_node_get_property (GObject *object, guint prop_id, GValue *value, GPara
 
         priv = GFBGRAPH_NODE_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+
         switch (prop_id) {
                 case PROP_ID:
                         g_value_set_string (value, priv->id);
@@ -229,10 +295,445 @@ gfbgraph_node_get_property (GObject *object, guint prop_id, GValue *value, GPara
         }
 }
 
+static gboolean
+gfbgraph_node_real_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node)
+{
+        GFBGraphNodePrivate *priv;
+
+        priv = node->priv;
+
+        if (g_strcmp0 (member_name, "id") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->id);
+        else if (g_strcmp0 (member_name, "link") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->link);
+        else if (g_strcmp0 (member_name, "created_time") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->created_time);
+        else if (g_strcmp0 (member_name, "updated_time") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->updated_time);
+
+        return FALSE;
+}
+
+static void
+gfbgraph_node_deserialize_member_cb (JsonObject *json_object, const gchar *member_name, JsonNode *member_node, gpointer user_data)
+{
+        GFBGraphNodeDeserializeData *data;
+
+        data = (GFBGraphNodeDeserializeData *) user_data;
+
+        if (data->skip_id && g_strcmp0 (member_name, "id") == 0)
+                return;
+
+        if (GFBGRAPH_NODE_GET_CLASS (data->node)->deserialize_member (data->node, member_name, member_node))
+                return;
+
+        if (data->unknown == NULL)
+                data->unknown = json_object_new ();
+        json_object_set_member (data->unknown, member_name, json_node_copy (member_node));
+}
+
+/* Slow path, only reached by the members that the node class doesn't know about,
+ * which could still be properties of a node defined outside the library. They're
+ * decoded like json_gobject_deserialize() does, through the #JsonSerializable
+ * interface when the node implements it. */
+static void
+gfbgraph_node_deserialize_properties (GFBGraphNode *node, JsonObject *members)
+{
+        GObject *scratch;
+        GList *names;
+        GList *l;
+
+        scratch = NULL;
+        if (!JSON_IS_SERIALIZABLE (node)) {
+                JsonNode *json_node;
+
+                /* json-glib only exposes its default decoding of the properties through
+                 * json_gobject_deserialize(), so they're copied from a scratch node */
+                json_node = json_node_new (JSON_NODE_OBJECT);
+                json_node_set_object (json_node, members);
+                scratch = json_gobject_deserialize (G_OBJECT_TYPE (node), json_node);
+                json_node_free (json_node);
+        }
+
+        names = json_object_get_members (members);
+        for (l = names; l != NULL; l = l->next) {
+                const gchar *member_name;
+                GParamSpec *pspec;
+                GValue value = G_VALUE_INIT;
+
+                member_name = (const gchar *) l->data;
+
+                if (scratch == NULL)
+                        pspec = json_serializable_find_property (JSON_SERIALIZABLE (node), member_name);
+                else
+                        pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (node), member_name);
+
+                if (pspec == NULL
+                    || (pspec->flags & G_PARAM_WRITABLE) == 0
+                    || (pspec->flags & G_PARAM_CONSTRUCT_ONLY) != 0)
+                        continue;
+
+                g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+                if (scratch == NULL) {
+                        if (json_serializable_deserialize_property (JSON_SERIALIZABLE (node), pspec->name, &value, pspec,
+                                                                    json_object_get_member (members, member_name)))
+                                json_serializable_set_property (JSON_SERIALIZABLE (node), pspec, &value);
+                } else if ((pspec->flags & G_PARAM_READABLE) != 0) {
+                        g_object_get_property (scratch, pspec->name, &value);
+                        g_object_set_property (G_OBJECT (node), pspec->name, &value);
+                }
+                g_value_unset (&value);
+        }
+
+        g_list_free (names);
+        if (scratch != NULL)
+                g_object_unref (scratch);
+}
+
+/* Fills @node from the members of @json_object, the ones that the node class
+ * consumes first and then the remaining properties at once */
+static void
+gfbgraph_node_deserialize_members (GFBGraphNode *node, JsonObject *json_object, gboolean skip_id)
+{
+        GFBGraphNodeDeserializeData data;
+
+        data.node = node;
+        data.unknown = NULL;
+        data.skip_id = skip_id;
+
+        json_object_foreach_member (json_object, gfbgraph_node_deserialize_member_cb, &data);
+
+        if (data.unknown != NULL) {
+                gfbgraph_node_deserialize_properties (node, data.unknown);
+                json_object_unref (data.unknown);
+        }
+}
+
+/*
+ * gfbgraph_node_deserialize:
+ * @node_type: a #GFBGraphNode type #GType.
+ * @json_node: a #JsonNode holding the JSON object of a node.
+ * @arena: (allow-none): a #GFBGraphArena where store the node strings, or %NULL.
+ *
+ * Creates a node of type @node_type filling its fields directly from @json_node
+ * through the #GFBGraphNodeClass.deserialize_member() vfunc, so, unlike
+ * json_gobject_deserialize(), the known members don't need a #GParamSpec lookup
+ * and a #GValue round trip.
+ *
+ * With lazy deserialization enabled only the "id" member is decoded here, and
+ * the node keeps a reference to the JSON object until gfbgraph_node_materialize().
+ *
+ * Returns: (transfer full): a new #GFBGraphNode.
+ */
+GFBGraphNode*
+gfbgraph_node_deserialize (GType node_type, JsonNode *json_node, GFBGraphArena *arena)
+{
+        GFBGraphNode *node;
+        JsonObject *json_object;
+
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+        g_return_val_if_fail (json_node != NULL && JSON_NODE_HOLDS_OBJECT (json_node), NULL);
+
+        node = GFBGRAPH_NODE (g_object_new (node_type, NULL));
+        if (arena)
+                node->priv->arena = gfbgraph_arena_ref (arena);
+
+        json_object = json_node_get_object (json_node);
+
+        if (gfbgraph_get_lazy_deserialization ()) {
+                JsonNode *id_node;
+
+                id_node = json_object_get_member (json_object, "id");
+                if (id_node != NULL)
+                        gfbgraph_node_deserialize_string (node, id_node, &node->priv->id);
+
+                node->priv->pending = json_object_ref (json_object);
+        } else {
+                gfbgraph_node_deserialize_members (node, json_object, FALSE);
+        }
+
+        return node;
+}
+
+static void
+gfbgraph_node_real_serialize_members (GFBGraphNode *node, JsonBuilder *builder)
+{
+        GFBGraphNodePrivate *priv;
+
+        priv = node->priv;
+
+        gfbgraph_node_serialize_string (builder, "id", priv->id);
+        gfbgraph_node_serialize_string (builder, "link", priv->link);
+        gfbgraph_node_serialize_string (builder, "created_time", priv->created_time);
+        gfbgraph_node_serialize_string (builder, "updated_time", priv->updated_time);
+}
+
+/*
+ * gfbgraph_node_serialize_string:
+ * @builder: a #JsonBuilder with an open object.
+ * @member_name: the Graph API name of the member.
+ * @value: (allow-none): the member value.
+ *
+ * Adds a string member for #GFBGraphNodeClass.serialize_members(), unless @value is %NULL.
+ */
+void
+gfbgraph_node_serialize_string (JsonBuilder *builder, const gchar *member_name, const gchar *value)
+{
+        if (value == NULL)
+                return;
+
+        json_builder_set_member_name (builder, member_name);
+        json_builder_add_string_value (builder, value);
+}
+
+/*
+ * gfbgraph_node_serialize_uint:
+ * @builder: a #JsonBuilder with an open object.
+ * @member_name: the Graph API name of the member.
+ * @value: the member value.
+ *
+ * Adds an integer member for #GFBGraphNodeClass.serialize_members(), unless @value is 0,
+ * which is what an absent member deserializes to.
+ */
+void
+gfbgraph_node_serialize_uint (JsonBuilder *builder, const gchar *member_name, guint value)
+{
+        if (value == 0)
+                return;
+
+        json_builder_set_member_name (builder, member_name);
+        json_builder_add_int_value (builder, value);
+}
+
+/*
+ * gfbgraph_node_materialize:
+ * @node: a #GFBGraphNode.
+ *
+ * Decodes the members of a lazily deserialized @node. Every accessor of the node
+ * fields must call it before reading them. It's cheap once the node is decoded.
+ */
+void
+gfbgraph_node_materialize (GFBGraphNode *node)
+{
+        GFBGraphNodePrivate *priv;
+
+        priv = node->priv;
+
+        if (g_atomic_pointer_get (&priv->pending) == NULL)
+                return;
+
+        g_rec_mutex_lock (&materialize_mutex);
+
+        /* The members decoded through properties get here again from set_property() */
+        if (priv->pending != NULL && !priv->materializing) {
+                priv->materializing = TRUE;
+                /* The "id" was already decoded by gfbgraph_node_deserialize() */
+                gfbgraph_node_deserialize_members (node, priv->pending, TRUE);
+                priv->materializing = FALSE;
+
+                json_object_unref (priv->pending);
+                g_atomic_pointer_set (&priv->pending, NULL);
+        }
+
+        g_rec_mutex_unlock (&materialize_mutex);
+}
+
+/*
+ * gfbgraph_node_check_writable:
+ * @node: a #GFBGraphNode.
+ *
+ * Checks that @node isn't frozen before changing any of its fields. Every
+ * set_property() implementation must call it after gfbgraph_node_materialize().
+ *
+ * Returns: %TRUE if @node can be modified.
+ */
+gboolean
+gfbgraph_node_check_writable (GFBGraphNode *node)
+{
+        if (g_atomic_int_get (&node->priv->frozen)) {
+                g_critical ("The %s node %s is frozen and can't be modified",
+                            G_OBJECT_TYPE_NAME (node), node->priv->id ? node->priv->id : "(no ID)");
+                return FALSE;
+        }
+
+        return TRUE;
+}
+
+/*
+ * gfbgraph_node_deserialize_string:
+ * @node: the #GFBGraphNode being deserialized.
+ * @member_node: a #JsonNode.
+ * @field: the private field where store the string.
+ *
+ * Helper for the #GFBGraphNodeClass.deserialize_member() implementations.
+ *
+ * Returns: %TRUE if @member_node holds a string or a null value.
+ */
+gboolean
+gfbgraph_node_deserialize_string (GFBGraphNode *node, JsonNode *member_node, gchar **field)
+{
+        if (JSON_NODE_HOLDS_NULL (member_node)) {
+                gfbgraph_node_free_string (node, *field);
+                *field = NULL;
+                return TRUE;
+        }
+
+        if (JSON_NODE_HOLDS_VALUE (member_node) == FALSE
+            || json_node_get_value_type (member_node) != G_TYPE_STRING)
+                return FALSE;
+
+        gfbgraph_node_free_string (node, *field);
+        *field = gfbgraph_node_dup_string (node, json_node_get_string (member_node));
+
+        return TRUE;
+}
+
+/*
+ * gfbgraph_node_deserialize_uint:
+ * @node: the #GFBGraphNode being deserialized.
+ * @member_node: a #JsonNode.
+ * @field: the private field where store the number.
+ *
+ * Helper for the #GFBGraphNodeClass.deserialize_member() implementations.
+ *
+ * Returns: %TRUE if @member_node holds an integer.
+ */
+gboolean
+gfbgraph_node_deserialize_uint (GFBGraphNode *node, JsonNode *member_node, guint *field)
+{
+        if (JSON_NODE_HOLDS_VALUE (member_node) == FALSE
+            || json_node_get_value_type (member_node) != G_TYPE_INT64)
+                return FALSE;
+
+        *field = (guint) CLAMP (json_node_get_int (member_node), 0, G_MAXUINT);
+
+        return TRUE;
+}
+
+/*
+ * gfbgraph_node_dup_string:
+ * @node: a #GFBGraphNode.
+ * @str: (allow-none): the string to copy.
+ *
+ * Copies a string field of @node, taking it from the page arena when the node
+ * has one. Every string field of a node with an arena lives in it, the values
+ * set later too, so none is freed on its own.
+ *
+ * Returns: the copy, to be released with gfbgraph_node_free_string().
+ */
+gchar*
+gfbgraph_node_dup_string (GFBGraphNode *node, const gchar *str)
+{
+        if (node->priv->arena)
+                return gfbgraph_arena_strdup (node->priv->arena, str);
+
+        return g_strdup (str);
+}
+
+/*
+ * gfbgraph_node_free_string:
+ * @node: a #GFBGraphNode.
+ * @str: (allow-none): a string owned by @node.
+ *
+ * Frees a string field of @node, unless the node has a page arena, which
+ * holds all of them until the last node of the page is gone.
+ */
+void
+gfbgraph_node_free_string (GFBGraphNode *node, gchar *str)
+{
+        if (node->priv->arena == NULL)
+                g_free (str);
+}
+
+static gchar*
+gfbgraph_node_request_payload (GFBGraphNodeRequest *request, GError **error)
+{
+        RestProxyCall *rest_call;
+        gchar *payload;
+
+        rest_call = gfbgraph_new_function_call (request->authorizer, "GET", request->id);
+
+        if (request->expansion != NULL) {
+                gchar *fields;
+
+                fields = gfbgraph_expansion_to_string (request->expansion);
+                rest_proxy_call_add_param (rest_call, "fields", fields);
+                g_free (fields);
+        }
+
+        payload = NULL;
+        if (gfbgraph_transfer_call_sync (rest_call, error))
+                payload = g_strdup (rest_proxy_call_get_payload (rest_call));
+
+        g_object_unref (rest_call);
+
+        return payload;
+}
+
+/* Requests the node of @request, sharing the request with the concurrent
+ * callers of the same one. Only the payload is shared, every caller parses
+ * its own node, as they can modify it. */
+static GFBGraphNode*
+gfbgraph_node_request_by_id (GFBGraphNodeRequest *request, const gchar *key, GError **error)
+{
+        GFBGraphRequestRecord *record;
+        GFBGraphNode *node;
+        gchar *payload;
+
+        record = gfbgraph_request_record_begin ("GET", request->id);
+
+        node = NULL;
+        payload = gfbgraph_single_flight (key, (GFBGraphFlightFunc) gfbgraph_node_request_payload, request,
+                                          (GBoxedCopyFunc) g_strdup, g_free, error);
+        if (payload != NULL) {
+                JsonParser *jparser;
+                GFBGraphArena *arena;
+
+                /* The whole tree comes in one payload, so its strings can share one arena */
+                arena = request->expansion != NULL ? gfbgraph_arena_new () : NULL;
+
+                record->parse_start_time = g_get_monotonic_time ();
+
+                jparser = json_parser_new ();
+                if (json_parser_load_from_data (jparser, payload, -1, error)) {
+                        JsonNode *jnode;
+                        guint n_nodes = 0;
+
+                        jnode = json_parser_get_root (jparser);
+                        node = gfbgraph_node_deserialize (request->node_type, jnode, arena);
+                        if (node != NULL && request->expansion != NULL)
+                                n_nodes = gfbgraph_expansion_apply (request->expansion, node, json_node_get_object (jnode), arena);
+
+                        record->nodes = node != NULL ? n_nodes + 1 : 0;
+                }
+                g_object_unref (jparser);
+
+                record->parse_end_time = g_get_monotonic_time ();
+
+                if (arena)
+                        gfbgraph_arena_unref (arena);
+                g_free (payload);
+        }
+
+        gfbgraph_request_record_end (record, request->authorizer);
+
+        return node;
+}
+
+static gchar*
+gfbgraph_node_request_page_payload (GFBGraphNodePageRequest *request, GError **error)
+{
+        if (!gfbgraph_transfer_call_sync (request->rest_call, error))
+                return NULL;
+
+        return g_strdup (rest_proxy_call_get_payload (request->rest_call));
+}
+
 static void
 gfbgraph_node_connection_async_data_free (GFBGraphNodeConnectionAsyncData *data)
 {
-        g_list_free (data->list);
+        if (data->array)
+                g_ptr_array_unref (data->array);
         g_object_unref (data->authorizer);
 
         g_slice_free (GFBGraphNodeConnectionAsyncData, data);
@@ -247,7 +748,7 @@ gfbgraph_node_get_connection_nodes_async_thread (GSimpleAsyncResult *simple_asyn
         data = (GFBGraphNodeConnectionAsyncData *) g_simple_async_result_get_op_res_gpointer (simple_async);
 
         error = NULL;
-        data->list = gfbgraph_node_get_connection_nodes (node, data->node_type, data->authorizer, &error);
+        data->array = gfbgraph_node_get_connection_nodes_array (node, data->node_type, data->authorizer, &error);
         if (error != NULL)
                 g_simple_async_result_take_error (simple_async, error);
 }
@@ -274,39 +775,367 @@ gfbgraph_node_new (void)
  *
  * Retrieve a node object as a #GFBgraphNode of #node_type type, with the given @id from the Facebook Graph.
  *
+ * Concurrent calls for the same node share a single request, but each of them
+ * returns its own node.
+ *
  * Returns: (transfer full): a #GFBGraphNode or %NULL.
  **/
 GFBGraphNode*
 gfbgraph_node_new_from_id (GFBGraphAuthorizer *authorizer, const gchar *id, GType node_type, GError **error)
 {
+        GFBGraphNodeRequest request;
         GFBGraphNode *node;
-        RestProxyCall *rest_call;
+        gchar *request_key;
+        gchar *key;
 
         g_return_val_if_fail ((strlen (id) > 0), NULL);
         g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
         g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
 
-        rest_call = gfbgraph_new_rest_call (authorizer);
-        rest_proxy_call_set_method (rest_call, "GET");
-        rest_proxy_call_set_function (rest_call, id);
+        request.authorizer = authorizer;
+        request.id = id;
+        request.node_type = node_type;
+        request.expansion = NULL;
 
-        node = NULL;
-        if (rest_proxy_call_sync (rest_call, error)) {
-                JsonParser *jparser;
-                JsonNode *jnode;
-                const gchar *payload;
+        request_key = gfbgraph_request_key (authorizer, id, NULL);
+        key = g_strconcat (request_key, g_type_name (node_type), NULL);
 
-                payload = rest_proxy_call_get_payload (rest_call);
-                jparser = json_parser_new ();
-                if (json_parser_load_from_data (jparser, payload, -1, error)) {
-                        jnode = json_parser_get_root (jparser);
-                        node = GFBGRAPH_NODE (json_gobject_deserialize (node_type, jnode));
+        node = gfbgraph_node_request_by_id (&request, key, error);
+
+        g_free (key);
+        g_free (request_key);
+
+        return node;
+}
+
+/**
+ * gfbgraph_node_new_from_id_expanded:
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @id: a const #gchar with the node ID.
+ * @expansion: a #GFBGraphExpansion with the fields and the connections to retrieve.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Retrieves the node with the given @id, of the node type of @expansion, along with the
+ * connected nodes described by @expansion, all in one request. The connected nodes are
+ * available with gfbgraph_node_get_expanded_nodes() on the returned node and, for
+ * nested connections, on the connected nodes.
+ *
+ * Returns: (transfer full): a #GFBGraphNode or %NULL.
+ **/
+GFBGraphNode*
+gfbgraph_node_new_from_id_expanded (GFBGraphAuthorizer *authorizer, const gchar *id, GFBGraphExpansion *expansion, GError **error)
+{
+        GFBGraphNodeRequest request;
+        GFBGraphNode *node;
+        gchar *request_key;
+        gchar *fields;
+        gchar *key;
+
+        g_return_val_if_fail ((strlen (id) > 0), NULL);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
+        g_return_val_if_fail (expansion != NULL, NULL);
+
+        request.authorizer = authorizer;
+        request.id = id;
+        request.node_type = gfbgraph_expansion_get_node_type (expansion);
+        request.expansion = expansion;
+
+        fields = gfbgraph_expansion_to_string (expansion);
+        request_key = gfbgraph_request_key (authorizer, id, NULL);
+        key = g_strconcat (request_key, g_type_name (request.node_type), "?fields=", fields, NULL);
+
+        node = gfbgraph_node_request_by_id (&request, key, error);
+
+        g_free (key);
+        g_free (request_key);
+        g_free (fields);
+
+        return node;
+}
+
+/**
+ * gfbgraph_node_get_expanded_nodes:
+ * @node: a #GFBGraphNode.
+ * @node_type: the #GFBGraphNode type of the connected nodes.
+ *
+ * Gets the @node_type nodes connected to @node which were retrieved with
+ * gfbgraph_node_new_from_id_expanded().
+ *
+ * Returns: (transfer none) (element-type GFBGraphNode) (allow-none): a #GPtrArray of
+ *  #GFBGraphNode owned by @node, or %NULL if the connection wasn't expanded.
+ **/
+GPtrArray*
+gfbgraph_node_get_expanded_nodes (GFBGraphNode *node, GType node_type)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
+
+        if (node->priv->expanded == NULL)
+                return NULL;
+
+        return g_hash_table_lookup (node->priv->expanded, GSIZE_TO_POINTER (node_type));
+}
+
+/* Takes @nodes as the expanded @node_type connection of @node */
+void
+gfbgraph_node_set_expanded_nodes (GFBGraphNode *node, GType node_type, GPtrArray *nodes)
+{
+        g_return_if_fail (GFBGRAPH_IS_NODE (node));
+        g_return_if_fail (!gfbgraph_node_is_frozen (node));
+
+        if (node->priv->expanded == NULL)
+                node->priv->expanded = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                              NULL, (GDestroyNotify) g_ptr_array_unref);
+
+        g_hash_table_replace (node->priv->expanded, GSIZE_TO_POINTER (node_type), nodes);
+}
+
+/**
+ * gfbgraph_node_freeze:
+ * @node: a #GFBGraphNode.
+ *
+ * Makes @node read-only, along with the connected nodes retrieved with it by
+ * gfbgraph_node_new_from_id_expanded(). Any pending lazy deserialization is done
+ * now, and changing a field of a frozen node fails with a critical warning.
+ *
+ * The strings and arrays returned by the getters of a frozen node stay valid and
+ * unchanged while the node is alive, so it can be shared between threads, holding
+ * a reference, without locks nor copies. Nodes can't be unfrozen.
+ **/
+void
+gfbgraph_node_freeze (GFBGraphNode *node)
+{
+        GFBGraphNodePrivate *priv;
+
+        g_return_if_fail (GFBGRAPH_IS_NODE (node));
+
+        priv = node->priv;
+
+        if (g_atomic_int_get (&priv->frozen))
+                return;
+
+        gfbgraph_node_materialize (node);
+
+        if (priv->expanded != NULL) {
+                GHashTableIter iter;
+                GPtrArray *nodes;
+                guint i;
+
+                g_hash_table_iter_init (&iter, priv->expanded);
+                while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &nodes)) {
+                        for (i = 0; i < nodes->len; i++)
+                                gfbgraph_node_freeze (GFBGRAPH_NODE (g_ptr_array_index (nodes, i)));
                 }
+        }
 
-                g_object_unref (jparser);
+        g_atomic_int_set (&priv->frozen, TRUE);
+}
+
+/**
+ * gfbgraph_node_is_frozen:
+ * @node: a #GFBGraphNode.
+ *
+ * See gfbgraph_node_freeze().
+ *
+ * Returns: %TRUE if @node is read-only.
+ **/
+gboolean
+gfbgraph_node_is_frozen (GFBGraphNode *node)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), FALSE);
+
+        return g_atomic_int_get (&node->priv->frozen);
+}
+
+/**
+ * gfbgraph_node_serialize:
+ * @node: a #GFBGraphNode.
+ *
+ * Serializes @node as the JSON object the Graph API returns for it, with the
+ * same member names, so gfbgraph_node_new_from_json() restores an identical node.
+ * The fields are read directly through the #GFBGraphNodeClass.serialize_members()
+ * vfunc, without the #GParamSpec lookups and #GValue copies of json_gobject_serialize().
+ *
+ * Returns: (transfer full): a new #JsonNode holding an object; free it with json_node_free().
+ **/
+JsonNode*
+gfbgraph_node_serialize (GFBGraphNode *node)
+{
+        JsonBuilder *builder;
+        JsonNode *json_node;
+
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
+
+        gfbgraph_node_materialize (node);
+
+        builder = json_builder_new ();
+        json_builder_begin_object (builder);
+        GFBGRAPH_NODE_GET_CLASS (node)->serialize_members (node, builder);
+        json_builder_end_object (builder);
+
+        json_node = json_builder_get_root (builder);
+        g_object_unref (builder);
+
+        return json_node;
+}
+
+/**
+ * gfbgraph_node_new_from_json:
+ * @node_type: a #GFBGraphNode type #GType.
+ * @json_node: a #JsonNode holding an object, as returned by gfbgraph_node_serialize()
+ *  or the Graph API.
+ *
+ * Creates a node of type @node_type from its JSON representation.
+ *
+ * Returns: (transfer full): a new #GFBGraphNode; unref with g_object_unref()
+ **/
+GFBGraphNode*
+gfbgraph_node_new_from_json (GType node_type, JsonNode *json_node)
+{
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+        g_return_val_if_fail (json_node != NULL && JSON_NODE_HOLDS_OBJECT (json_node), NULL);
+
+        return gfbgraph_node_deserialize (node_type, json_node, NULL);
+}
+
+/**
+ * gfbgraph_node_write_nodes:
+ * @nodes: (element-type GFBGraphNode): a #GPtrArray of #GFBGraphNode.
+ * @stream: a #GOutputStream.
+ * @cancellable: (allow-none): a #GCancellable or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Writes @nodes to @stream, one compact JSON line per node with its type name and
+ * gfbgraph_node_serialize() output. Every node is written as soon as it's serialized,
+ * so the whole set is never held in memory as JSON. Read them back with
+ * gfbgraph_node_read_nodes().
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_node_write_nodes (GPtrArray *nodes, GOutputStream *stream, GCancellable *cancellable, GError **error)
+{
+        JsonGenerator *generator;
+        JsonBuilder *builder;
+        gboolean ret = TRUE;
+        guint i;
+
+        g_return_val_if_fail (nodes != NULL, FALSE);
+        g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), FALSE);
+
+        generator = json_generator_new ();
+        builder = json_builder_new ();
+
+        for (i = 0; i < nodes->len && ret; i++) {
+                GFBGraphNode *node;
+                JsonNode *root;
+                gchar *line;
+                gsize length;
+
+                node = GFBGRAPH_NODE (g_ptr_array_index (nodes, i));
+
+                json_builder_reset (builder);
+                json_builder_begin_object (builder);
+                json_builder_set_member_name (builder, "type");
+                json_builder_add_string_value (builder, G_OBJECT_TYPE_NAME (node));
+                json_builder_set_member_name (builder, "node");
+                json_builder_add_value (builder, gfbgraph_node_serialize (node));
+                json_builder_end_object (builder);
+
+                root = json_builder_get_root (builder);
+                json_generator_set_root (generator, root);
+                line = json_generator_to_data (generator, &length);
+                json_node_free (root);
+
+                ret = g_output_stream_write_all (stream, line, length, NULL, cancellable, error)
+                        && g_output_stream_write_all (stream, "\n", 1, NULL, cancellable, error);
+                g_free (line);
         }
 
-        return node;
+        g_object_unref (builder);
+        g_object_unref (generator);
+
+        return ret;
+}
+
+/**
+ * gfbgraph_node_read_nodes:
+ * @stream: a #GInputStream with the data written by gfbgraph_node_write_nodes().
+ * @cancellable: (allow-none): a #GCancellable or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Reads the nodes written by gfbgraph_node_write_nodes(), line by line.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray of #GFBGraphNode,
+ * or %NULL if an error ocurred.
+ **/
+GPtrArray*
+gfbgraph_node_read_nodes (GInputStream *stream, GCancellable *cancellable, GError **error)
+{
+        GDataInputStream *data_stream;
+        GFBGraphArena *arena;
+        JsonParser *jparser;
+        GPtrArray *nodes;
+        GError *read_error = NULL;
+        gchar *line;
+        gsize length;
+        guint line_number = 0;
+
+        g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+        data_stream = g_data_input_stream_new (stream);
+        g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (data_stream), FALSE);
+        jparser = json_parser_new ();
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+
+        /* Like the nodes of a page, all the read nodes share the string storage */
+        arena = gfbgraph_get_string_pooling () ? gfbgraph_arena_new () : NULL;
+
+        while ((line = g_data_input_stream_read_line (data_stream, &length, cancellable, &read_error)) != NULL) {
+                JsonObject *record;
+                GType node_type;
+
+                line_number++;
+
+                if (length == 0) {
+                        g_free (line);
+                        continue;
+                }
+
+                if (!json_parser_load_from_data (jparser, line, length, &read_error)) {
+                        g_free (line);
+                        break;
+                }
+                g_free (line);
+
+                record = JSON_NODE_HOLDS_OBJECT (json_parser_get_root (jparser))
+                        ? json_node_get_object (json_parser_get_root (jparser)) : NULL;
+                node_type = (record != NULL && json_object_has_member (record, "type"))
+                        ? gfbgraph_node_type_from_name (json_object_get_string_member (record, "type")) : G_TYPE_INVALID;
+
+                if (node_type == G_TYPE_INVALID
+                    || !json_object_has_member (record, "node")
+                    || !JSON_NODE_HOLDS_OBJECT (json_object_get_member (record, "node"))) {
+                        g_set_error (&read_error, GFBGRAPH_NODE_ERROR,
+                                     GFBGRAPH_NODE_ERROR_INVALID_DATA,
+                                     "Invalid node at line %u", line_number);
+                        break;
+                }
+
+                g_ptr_array_add (nodes, gfbgraph_node_deserialize (node_type, json_object_get_member (record, "node"), arena));
+        }
+
+        if (arena)
+                gfbgraph_arena_unref (arena);
+        g_object_unref (jparser);
+        g_object_unref (data_stream);
+
+        if (read_error != NULL) {
+                g_propagate_error (error, read_error);
+                g_ptr_array_unref (nodes);
+                return NULL;
+        }
+
+        return nodes;
 }
 
 /**
@@ -338,6 +1167,8 @@ gfbgraph_node_get_link (GFBGraphNode *node)
 {
         g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
 
+        gfbgraph_node_materialize (node);
+
         return node->priv->link;
 }
 
@@ -354,6 +1185,8 @@ gfbgraph_node_get_created_time (GFBGraphNode *node)
 {
         g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
 
+        gfbgraph_node_materialize (node);
+
         return node->priv->created_time;
 }
 
@@ -370,6 +1203,8 @@ gfbgraph_node_get_updated_time (GFBGraphNode *node)
 {
         g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
 
+        gfbgraph_node_materialize (node);
+
         return node->priv->updated_time;
 }
 
@@ -407,12 +1242,58 @@ gfbgraph_node_set_id (GFBGraphNode *node, const gchar *id)
  **/
 GList*
 gfbgraph_node_get_connection_nodes (GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        return gfbgraph_ptr_array_steal_to_list (gfbgraph_node_get_connection_nodes_array (node, node_type, authorizer, error));
+}
+
+/**
+ * gfbgraph_node_get_connection_nodes_array:
+ * @node: a #GFBGraphNode object which retrieve the connected nodes.
+ * @node_type: a #GFBGraphNode type #GType that determines the kind of nodes to retrieve.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Like gfbgraph_node_get_connection_nodes(), but returning the nodes in an array.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray of type @node_type objects
+ * with the found nodes, or %NULL. Free it with g_ptr_array_unref().
+ **/
+GPtrArray*
+gfbgraph_node_get_connection_nodes_array (GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        return gfbgraph_node_fetch_connection_page (node, node_type, authorizer, NULL, NULL, NULL, error);
+}
+
+/*
+ * gfbgraph_node_fetch_connection_page:
+ * @node: a #GFBGraphNode object which retrieve the connected nodes.
+ * @node_type: a #GFBGraphNode type #GType that determines the kind of nodes to retrieve.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @params: (allow-none): a string based #GHashTable with extra query params, or %NULL.
+ * @next_params: (out) (allow-none): return location for the query params of the next
+ *  page, which is set to %NULL if this page is the last one.
+ * @total_count: (out) (allow-none): return location for the total number of connected
+ *  nodes, or %NULL to not request it. It's set to -1 if the Graph API doesn't report it.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Retrieves one page of the nodes connected to @node. The params returned in
+ * @next_params can be passed back as @params to continue with the next page.
+ * Requesting @total_count adds the "summary" param to the request.
+ *
+ * Returns: (transfer full): a new #GPtrArray with the page nodes, or %NULL.
+ */
+GPtrArray*
+gfbgraph_node_fetch_connection_page (GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer, GHashTable *params, GHashTable **next_params, gint64 *total_count, GError **error)
 {
         GFBGraphNodePrivate *priv;
-        GList *nodes_list = NULL;
-        GFBGraphNode *connected_node;
+        GPtrArray *nodes_array = NULL;
+        GFBGraphNodePageRequest page_request;
+        GFBGraphRequestRecord *record;
         RestProxyCall *rest_call;
         gchar *function_path;
+        gchar *next_url = NULL;
+        gchar *payload;
+        gchar *request_key;
 
         g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
         g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
@@ -420,45 +1301,90 @@ gfbgraph_node_get_connection_nodes (GFBGraphNode *node, GType node_type, GFBGrap
 
         priv = GFBGRAPH_NODE_GET_PRIVATE (node);
 
-        /* Dummy node just for test */
-        connected_node = g_object_new (node_type, NULL);
-        if (GFBGRAPH_IS_CONNECTABLE (connected_node) == FALSE) {
+        if (next_params != NULL)
+                *next_params = NULL;
+        if (total_count != NULL)
+                *total_count = -1;
+
+        if (g_type_is_a (node_type, GFBGRAPH_TYPE_CONNECTABLE) == FALSE) {
                 g_set_error (error, GFBGRAPH_NODE_ERROR,
                              GFBGRAPH_NODE_ERROR_NO_CONNECTABLE,
                              "The given node type (%s) doesn't implement connectable interface", g_type_name (node_type));
                 return NULL;
         }
 
-        if (gfbgraph_connectable_is_connectable_to (GFBGRAPH_CONNECTABLE (connected_node), G_OBJECT_TYPE (node)) == FALSE) {
+        if (gfbgraph_connectable_type_is_connectable_to (node_type, G_OBJECT_TYPE (node)) == FALSE) {
                 g_set_error (error, GFBGRAPH_NODE_ERROR,
                              GFBGRAPH_NODE_ERROR_NO_CONNECTABLE,
                              "The given node type (%s) can't connect with the node", g_type_name (node_type));
                 return NULL;
         }
 
-        rest_call = gfbgraph_new_rest_call (authorizer);
-        rest_proxy_call_set_method (rest_call, "GET");
         function_path = g_strdup_printf ("%s/%s",
                                          priv->id,
-                                         gfbgraph_connectable_get_connection_path (GFBGRAPH_CONNECTABLE (connected_node),
-                                                                                      G_OBJECT_TYPE (node)));
-        rest_proxy_call_set_function (rest_call, function_path);
+                                         gfbgraph_connectable_type_get_connection_path (node_type, G_OBJECT_TYPE (node)));
+        rest_call = gfbgraph_new_function_call (authorizer, "GET", function_path);
 
-        if (rest_proxy_call_sync (rest_call, error)) {
-                const gchar *payload;
+        if (params != NULL) {
+                GHashTableIter iter;
+                const gchar *key;
+                const gchar *value;
 
-                payload = rest_proxy_call_get_payload (rest_call);
-                nodes_list = gfbgraph_connectable_parse_connected_data (GFBGRAPH_CONNECTABLE (connected_node), payload, error);
-        } else {
-                return NULL;
+                g_hash_table_iter_init (&iter, params);
+                while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &value))
+                        rest_proxy_call_add_param (rest_call, key, value);
         }
 
-        /* We don't need this node again */
-        g_clear_object (&connected_node);
-        g_free (function_path);
+        /* The summary comes along with the page, so it costs no extra request */
+        if (total_count != NULL && (params == NULL || !g_hash_table_contains (params, "summary")))
+                rest_proxy_call_add_param (rest_call, "summary", "true");
+
+        /* Identical pages requested at the same time are only downloaded once */
+        page_request.rest_call = rest_call;
+        record = gfbgraph_request_record_begin ("GET", function_path);
+        request_key = gfbgraph_request_key (authorizer, function_path, params);
+        if (total_count != NULL) {
+                gchar *summary_key;
 
+                summary_key = g_strconcat (request_key, "&summary", NULL);
+                g_free (request_key);
+                request_key = summary_key;
+        }
+        payload = gfbgraph_single_flight (request_key, (GFBGraphFlightFunc) gfbgraph_node_request_page_payload, &page_request,
+                                          (GBoxedCopyFunc) g_strdup, g_free, error);
+        g_free (request_key);
+
+        if (payload != NULL) {
+                record->parse_start_time = g_get_monotonic_time ();
+                nodes_array = gfbgraph_connectable_type_parse_connected_data_array (node_type, payload,
+                                                                                    next_params ? &next_url : NULL,
+                                                                                    total_count, error);
+                record->parse_end_time = g_get_monotonic_time ();
+                record->nodes = nodes_array != NULL ? nodes_array->len : 0;
+                g_free (payload);
+        }
+
+        gfbgraph_request_record_end (record, authorizer);
+
+        if (next_url != NULL) {
+                SoupURI *uri;
+
+                uri = soup_uri_new (next_url);
+                if (uri != NULL && soup_uri_get_query (uri) != NULL) {
+                        *next_params = soup_form_decode (soup_uri_get_query (uri));
+                        /* The authorizer adds its own token to every call */
+                        g_hash_table_remove (*next_params, "access_token");
+                }
 
-        return nodes_list;
+                if (uri != NULL)
+                        soup_uri_free (uri);
+                g_free (next_url);
+        }
+
+        g_object_unref (rest_call);
+        g_free (function_path);
+
+        return nodes_array;
 }
 
 /**
@@ -490,13 +1416,13 @@ gfbgraph_node_get_connection_nodes_async (GFBGraphNode *node, GType node_type, G
         g_simple_async_result_set_check_cancellable (result, cancellable);
 
         data = g_slice_new (GFBGraphNodeConnectionAsyncData);
-        data->list = NULL;
+        data->array = NULL;
         data->node_type = node_type;
         data->authorizer = authorizer;
         g_object_ref (data->authorizer);
 
         g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) gfbgraph_node_connection_async_data_free);
-        g_simple_async_result_run_in_thread (result, (GSimpleAsyncThreadFunc) gfbgraph_node_get_connection_nodes_async_thread, G_PRIORITY_DEFAULT, cancellable);
+        gfbgraph_simple_async_run_in_thread (result, (GSimpleAsyncThreadFunc) gfbgraph_node_get_connection_nodes_async_thread, cancellable);
 
         g_object_unref (result);
 }
@@ -517,6 +1443,7 @@ gfbgraph_node_get_connection_nodes_async_finish (GFBGraphNode *node, GAsyncResul
 {
         GSimpleAsyncResult *simple_async;
         GFBGraphNodeConnectionAsyncData *data;
+        GList *list;
 
         g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (node), gfbgraph_node_get_connection_nodes_async), NULL);
         g_return_val_if_fail (error == NULL || *error == NULL, NULL);
@@ -527,7 +1454,12 @@ gfbgraph_node_get_connection_nodes_async_finish (GFBGraphNode *node, GAsyncResul
                 return NULL;
 
         data = (GFBGraphNodeConnectionAsyncData *) g_simple_async_result_get_op_res_gpointer (simple_async);
-        return data->list;
+
+        /* The nodes are handed to the caller */
+        list = gfbgraph_ptr_array_steal_to_list (data->array);
+        data->array = NULL;
+
+        return list;
 }
 
 /**
@@ -546,9 +1478,11 @@ gboolean
 gfbgraph_node_append_connection (GFBGraphNode *node, GFBGraphNode *connect_node, GFBGraphAuthorizer *authorizer, GError **error)
 {
         GFBGraphNodePrivate *priv;
+        GFBGraphRequestRecord *record;
         RestProxyCall *rest_call;
         GHashTable *params;
         gchar *function_path;
+        gboolean result;
 
         g_return_val_if_fail (GFBGRAPH_IS_NODE (node), FALSE);
         g_return_val_if_fail (GFBGRAPH_IS_NODE (connect_node), FALSE);
@@ -570,13 +1504,11 @@ gfbgraph_node_append_connection (GFBGraphNode *node, GFBGraphNode *connect_node,
 
         priv = GFBGRAPH_NODE_GET_PRIVATE (node);
 
-        rest_call = gfbgraph_new_rest_call (authorizer);
-        rest_proxy_call_set_method (rest_call, "POST");
         function_path = g_strdup_printf ("%s/%s",
                                          priv->id,
                                          gfbgraph_connectable_get_connection_path (GFBGRAPH_CONNECTABLE (connect_node),
                                                                                    G_OBJECT_TYPE (node)));
-        rest_proxy_call_set_function (rest_call, function_path);
+        rest_call = gfbgraph_new_function_call (authorizer, "POST", function_path);
 
         params = gfbgraph_connectable_get_connection_post_params (GFBGRAPH_CONNECTABLE (connect_node), G_OBJECT_TYPE (node));
         if (g_hash_table_size (params) > 0) {
@@ -590,7 +1522,10 @@ gfbgraph_node_append_connection (GFBGraphNode *node, GFBGraphNode *connect_node,
                 }
         }
 
-        if (rest_proxy_call_sync (rest_call, error)) {
+        record = gfbgraph_request_record_begin ("POST", function_path);
+
+        result = gfbgraph_transfer_call_sync (rest_call, error);
+        if (result) {
                 const gchar *payload;
                 JsonParser *jparser;
                 JsonNode *jnode;
@@ -610,11 +1545,12 @@ gfbgraph_node_append_connection (GFBGraphNode *node, GFBGraphNode *connect_node,
 
                 g_object_unref (jreader);
                 g_object_unref (jparser);
-        } else {
-                return FALSE;
         }
 
+        gfbgraph_request_record_end (record, authorizer);
+
+        g_object_unref (rest_call);
         g_free (function_path);
 
-        return TRUE;
+        return result;
 }
@@ -21,7 +21,9 @@
 #define __GFBGRAPH_NODE_H__
 
 #include <glib-object.h>
+#include <json-glib/json-glib.h>
 #include <gfbgraph/gfbgraph-authorizer.h>
+#include <gfbgraph/gfbgraph-expansion.h>
 
 G_BEGIN_DECLS
 
@@ -45,13 +47,39 @@ struct _GFBGraphNode {
         GFBGraphNodePrivate *priv;
 };
 
+/**
+ * GFBGraphNodeClass:
+ * @parent_class: The parent class.
+ * @deserialize_member: Fills the node fields from a member of the JSON object returned
+ *  by the Graph API. Implementations must return %TRUE when the member was consumed and
+ *  chain up to the parent class otherwise.
+ * @serialize_members: Adds the node fields to an open object of a #JsonBuilder, with the
+ *  member names of the Graph API. Implementations must chain up to the parent class.
+ *
+ * The members that no @deserialize_member implementation consumes are set on the
+ * matching properties, decoded like json_gobject_deserialize() does, so a subclass
+ * only needs to implement these vfuncs for the members it wants to read faster.
+ *
+ * Class structure for #GFBGraphNode.
+ **/
 struct _GFBGraphNodeClass {
         GObjectClass parent_class;
+
+        gboolean (*deserialize_member) (GFBGraphNode *node,
+                                        const gchar  *member_name,
+                                        JsonNode     *member_node);
+        void     (*serialize_members)  (GFBGraphNode *node,
+                                        JsonBuilder  *builder);
+
+        /*< private >*/
+        /* Padding for future expansion */
+        gpointer padding[8];
 };
 
 typedef enum {
         GFBGRAPH_NODE_ERROR_NO_CONNECTIONABLE = 1,
-        GFBGRAPH_NODE_ERROR_NO_CONNECTABLE
+        GFBGRAPH_NODE_ERROR_NO_CONNECTABLE,
+        GFBGRAPH_NODE_ERROR_INVALID_DATA
 } GFBGraphNodeError;
 
 GType          gfbgraph_node_get_type    (void) G_GNUC_CONST;
@@ -59,6 +87,9 @@ GQuark         gfbgraph_node_error_quark (void) G_GNUC_CONST;
 GFBGraphNode*  gfbgraph_node_new         (void);
 
 GFBGraphNode*  gfbgraph_node_new_from_id (GFBGraphAuthorizer *authorizer, const gchar *id, GType node_type, GError **error);
+GFBGraphNode*  gfbgraph_node_new_from_id_expanded (GFBGraphAuthorizer *authorizer, const gchar *id,
+                                                   GFBGraphExpansion *expansion, GError **error);
+GPtrArray*     gfbgraph_node_get_expanded_nodes   (GFBGraphNode *node, GType node_type);
 
 const gchar*   gfbgraph_node_get_id           (GFBGraphNode *node);
 const gchar*   gfbgraph_node_get_link         (GFBGraphNode *node);
@@ -71,6 +102,10 @@ GList*         gfbgraph_node_get_connection_nodes              (GFBGraphNode
                                                                 GType                 node_type,
                                                                 GFBGraphAuthorizer   *authorizer,
                                                                 GError              **error);
+GPtrArray*     gfbgraph_node_get_connection_nodes_array        (GFBGraphNode         *node,
+                                                                GType                 node_type,
+                                                                GFBGraphAuthorizer   *authorizer,
+                                                                GError              **error);
 void           gfbgraph_node_get_connection_nodes_async        (GFBGraphNode         *node, 
                                                                 GType                 node_type, 
                                                                 GFBGraphAuthorizer   *authorizer,
@@ -83,6 +118,14 @@ GList*         gfbgraph_node_get_connection_nodes_async_finish (GFBGraphNode
 
 gboolean       gfbgraph_node_append_connection (GFBGraphNode *node, GFBGraphNode *connect_node, GFBGraphAuthorizer *authorizer, GError **error);
 
+void           gfbgraph_node_freeze           (GFBGraphNode *node);
+gboolean       gfbgraph_node_is_frozen        (GFBGraphNode *node);
+
+JsonNode*      gfbgraph_node_serialize        (GFBGraphNode *node);
+GFBGraphNode*  gfbgraph_node_new_from_json    (GType node_type, JsonNode *json_node);
+gboolean       gfbgraph_node_write_nodes      (GPtrArray *nodes, GOutputStream *stream, GCancellable *cancellable, GError **error);
+GPtrArray*     gfbgraph_node_read_nodes       (GInputStream *stream, GCancellable *cancellable, GError **error);
+
 G_END_DECLS
 
 #endif /* __GFBGRAPH_NODE_H__ */
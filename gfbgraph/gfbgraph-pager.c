@@ -0,0 +1,697 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-pager
+ * @short_description: Page by page retrieval of node connections
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * #GFBGraphPager retrieves the nodes connected to a node one page at a time, following
+ * the paging cursors of the Graph API, with gfbgraph_pager_next().
+ *
+ * When the #GFBGraphPager:summary property is set, the first page is requested along
+ * with the summary of the connection, so the total number of connected nodes is known
+ * with gfbgraph_pager_get_total_count() before retrieving the rest of the pages. It's
+ * enough to preallocate the storage of the nodes or to report an accurate progress.
+ *
+ * |[
+ * GFBGraphPager *pager;
+ * GPtrArray *photos, *page;
+ *
+ * pager = gfbgraph_pager_new (album, GFBGRAPH_TYPE_PHOTO, authorizer);
+ * g_object_set (pager, "summary", TRUE, "page-size", 100, NULL);
+ *
+ * page = gfbgraph_pager_next (pager, &error);
+ * photos = g_ptr_array_sized_new (MAX (gfbgraph_pager_get_total_count (pager), 0));
+ * ]|
+ *
+ * The pager is also an asynchronous iterator over all the connected nodes with
+ * gfbgraph_pager_next_nodes_async(), which hands the nodes in chunks of the requested
+ * size regardless of the page boundaries. Only a page is buffered at a time: the next
+ * one is requested in the background once the buffered nodes drop to the
+ * #GFBGraphPager:low-water-mark, so the memory stays bounded for any connection size
+ * and a steady consumer doesn't wait for the pages.
+ **/
+
+#include "gfbgraph-pager.h"
+#include "gfbgraph-private.h"
+
+enum
+{
+        PROP_0,
+
+        PROP_NODE,
+        PROP_NODE_TYPE,
+        PROP_AUTHORIZER,
+        PROP_PAGE_SIZE,
+        PROP_SUMMARY,
+        PROP_LOW_WATER_MARK
+};
+
+#define PAGER_DEFAULT_LOW_WATER_MARK 10
+
+struct _GFBGraphPagerPrivate {
+        GFBGraphNode *node;
+        GType node_type;
+        GFBGraphAuthorizer *authorizer;
+        guint page_size;
+        gboolean summary;
+
+        /* The params of the next page, NULL before the first one and after the last one */
+        GHashTable *params;
+        gboolean started;
+        gboolean done;
+        gint64 total_count;
+        guint fetched_count;
+        guint first_page_size;
+
+        /* The asynchronous iteration, only used from the main context of the caller */
+        guint low_water_mark;
+        GQueue *buffer;
+        gboolean fetching;
+        GError *fetch_error;
+        GSimpleAsyncResult *waiting;
+        guint waiting_max_nodes;
+        GCancellable *waiting_cancellable;
+};
+
+typedef struct {
+        gboolean want_total;
+        GPtrArray *nodes;
+        GHashTable *next_params;
+        gint64 total_count;
+} GFBGraphPagerFetchData;
+
+static void gfbgraph_pager_init         (GFBGraphPager *obj);
+static void gfbgraph_pager_class_init   (GFBGraphPagerClass *klass);
+static void gfbgraph_pager_finalize     (GObject *obj);
+static void gfbgraph_pager_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
+static void gfbgraph_pager_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+#define GFBGRAPH_PAGER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE((o), GFBGRAPH_TYPE_PAGER, GFBGraphPagerPrivate))
+
+static GObjectClass *parent_class = NULL;
+
+G_DEFINE_TYPE (GFBGraphPager, gfbgraph_pager, G_TYPE_OBJECT);
+
+static void
+gfbgraph_pager_init (GFBGraphPager *obj)
+{
+        obj->priv = GFBGRAPH_PAGER_GET_PRIVATE(obj);
+
+        obj->priv->total_count = -1;
+        obj->priv->low_water_mark = PAGER_DEFAULT_LOW_WATER_MARK;
+        obj->priv->buffer = g_queue_new ();
+}
+
+static void
+gfbgraph_pager_class_init (GFBGraphPagerClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        parent_class            = g_type_class_peek_parent (klass);
+        gobject_class->finalize = gfbgraph_pager_finalize;
+        gobject_class->set_property = gfbgraph_pager_set_property;
+        gobject_class->get_property = gfbgraph_pager_get_property;
+
+        g_type_class_add_private (gobject_class, sizeof(GFBGraphPagerPrivate));
+
+        /**
+         * GFBGraphPager:node:
+         *
+         * The node whose connections are retrieved.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_NODE,
+                                         g_param_spec_object ("node",
+                                                              "The paged node", "The node whose connections are retrieved",
+                                                              GFBGRAPH_TYPE_NODE,
+                                                              G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphPager:node-type:
+         *
+         * The #GType of the connected nodes, it must implement the #GFBGraphConnectable interface.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_NODE_TYPE,
+                                         g_param_spec_gtype ("node-type",
+                                                             "The connected nodes type", "The GType of the connected nodes",
+                                                             GFBGRAPH_TYPE_NODE,
+                                                             G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphPager:authorizer:
+         *
+         * The authorizer of the requests.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_AUTHORIZER,
+                                         g_param_spec_object ("authorizer",
+                                                              "The authorizer", "The authorizer of the requests",
+                                                              GFBGRAPH_TYPE_AUTHORIZER,
+                                                              G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphPager:page-size:
+         *
+         * The maximum number of nodes of every page, or 0 for the default of the Graph API.
+         * Changing it only affects the first page, the next ones keep the size of the first.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_PAGE_SIZE,
+                                         g_param_spec_uint ("page-size",
+                                                            "Page size", "The maximum number of nodes of every page",
+                                                            0, G_MAXUINT, 0,
+                                                            G_PARAM_READABLE | G_PARAM_WRITABLE));
+
+        /**
+         * GFBGraphPager:summary:
+         *
+         * Whether to request the summary of the connection with the first page, which
+         * provides the total number of connected nodes.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_SUMMARY,
+                                         g_param_spec_boolean ("summary",
+                                                               "Summary", "Whether to request the total number of nodes",
+                                                               FALSE,
+                                                               G_PARAM_READABLE | G_PARAM_WRITABLE));
+
+        /**
+         * GFBGraphPager:low-water-mark:
+         *
+         * For gfbgraph_pager_next_nodes_async(), the number of buffered nodes under which
+         * the next page is requested in the background.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_LOW_WATER_MARK,
+                                         g_param_spec_uint ("low-water-mark",
+                                                            "Low water mark", "The buffered nodes under which the next page is requested",
+                                                            0, G_MAXUINT, PAGER_DEFAULT_LOW_WATER_MARK,
+                                                            G_PARAM_READABLE | G_PARAM_WRITABLE));
+}
+
+static void
+gfbgraph_pager_finalize (GObject *obj)
+{
+        GFBGraphPagerPrivate *priv;
+
+        priv = GFBGRAPH_PAGER_GET_PRIVATE (obj);
+
+        g_clear_object (&priv->node);
+        g_clear_object (&priv->authorizer);
+        if (priv->params)
+                g_hash_table_unref (priv->params);
+        g_queue_free_full (priv->buffer, g_object_unref);
+        g_clear_error (&priv->fetch_error);
+
+        G_OBJECT_CLASS(parent_class)->finalize (obj);
+}
+
+static void
+gfbgraph_pager_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+        GFBGraphPagerPrivate *priv;
+
+        priv = GFBGRAPH_PAGER_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_NODE:
+                        priv->node = g_value_dup_object (value);
+                        break;
+                case PROP_NODE_TYPE:
+                        priv->node_type = g_value_get_gtype (value);
+                        break;
+                case PROP_AUTHORIZER:
+                        priv->authorizer = g_value_dup_object (value);
+                        break;
+                case PROP_PAGE_SIZE:
+                        priv->page_size = g_value_get_uint (value);
+                        break;
+                case PROP_SUMMARY:
+                        priv->summary = g_value_get_boolean (value);
+                        break;
+                case PROP_LOW_WATER_MARK:
+                        priv->low_water_mark = g_value_get_uint (value);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_pager_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+        GFBGraphPagerPrivate *priv;
+
+        priv = GFBGRAPH_PAGER_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_NODE:
+                        g_value_set_object (value, priv->node);
+                        break;
+                case PROP_NODE_TYPE:
+                        g_value_set_gtype (value, priv->node_type);
+                        break;
+                case PROP_AUTHORIZER:
+                        g_value_set_object (value, priv->authorizer);
+                        break;
+                case PROP_PAGE_SIZE:
+                        g_value_set_uint (value, priv->page_size);
+                        break;
+                case PROP_SUMMARY:
+                        g_value_set_boolean (value, priv->summary);
+                        break;
+                case PROP_LOW_WATER_MARK:
+                        g_value_set_uint (value, priv->low_water_mark);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+/**
+ * gfbgraph_pager_new:
+ * @node: a #GFBGraphNode.
+ * @node_type: a #GFBGraphNode type #GType, connectable to @node.
+ * @authorizer: a #GFBGraphAuthorizer.
+ *
+ * Creates a new #GFBGraphPager to retrieve the nodes of type @node_type connected to @node.
+ *
+ * Returns: (transfer full): a new #GFBGraphPager; unref with g_object_unref()
+ **/
+GFBGraphPager*
+gfbgraph_pager_new (GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
+
+        return GFBGRAPH_PAGER (g_object_new (GFBGRAPH_TYPE_PAGER,
+                                             "node", node,
+                                             "node-type", node_type,
+                                             "authorizer", authorizer,
+                                             NULL));
+}
+
+/* The params of the next page, creating the ones of the first page */
+static GHashTable*
+gfbgraph_pager_get_params (GFBGraphPager *pager)
+{
+        GFBGraphPagerPrivate *priv;
+
+        priv = pager->priv;
+
+        if (!priv->started) {
+                priv->params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+                if (priv->page_size > 0)
+                        g_hash_table_insert (priv->params, g_strdup ("limit"), g_strdup_printf ("%u", priv->page_size));
+                priv->started = TRUE;
+        }
+
+        return priv->params;
+}
+
+/* Only the first page needs the summary */
+static gboolean
+gfbgraph_pager_wants_total (GFBGraphPager *pager)
+{
+        return pager->priv->summary && pager->priv->fetched_count == 0;
+}
+
+/* Advances @pager after retrieving @nodes, taking @next_params */
+static void
+gfbgraph_pager_page_fetched (GFBGraphPager *pager, GPtrArray *nodes, GHashTable *next_params, gboolean want_total, gint64 total_count)
+{
+        GFBGraphPagerPrivate *priv;
+
+        priv = pager->priv;
+
+        if (want_total) {
+                priv->total_count = total_count;
+                priv->first_page_size = nodes->len;
+        }
+
+        g_hash_table_unref (priv->params);
+        priv->params = next_params;
+        priv->done = (next_params == NULL);
+        priv->fetched_count += nodes->len;
+}
+
+/**
+ * gfbgraph_pager_next:
+ * @pager: a #GFBGraphPager.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Retrieves the next page of connected nodes. On error, the same page is requested
+ * again on the next call. It can't be mixed with gfbgraph_pager_next_nodes_async().
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray with the nodes
+ * of the page, or %NULL if there aren't more pages or an error ocurred.
+ **/
+GPtrArray*
+gfbgraph_pager_next (GFBGraphPager *pager, GError **error)
+{
+        GFBGraphPagerPrivate *priv;
+        GHashTable *next_params;
+        GPtrArray *nodes;
+        gboolean want_total;
+        gint64 total_count;
+
+        g_return_val_if_fail (GFBGRAPH_IS_PAGER (pager), NULL);
+        g_return_val_if_fail (!pager->priv->fetching, NULL);
+
+        priv = pager->priv;
+
+        if (priv->done)
+                return NULL;
+
+        want_total = gfbgraph_pager_wants_total (pager);
+        nodes = gfbgraph_node_fetch_connection_page (priv->node, priv->node_type, priv->authorizer,
+                                                     gfbgraph_pager_get_params (pager), &next_params,
+                                                     want_total ? &total_count : NULL,
+                                                     error);
+        if (nodes == NULL)
+                return NULL;
+
+        gfbgraph_pager_page_fetched (pager, nodes, next_params, want_total, total_count);
+
+        return nodes;
+}
+
+static void
+gfbgraph_pager_fetch_data_free (GFBGraphPagerFetchData *data)
+{
+        if (data->nodes)
+                g_ptr_array_unref (data->nodes);
+        if (data->next_params)
+                g_hash_table_unref (data->next_params);
+
+        g_slice_free (GFBGraphPagerFetchData, data);
+}
+
+static void
+gfbgraph_pager_fetch_thread (GSimpleAsyncResult *simple_async, GFBGraphPager *pager, GCancellable *cancellable)
+{
+        GFBGraphPagerPrivate *priv;
+        GFBGraphPagerFetchData *data;
+        GError *error = NULL;
+
+        priv = pager->priv;
+        data = g_simple_async_result_get_op_res_gpointer (simple_async);
+
+        /* The params aren't touched by the main context while fetching */
+        data->nodes = gfbgraph_node_fetch_connection_page (priv->node, priv->node_type, priv->authorizer,
+                                                           priv->params, &data->next_params,
+                                                           data->want_total ? &data->total_count : NULL,
+                                                           &error);
+        if (error != NULL)
+                g_simple_async_result_take_error (simple_async, error);
+}
+
+/* Completes the waiting gfbgraph_pager_next_nodes_async() if there are nodes,
+ * an error or nothing else to retrieve */
+static void
+gfbgraph_pager_complete_waiting (GFBGraphPager *pager, gboolean in_idle)
+{
+        GFBGraphPagerPrivate *priv;
+        GSimpleAsyncResult *waiting;
+        GPtrArray *nodes;
+        gboolean cancelled;
+
+        priv = pager->priv;
+
+        if (priv->waiting == NULL)
+                return;
+
+        cancelled = priv->waiting_cancellable != NULL && g_cancellable_is_cancelled (priv->waiting_cancellable);
+        if (!cancelled && g_queue_is_empty (priv->buffer) && priv->fetch_error == NULL && !priv->done)
+                return;
+
+        waiting = priv->waiting;
+        priv->waiting = NULL;
+        g_clear_object (&priv->waiting_cancellable);
+
+        if (cancelled) {
+                /* The nodes stay buffered for the next call */
+                g_simple_async_result_set_error (waiting, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                 "The operation was cancelled");
+        } else if (g_queue_is_empty (priv->buffer) && priv->fetch_error != NULL) {
+                /* Reported once, the next call retries the same page */
+                g_simple_async_result_take_error (waiting, priv->fetch_error);
+                priv->fetch_error = NULL;
+        } else {
+                nodes = g_ptr_array_new_with_free_func (g_object_unref);
+                while (nodes->len < priv->waiting_max_nodes && !g_queue_is_empty (priv->buffer))
+                        g_ptr_array_add (nodes, g_queue_pop_head (priv->buffer));
+
+                g_simple_async_result_set_op_res_gpointer (waiting, nodes, (GDestroyNotify) g_ptr_array_unref);
+        }
+
+        if (in_idle)
+                g_simple_async_result_complete_in_idle (waiting);
+        else
+                g_simple_async_result_complete (waiting);
+
+        g_object_unref (waiting);
+}
+
+static void gfbgraph_pager_maybe_prefetch (GFBGraphPager *pager);
+
+static void
+gfbgraph_pager_fetch_cb (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+        GFBGraphPager *pager;
+        GFBGraphPagerPrivate *priv;
+        GFBGraphPagerFetchData *data;
+        GError *error = NULL;
+        guint i;
+
+        pager = GFBGRAPH_PAGER (source_object);
+        priv = pager->priv;
+
+        priv->fetching = FALSE;
+
+        if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), &error)) {
+                g_clear_error (&priv->fetch_error);
+                priv->fetch_error = error;
+        } else {
+                data = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (result));
+
+                for (i = 0; i < data->nodes->len; i++)
+                        g_queue_push_tail (priv->buffer, g_object_ref (g_ptr_array_index (data->nodes, i)));
+
+                gfbgraph_pager_page_fetched (pager, data->nodes, data->next_params, data->want_total, data->total_count);
+                data->next_params = NULL;
+
+                /* A page can be empty but not the last one */
+                if (priv->waiting != NULL && g_queue_is_empty (priv->buffer))
+                        gfbgraph_pager_maybe_prefetch (pager);
+        }
+
+        gfbgraph_pager_complete_waiting (pager, FALSE);
+}
+
+/* Requests the next page in the background if the buffer is running low. The
+ * page belongs to the pager rather than to the call that requested it, so it
+ * can't be cancelled. */
+static void
+gfbgraph_pager_maybe_prefetch (GFBGraphPager *pager)
+{
+        GFBGraphPagerPrivate *priv;
+        GSimpleAsyncResult *simple_async;
+        GFBGraphPagerFetchData *data;
+
+        priv = pager->priv;
+
+        if (priv->done || priv->fetching || priv->fetch_error != NULL)
+                return;
+
+        if (g_queue_get_length (priv->buffer) > priv->low_water_mark)
+                return;
+
+        gfbgraph_pager_get_params (pager);
+
+        data = g_slice_new0 (GFBGraphPagerFetchData);
+        data->want_total = gfbgraph_pager_wants_total (pager);
+        data->total_count = -1;
+
+        simple_async = g_simple_async_result_new (G_OBJECT (pager), gfbgraph_pager_fetch_cb, NULL, gfbgraph_pager_maybe_prefetch);
+        g_simple_async_result_set_op_res_gpointer (simple_async, data, (GDestroyNotify) gfbgraph_pager_fetch_data_free);
+
+        priv->fetching = TRUE;
+        gfbgraph_simple_async_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_pager_fetch_thread, NULL);
+
+        g_object_unref (simple_async);
+}
+
+/**
+ * gfbgraph_pager_next_nodes_async:
+ * @pager: a #GFBGraphPager.
+ * @max_nodes: the maximum number of nodes to retrieve, greater than 0.
+ * @cancellable: (allow-none): a #GCancellable or %NULL.
+ * @callback: a #GAsyncReadyCallback to call when the nodes are available.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Asynchronously retrieves up to @max_nodes of the next connected nodes, following the
+ * pages as needed. The nodes already buffered are returned without waiting, and the next
+ * page is requested in the background when the buffer drops to the
+ * #GFBGraphPager:low-water-mark. Only one call can be in progress at a time, and it must
+ * be done from the same main context than the previous ones.
+ *
+ * The pages are requested in the background for the pager, not for a single call, so
+ * @cancellable doesn't cancel them. It's checked when the call would complete instead:
+ * if it was cancelled by then, the call fails with %G_IO_ERROR_CANCELLED and the
+ * nodes stay buffered for the next call. As a call waiting for a page only completes
+ * once the page arrives, the cancellation isn't reported any earlier.
+ **/
+void
+gfbgraph_pager_next_nodes_async (GFBGraphPager *pager, guint max_nodes, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+        GFBGraphPagerPrivate *priv;
+
+        g_return_if_fail (GFBGRAPH_IS_PAGER (pager));
+        g_return_if_fail (max_nodes > 0);
+        g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+        g_return_if_fail (callback != NULL);
+
+        priv = pager->priv;
+
+        if (priv->waiting != NULL) {
+                g_simple_async_report_error_in_idle (G_OBJECT (pager), callback, user_data,
+                                                     G_IO_ERROR, G_IO_ERROR_PENDING,
+                                                     "The previous nodes haven't been retrieved yet");
+                return;
+        }
+
+        priv->waiting = g_simple_async_result_new (G_OBJECT (pager), callback, user_data, gfbgraph_pager_next_nodes_async);
+        priv->waiting_max_nodes = max_nodes;
+        if (cancellable != NULL)
+                priv->waiting_cancellable = g_object_ref (cancellable);
+
+        gfbgraph_pager_complete_waiting (pager, TRUE);
+        gfbgraph_pager_maybe_prefetch (pager);
+}
+
+/**
+ * gfbgraph_pager_next_nodes_finish:
+ * @pager: a #GFBGraphPager.
+ * @result: a #GAsyncResult.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Finishes an operation started with gfbgraph_pager_next_nodes_async().
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray with the next
+ * nodes, empty when all of them were retrieved, or %NULL if an error ocurred.
+ **/
+GPtrArray*
+gfbgraph_pager_next_nodes_finish (GFBGraphPager *pager, GAsyncResult *result, GError **error)
+{
+        GSimpleAsyncResult *simple_async;
+
+        g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (pager), gfbgraph_pager_next_nodes_async), NULL);
+        g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+        simple_async = G_SIMPLE_ASYNC_RESULT (result);
+
+        if (g_simple_async_result_propagate_error (simple_async, error))
+                return NULL;
+
+        return g_ptr_array_ref (g_simple_async_result_get_op_res_gpointer (simple_async));
+}
+
+/**
+ * gfbgraph_pager_is_done:
+ * @pager: a #GFBGraphPager.
+ *
+ * Returns: %TRUE if all the pages were retrieved.
+ **/
+gboolean
+gfbgraph_pager_is_done (GFBGraphPager *pager)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_PAGER (pager), TRUE);
+
+        return pager->priv->done;
+}
+
+/**
+ * gfbgraph_pager_get_total_count:
+ * @pager: a #GFBGraphPager.
+ *
+ * Gets the total number of connected nodes reported by the summary of the connection.
+ * It's only known after retrieving the first page with the #GFBGraphPager:summary
+ * property set.
+ *
+ * Returns: the number of connected nodes, or -1 if unknown.
+ **/
+gint64
+gfbgraph_pager_get_total_count (GFBGraphPager *pager)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_PAGER (pager), -1);
+
+        return pager->priv->total_count;
+}
+
+/**
+ * gfbgraph_pager_get_fetched_count:
+ * @pager: a #GFBGraphPager.
+ *
+ * Returns: the number of nodes retrieved so far.
+ **/
+guint
+gfbgraph_pager_get_fetched_count (GFBGraphPager *pager)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_PAGER (pager), 0);
+
+        return pager->priv->fetched_count;
+}
+
+/**
+ * gfbgraph_pager_get_n_pages:
+ * @pager: a #GFBGraphPager.
+ *
+ * Estimates the number of pages of the connection from its total count and the size
+ * of the first page. The Graph API can return shorter pages than requested, so it's
+ * a lower bound.
+ *
+ * Returns: the estimated number of pages, or -1 if the total count is unknown.
+ **/
+gint
+gfbgraph_pager_get_n_pages (GFBGraphPager *pager)
+{
+        GFBGraphPagerPrivate *priv;
+        guint page_size;
+
+        g_return_val_if_fail (GFBGRAPH_IS_PAGER (pager), -1);
+
+        priv = pager->priv;
+
+        if (priv->total_count < 0)
+                return -1;
+
+        page_size = priv->page_size > 0 ? priv->page_size : priv->first_page_size;
+        if (priv->total_count == 0 || page_size == 0)
+                return priv->total_count == 0 ? 0 : 1;
+
+        return (gint) ((priv->total_count + page_size - 1) / page_size);
+}
@@ -0,0 +1,72 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_PAGER_H__
+#define __GFBGRAPH_PAGER_H__
+
+#include <glib-object.h>
+#include <gfbgraph/gfbgraph-authorizer.h>
+#include <gfbgraph/gfbgraph-node.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_PAGER             (gfbgraph_pager_get_type())
+#define GFBGRAPH_PAGER(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GFBGRAPH_TYPE_PAGER,GFBGraphPager))
+#define GFBGRAPH_PAGER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass),GFBGRAPH_TYPE_PAGER,GFBGraphPagerClass))
+#define GFBGRAPH_IS_PAGER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj),GFBGRAPH_TYPE_PAGER))
+#define GFBGRAPH_IS_PAGER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass),GFBGRAPH_TYPE_PAGER))
+#define GFBGRAPH_PAGER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj),GFBGRAPH_TYPE_PAGER,GFBGraphPagerClass))
+
+typedef struct _GFBGraphPager        GFBGraphPager;
+typedef struct _GFBGraphPagerClass   GFBGraphPagerClass;
+typedef struct _GFBGraphPagerPrivate GFBGraphPagerPrivate;
+
+struct _GFBGraphPager {
+        GObject parent;
+
+        /*< private >*/
+        GFBGraphPagerPrivate *priv;
+};
+
+struct _GFBGraphPagerClass {
+        GObjectClass parent_class;
+};
+
+GType          gfbgraph_pager_get_type          (void) G_GNUC_CONST;
+GFBGraphPager* gfbgraph_pager_new               (GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer);
+
+GPtrArray*     gfbgraph_pager_next              (GFBGraphPager *pager, GError **error);
+gboolean       gfbgraph_pager_is_done           (GFBGraphPager *pager);
+
+void           gfbgraph_pager_next_nodes_async  (GFBGraphPager       *pager,
+                                                 guint                max_nodes,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data);
+GPtrArray*     gfbgraph_pager_next_nodes_finish (GFBGraphPager       *pager,
+                                                 GAsyncResult        *result,
+                                                 GError             **error);
+
+gint64         gfbgraph_pager_get_total_count   (GFBGraphPager *pager);
+guint          gfbgraph_pager_get_fetched_count (GFBGraphPager *pager);
+gint           gfbgraph_pager_get_n_pages       (GFBGraphPager *pager);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_PAGER_H__ */
@@ -29,12 +29,9 @@
 #include "gfbgraph-photo.h"
 #include "gfbgraph-connectable.h"
 #include "gfbgraph-album.h"
+#include "gfbgraph-private.h"
 
 #include <json-glib/json-glib.h>
-#include <libsoup/soup.h>
-#include <libsoup/soup-request.h>
-#include <libsoup/soup-request-http.h>
-#include <libsoup/soup-requester.h>
 
 enum {
         PROP_0,
@@ -51,8 +48,14 @@ struct _GFBGraphPhotoPrivate {
         gchar              *source;
         guint               width;
         guint               height;
-        GList              *images;
-        GFBGraphPhotoImage *hires_image;
+
+        /* The image variants, sorted by width, plus their indexes sorted by height */
+        GFBGraphPhotoImage *images;
+        guint               n_images;
+        guint              *height_index;
+
+        /* Built on demand for gfbgraph_photo_get_images() */
+        GList              *images_list;
 };
 
 static void gfbgraph_photo_init         (GFBGraphPhoto *obj);
@@ -61,6 +64,12 @@ static void gfbgraph_photo_finalize     (GObject *obj);
 static void gfbgraph_photo_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
 static void gfbgraph_photo_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
 
+static gboolean gfbgraph_photo_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node);
+static void     gfbgraph_photo_serialize_members  (GFBGraphNode *node, JsonBuilder *builder);
+static GFBGraphPhotoImage* gfbgraph_photo_parse_images (GFBGraphNode *node, JsonNode *images_node, guint *n_images);
+static void     gfbgraph_photo_set_images         (GFBGraphPhoto *photo, GFBGraphPhotoImage *images, guint n_images);
+static void     gfbgraph_photo_clear_images       (GFBGraphPhoto *photo);
+
 static void gfbgraph_photo_connectable_iface_init     (GFBGraphConnectableInterface *iface);
 GHashTable* gfbgraph_photo_get_connection_post_params (GFBGraphConnectable *self, GType node_type);
 
@@ -86,18 +95,23 @@ gfbgraph_photo_init (GFBGraphPhoto *obj)
         obj->priv = GFBGRAPH_PHOTO_GET_PRIVATE(obj);
 
         obj->priv->images = NULL;
+        obj->priv->n_images = 0;
 }
 
 static void
 gfbgraph_photo_class_init (GFBGraphPhotoClass *klass)
 {
         GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+        GFBGraphNodeClass *node_class = GFBGRAPH_NODE_CLASS (klass);
 
         parent_class            = g_type_class_peek_parent (klass);
         gobject_class->finalize = gfbgraph_photo_finalize;
         gobject_class->set_property = gfbgraph_photo_set_property;
         gobject_class->get_property = gfbgraph_photo_get_property;
 
+        node_class->deserialize_member = gfbgraph_photo_deserialize_member;
+        node_class->serialize_members = gfbgraph_photo_serialize_members;
+
         g_type_class_add_private (gobject_class, sizeof(GFBGraphPhotoPrivate));
 
         /**
@@ -151,7 +165,10 @@ gfbgraph_photo_class_init (GFBGraphPhotoClass *klass)
         /**
          * GFBGraphPhoto:images:
          *
-         * A list with the available representations of the photo, in differents sizes
+         * A #GList of #GFBGraphPhotoImage with the available representations of the photo,
+         * in differents sizes. The list got is owned by the photo, like the one of
+         * gfbgraph_photo_get_images(), and is valid until the images change. The photo
+         * keeps a copy of the list set, which stays owned by the caller.
          **/
         g_object_class_install_property (gobject_class,
                                          PROP_IMAGES,
@@ -164,24 +181,13 @@ static void
 gfbgraph_photo_finalize (GObject *obj)
 {
         GFBGraphPhotoPrivate *priv;
-        GList *images;
-        GFBGraphPhotoImage *photo_image;
 
         priv = GFBGRAPH_PHOTO_GET_PRIVATE (obj);
 
-        images = priv->images;
-        while (images) {
-                photo_image = (GFBGraphPhotoImage *) images->data;
-
-                g_free (photo_image->source);
-                g_free (photo_image);
-
-                images = g_list_next (images);
-        }
+        gfbgraph_photo_clear_images (GFBGRAPH_PHOTO (obj));
 
-        g_free (priv->name);
-        g_free (priv->source);
-        g_list_free (priv->images);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->name);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->source);
 
         G_OBJECT_CLASS(parent_class)->finalize (obj);
 }
@@ -193,16 +199,18 @@ gfbgraph_photo_set_property (GObject *object, guint prop_id, const GValue *value
 
         priv = GFBGRAPH_PHOTO_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+        if (!gfbgraph_node_check_writable (GFBGRAPH_NODE (object)))
+                return;
+
         switch (prop_id) {
                 case PROP_NAME:
-                        if (priv->name)
-                                g_free (priv->name);
-                        priv->name = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->name);
+                        priv->name = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_SOURCE:
-                        if (priv->source)
-                                g_free (priv->source);
-                        priv->source = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->source);
+                        priv->source = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_WIDTH:
                         priv->width = g_value_get_uint (value);
@@ -210,10 +218,27 @@ gfbgraph_photo_set_property (GObject *object, guint prop_id, const GValue *value
                 case PROP_HEIGHT:
                         priv->height = g_value_get_uint (value);
                         break;
-                case PROP_IMAGES:
-                        /* TODO: Free GList memory with g_list_free_full */
-                        priv->images = g_value_get_pointer (value);
+                case PROP_IMAGES: {
+                        GList *images_list;
+                        GFBGraphPhotoImage *images;
+                        guint i;
+
+                        /* Copied before the current images are released, as the list
+                         * can be the one got from this same photo */
+                        images_list = g_value_get_pointer (value);
+                        images = g_new (GFBGraphPhotoImage, g_list_length (images_list));
+                        for (i = 0; images_list != NULL; i++, images_list = images_list->next) {
+                                const GFBGraphPhotoImage *image = images_list->data;
+
+                                images[i].width = image->width;
+                                images[i].height = image->height;
+                                images[i].source = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), image->source);
+                        }
+
+                        /* Drops the cached list too */
+                        gfbgraph_photo_set_images (GFBGRAPH_PHOTO (object), images, i);
                         break;
+                }
                 default:
                         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
                         break;
@@ -227,6 +252,8 @@ gfbgraph_photo_get_property (GObject *object, guint prop_id, GValue *value, GPar
 
         priv = GFBGRAPH_PHOTO_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+
         switch (prop_id) {
                 case PROP_NAME:
                         g_value_set_string (value, priv->name);
@@ -241,13 +268,178 @@ gfbgraph_photo_get_property (GObject *object, guint prop_id, GValue *value, GPar
                         g_value_set_uint (value, priv->height);
                         break;
                 case PROP_IMAGES:
-                        g_value_set_pointer (value, priv->images);
+                        g_value_set_pointer (value, gfbgraph_photo_get_images (GFBGRAPH_PHOTO (object)));
+                        break;
                 default:
                         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
                         break;
         }
 }
 
+static gboolean
+gfbgraph_photo_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node)
+{
+        GFBGraphPhotoPrivate *priv;
+
+        priv = GFBGRAPH_PHOTO (node)->priv;
+
+        if (g_strcmp0 (member_name, "name") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->name);
+        else if (g_strcmp0 (member_name, "source") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->source);
+        else if (g_strcmp0 (member_name, "width") == 0)
+                return gfbgraph_node_deserialize_uint (node, member_node, &priv->width);
+        else if (g_strcmp0 (member_name, "height") == 0)
+                return gfbgraph_node_deserialize_uint (node, member_node, &priv->height);
+        else if (g_strcmp0 (member_name, "images") == 0) {
+                GFBGraphPhotoImage *images;
+                guint n_images;
+
+                if (JSON_NODE_HOLDS_ARRAY (member_node) == FALSE) {
+                        g_warning ("The 'images' node retrieved from the Facebook Graph API isn't an array, it's holding a %s", json_node_type_name (member_node));
+                        return TRUE;
+                }
+
+                images = gfbgraph_photo_parse_images (node, member_node, &n_images);
+                gfbgraph_photo_set_images (GFBGRAPH_PHOTO (node), images, n_images);
+                return TRUE;
+        }
+
+        return parent_class->deserialize_member (node, member_name, member_node);
+}
+
+static void
+gfbgraph_photo_serialize_members (GFBGraphNode *node, JsonBuilder *builder)
+{
+        GFBGraphPhotoPrivate *priv;
+
+        priv = GFBGRAPH_PHOTO (node)->priv;
+
+        parent_class->serialize_members (node, builder);
+
+        gfbgraph_node_serialize_string (builder, "name", priv->name);
+        gfbgraph_node_serialize_string (builder, "source", priv->source);
+        gfbgraph_node_serialize_uint (builder, "width", priv->width);
+        gfbgraph_node_serialize_uint (builder, "height", priv->height);
+
+        if (priv->n_images > 0) {
+                guint i;
+
+                json_builder_set_member_name (builder, "images");
+                json_builder_begin_array (builder);
+                for (i = 0; i < priv->n_images; i++) {
+                        json_builder_begin_object (builder);
+                        json_builder_set_member_name (builder, "width");
+                        json_builder_add_int_value (builder, priv->images[i].width);
+                        json_builder_set_member_name (builder, "height");
+                        json_builder_add_int_value (builder, priv->images[i].height);
+                        gfbgraph_node_serialize_string (builder, "source", priv->images[i].source);
+                        json_builder_end_object (builder);
+                }
+                json_builder_end_array (builder);
+        }
+}
+
+static GFBGraphPhotoImage*
+gfbgraph_photo_parse_images (GFBGraphNode *node, JsonNode *images_node, guint *n_images)
+{
+        guint i, num_images;
+        JsonArray *jarray;
+        GFBGraphPhotoImage *images;
+
+        jarray = json_node_get_array (images_node);
+        num_images = json_array_get_length (jarray);
+        images = g_new (GFBGraphPhotoImage, num_images);
+        for (i = 0; i < num_images; i++) {
+                JsonObject *image_object;
+
+                image_object = json_array_get_object_element (jarray, i);
+                images[i].width = json_object_get_int_member (image_object, "width");
+                images[i].height = json_object_get_int_member (image_object, "height");
+                if (node != NULL)
+                        images[i].source = gfbgraph_node_dup_string (node, json_object_get_string_member (image_object, "source"));
+                else
+                        images[i].source = g_strdup (json_object_get_string_member (image_object, "source"));
+        }
+
+        *n_images = num_images;
+
+        return images;
+}
+
+static gint
+gfbgraph_photo_compare_image_width (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+        const GFBGraphPhotoImage *image_a = a;
+        const GFBGraphPhotoImage *image_b = b;
+
+        if (image_a->width != image_b->width)
+                return (image_a->width < image_b->width) ? -1 : 1;
+
+        return (image_a->height < image_b->height) ? -1 : (image_a->height > image_b->height);
+}
+
+static gint
+gfbgraph_photo_compare_image_height (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+        const GFBGraphPhotoImage *images = user_data;
+        const GFBGraphPhotoImage *image_a = &images[*((const guint *) a)];
+        const GFBGraphPhotoImage *image_b = &images[*((const guint *) b)];
+
+        if (image_a->height != image_b->height)
+                return (image_a->height < image_b->height) ? -1 : 1;
+
+        return (image_a->width < image_b->width) ? -1 : (image_a->width > image_b->width);
+}
+
+/* Takes the ownership of @images, replacing the current ones */
+static void
+gfbgraph_photo_set_images (GFBGraphPhoto *photo, GFBGraphPhotoImage *images, guint n_images)
+{
+        GFBGraphPhotoPrivate *priv;
+        guint i;
+
+        priv = photo->priv;
+
+        gfbgraph_photo_clear_images (photo);
+
+        if (n_images == 0) {
+                g_free (images);
+                return;
+        }
+
+        g_qsort_with_data (images, n_images, sizeof (GFBGraphPhotoImage), gfbgraph_photo_compare_image_width, NULL);
+
+        priv->height_index = g_new (guint, n_images);
+        for (i = 0; i < n_images; i++)
+                priv->height_index[i] = i;
+        g_qsort_with_data (priv->height_index, n_images, sizeof (guint), gfbgraph_photo_compare_image_height, images);
+
+        priv->images = images;
+        priv->n_images = n_images;
+}
+
+static void
+gfbgraph_photo_clear_images (GFBGraphPhoto *photo)
+{
+        GFBGraphPhotoPrivate *priv;
+        guint i;
+
+        priv = photo->priv;
+
+        for (i = 0; i < priv->n_images; i++)
+                gfbgraph_node_free_string (GFBGRAPH_NODE (photo), priv->images[i].source);
+
+        g_free (priv->images);
+        g_free (priv->height_index);
+        g_list_free (priv->images_list);
+
+        priv->images = NULL;
+        priv->n_images = 0;
+        priv->height_index = NULL;
+        priv->images_list = NULL;
+}
+
 static void
 gfbgraph_photo_connectable_iface_init (GFBGraphConnectableInterface *iface)
 {
@@ -258,7 +450,7 @@ gfbgraph_photo_connectable_iface_init (GFBGraphConnectableInterface *iface)
 
         iface->connections = connections;
         iface->get_connection_post_params = gfbgraph_photo_get_connection_post_params;
-        iface->parse_connected_data = gfbgraph_connectable_default_parse_connected_data;
+        iface->parse_connected_data_array = gfbgraph_connectable_default_parse_connected_data_array;
 }
 
 GHashTable*
@@ -269,6 +461,8 @@ gfbgraph_photo_get_connection_post_params (GFBGraphConnectable *self, GType node
 
         priv = GFBGRAPH_PHOTO_GET_PRIVATE (self);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (self));
+
         params = g_hash_table_new (g_str_hash, g_str_equal);
         g_hash_table_insert (params, "message", priv->name);
         /* TODO: Incorpate the "source" param (multipart/form-data) */
@@ -292,9 +486,26 @@ gfbgraph_photo_serializable_serialize_property (JsonSerializable *serializable,
 {
         JsonNode *node = NULL;
 
-        g_print ("Serializing %s\n", property_name);
-
         if (g_strcmp0 ("images", property_name) == 0) {
+                GFBGraphPhotoPrivate *priv;
+                JsonArray *jarray;
+                guint i;
+
+                priv = GFBGRAPH_PHOTO (serializable)->priv;
+
+                jarray = json_array_sized_new (priv->n_images);
+                for (i = 0; i < priv->n_images; i++) {
+                        JsonObject *image_object;
+
+                        image_object = json_object_new ();
+                        json_object_set_int_member (image_object, "width", priv->images[i].width);
+                        json_object_set_int_member (image_object, "height", priv->images[i].height);
+                        json_object_set_string_member (image_object, "source", priv->images[i].source);
+                        json_array_add_object_element (jarray, image_object);
+                }
+
+                node = json_node_new (JSON_NODE_ARRAY);
+                json_node_take_array (node, jarray);
         } else {
                 node = json_serializable_default_serialize_property (serializable, property_name, value, pspec);
         }
@@ -309,27 +520,19 @@ gfbgraph_photo_serializable_deserialize_property (JsonSerializable *serializable
 
         if (g_strcmp0 ("images", property_name) == 0) {
                 if (JSON_NODE_HOLDS_ARRAY (property_node)) {
-                        guint i, num_images;
-                        JsonArray *jarray;
-                        GList *images;
-
-                        images = NULL;
-                        jarray = json_node_get_array (property_node);
-                        num_images = json_array_get_length (jarray);
-                        for (i = 0; i < num_images; i++) {
-                                JsonObject *image_object;
-                                GFBGraphPhotoImage *photo_image;
-
-                                image_object = json_array_get_object_element (jarray, i);
-                                photo_image = g_new0 (GFBGraphPhotoImage, 1);
-                                photo_image->width = json_object_get_int_member (image_object, "width");
-                                photo_image->height = json_object_get_int_member (image_object, "height");
-                                photo_image->source = g_strdup (json_object_get_string_member (image_object, "source"));
-
-                                images = g_list_append (images, photo_image);
-                        }
-
-                        g_value_set_pointer (value, (gpointer *) images);
+                        GFBGraphPhotoImage *images;
+                        GList *images_list;
+                        guint i, n_images;
+
+                        /* The "images" property copies the list, this one is
+                         * freed once set, see gfbgraph_photo_serializable_set_property() */
+                        images = gfbgraph_photo_parse_images (NULL, property_node, &n_images);
+                        images_list = NULL;
+                        for (i = n_images; i > 0; i--)
+                                images_list = g_list_prepend (images_list, g_memdup (&images[i - 1], sizeof (GFBGraphPhotoImage)));
+                        g_free (images);
+
+                        g_value_set_pointer (value, images_list);
                         res = TRUE;
                 } else {
                         g_warning ("The 'images' node retrieved from the Facebook Graph API isn't an array, it's holding a %s\n", json_node_type_name (property_node));
@@ -358,6 +561,19 @@ void
 gfbgraph_photo_serializable_set_property (JsonSerializable *serializable, GParamSpec *pspec, const GValue *value)
 {
         g_object_set_property (G_OBJECT (serializable), g_param_spec_get_name (pspec), value);
+
+        /* The list built by gfbgraph_photo_serializable_deserialize_property() */
+        if (g_strcmp0 (g_param_spec_get_name (pspec), "images") == 0) {
+                GList *images_list;
+                GList *l;
+
+                images_list = g_value_get_pointer (value);
+                for (l = images_list; l != NULL; l = l->next) {
+                        g_free (((GFBGraphPhotoImage *) l->data)->source);
+                        g_free (l->data);
+                }
+                g_list_free (images_list);
+        }
 }
 
 void
@@ -403,18 +619,14 @@ gfbgraph_photo_new_from_id (GFBGraphAuthorizer *authorizer, const gchar *id, GEr
  * @error: (allow-none): a #GError or %NULL.
  *
  * Download the default sized photo pointed by @photo, with a maximum width or height of 720px.
- * The photo always is a JPEG.
+ * The photo always is a JPEG. It's read from the image cache when enabled, see
+ * gfbgraph_set_image_cache().
  *
  * Returns: (transfer full): a #GInputStream with the photo content or %NULL in case of error.
  **/
 GInputStream*
 gfbgraph_photo_download_default_size (GFBGraphPhoto *photo, GFBGraphAuthorizer *authorizer, GError **error)
 {
-        GInputStream *stream = NULL;
-        SoupSession *session;
-        SoupRequester *requester;
-        SoupRequest *request;
-        SoupMessage *message;
         GFBGraphPhotoPrivate *priv;
 
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
@@ -422,26 +634,108 @@ gfbgraph_photo_download_default_size (GFBGraphPhoto *photo, GFBGraphAuthorizer *
 
         priv = GFBGRAPH_PHOTO_GET_PRIVATE (photo);
 
-        session = soup_session_sync_new ();
-        requester = soup_requester_new ();
-        soup_session_add_feature (session, SOUP_SESSION_FEATURE (requester));
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
+        return gfbgraph_image_cache_download (authorizer, gfbgraph_node_get_id (GFBGRAPH_NODE (photo)),
+                                              priv->width, priv->height, priv->source, error);
+}
+
+/**
+ * gfbgraph_photo_download_image:
+ * @photo: a #GFBGraphPhoto.
+ * @image: one of the #GFBGraphPhotoImage of @photo.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Download the @image variant of @photo, like one returned by gfbgraph_photo_get_image_near_width().
+ * It's read from the image cache when enabled, see gfbgraph_set_image_cache().
+ *
+ * Returns: (transfer full): a #GInputStream with the image content or %NULL in case of error.
+ **/
+GInputStream*
+gfbgraph_photo_download_image (GFBGraphPhoto *photo, const GFBGraphPhotoImage *image, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
+        g_return_val_if_fail (image != NULL && image->source != NULL, NULL);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
+
+        return gfbgraph_image_cache_download (authorizer, gfbgraph_node_get_id (GFBGRAPH_NODE (photo)),
+                                              image->width, image->height, image->source, error);
+}
+
+/**
+ * gfbgraph_photo_prefetch:
+ * @photos: (element-type GFBGraphPhoto): a #GList of #GFBGraphPhoto.
+ * @width: the desired image width, or 0 for the default size.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @cancellable: (allow-none): An optional #GCancellable object, or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Downloads into the image cache the image of each photo in @photos with the width nearest
+ * to @width, skipping the ones already cached, so later downloads don't wait for the network.
+ * Does nothing if the image cache isn't enabled, see gfbgraph_set_image_cache().
+ *
+ * A failed image doesn't stop the rest, but only the first error is reported.
+ *
+ * Returns: %TRUE if all the images are in the cache, %FALSE otherwise.
+ **/
+gboolean
+gfbgraph_photo_prefetch (GList *photos, guint width, GFBGraphAuthorizer *authorizer, GCancellable *cancellable, GError **error)
+{
+        GError *first_error = NULL;
+        GList *l;
+
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), FALSE);
+
+        for (l = photos; l != NULL; l = l->next) {
+                GFBGraphPhoto *photo;
+                const GFBGraphPhotoImage *image = NULL;
+                GError *photo_error = NULL;
+                const gchar *source;
+                guint image_width, image_height;
+
+                if (g_cancellable_set_error_if_cancelled (cancellable, &photo_error)) {
+                        g_clear_error (&first_error);
+                        first_error = photo_error;
+                        break;
+                }
+
+                g_return_val_if_fail (GFBGRAPH_IS_PHOTO (l->data), FALSE);
+                photo = GFBGRAPH_PHOTO (l->data);
 
-        request = soup_requester_request (requester, priv->source, error);
-        if (request != NULL) {
-                message = soup_request_http_get_message (SOUP_REQUEST_HTTP (request));
+                gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
 
-                stream = soup_request_send (request, NULL, error);
-                if (stream != NULL) {
-                        g_object_weak_ref (G_OBJECT (stream), (GWeakNotify) g_object_unref, session);
+                if (width > 0)
+                        image = gfbgraph_photo_get_image_near_width (photo, width);
+
+                if (image != NULL) {
+                        source = image->source;
+                        image_width = image->width;
+                        image_height = image->height;
+                } else {
+                        source = photo->priv->source;
+                        image_width = photo->priv->width;
+                        image_height = photo->priv->height;
                 }
 
-                g_clear_object (&message);
-                g_clear_object (&request);
+                if (source == NULL || gfbgraph_node_get_id (GFBGRAPH_NODE (photo)) == NULL)
+                        continue;
+
+                if (!gfbgraph_image_cache_prefetch (authorizer, gfbgraph_node_get_id (GFBGRAPH_NODE (photo)),
+                                                    image_width, image_height, source, &photo_error)) {
+                        if (first_error == NULL)
+                                first_error = photo_error;
+                        else
+                                g_error_free (photo_error);
+                }
         }
 
-        g_clear_object (&requester);
+        if (first_error != NULL) {
+                g_propagate_error (error, first_error);
+                return FALSE;
+        }
 
-        return stream;
+        return TRUE;
 }
 
 /**
@@ -455,6 +749,8 @@ gfbgraph_photo_get_name (GFBGraphPhoto *photo)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
         return photo->priv->name;
 }
 
@@ -469,6 +765,8 @@ gfbgraph_photo_get_default_source_uri (GFBGraphPhoto *photo)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
         return photo->priv->source;
 }
 
@@ -483,6 +781,8 @@ gfbgraph_photo_get_default_width (GFBGraphPhoto *photo)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), 0);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
         return photo->priv->width;
 }
 
@@ -497,6 +797,8 @@ gfbgraph_photo_get_default_height (GFBGraphPhoto *photo)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), 0);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
         return photo->priv->height;
 }
 
@@ -504,12 +806,54 @@ gfbgraph_photo_get_default_height (GFBGraphPhoto *photo)
  * gfbgraph_photo_get_images:
  * @photo: a #GFBGraphPhoto.
  *
- * Returns: (element-type GFBGraphPhotoImage) (transfer none): a #GList of #GFBGraphPhotoImage with the available photo sizes
+ * Returns: (element-type GFBGraphPhotoImage) (transfer none): a #GList of #GFBGraphPhotoImage with the available photo sizes,
+ * sorted by width. Use gfbgraph_photo_get_images_array() to avoid the list allocation.
  **/
 GList*
 gfbgraph_photo_get_images (GFBGraphPhoto *photo)
+{
+        GFBGraphPhotoPrivate *priv;
+        guint i;
+
+        g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
+
+        priv = photo->priv;
+
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
+        if (g_atomic_pointer_get (&priv->images_list) == NULL && priv->n_images > 0) {
+                GList *images_list = NULL;
+
+                for (i = priv->n_images; i > 0; i--)
+                        images_list = g_list_prepend (images_list, &priv->images[i - 1]);
+
+                /* Frozen photos are read from many threads, the first list built wins */
+                if (!g_atomic_pointer_compare_and_exchange (&priv->images_list, NULL, images_list))
+                        g_list_free (images_list);
+        }
+
+        return g_atomic_pointer_get (&priv->images_list);
+}
+
+/**
+ * gfbgraph_photo_get_images_array:
+ * @photo: a #GFBGraphPhoto.
+ * @n_images: (out): return location for the number of images.
+ *
+ * Gets the available photo sizes, sorted by width, from the smaller to the bigger one.
+ *
+ * Returns: (array length=n_images) (transfer none): an array of #GFBGraphPhotoImage owned by @photo, or %NULL
+ * if there aren't images.
+ **/
+const GFBGraphPhotoImage*
+gfbgraph_photo_get_images_array (GFBGraphPhoto *photo, guint *n_images)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
+        g_return_val_if_fail (n_images != NULL, NULL);
+
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
+        *n_images = photo->priv->n_images;
 
         return photo->priv->images;
 }
@@ -525,81 +869,114 @@ gfbgraph_photo_get_image_hires (GFBGraphPhoto *photo)
 {
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
 
-        if (photo->priv->hires_image == NULL) {
-                GList *images_list;
-                guint bigger_width;
-                GFBGraphPhotoImage *photo_image;
-
-                bigger_width = 0;
-                images_list = photo->priv->images;
-                while (images_list) {
-                        photo_image = (GFBGraphPhotoImage *) images_list->data;
-                        if (photo_image->width > bigger_width) {
-                                photo->priv->hires_image = photo_image;
-                                bigger_width = photo_image->width;
-                        }
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
 
-                        images_list = g_list_next (images_list);
-                }
+        if (photo->priv->n_images == 0)
+                return NULL;
+
+        return &photo->priv->images[photo->priv->n_images - 1];
+}
+
+/* Returns the position of the first element not lesser than @size in @n
+ * sizes sorted in ascending order, taking each one with @get_size */
+static guint
+gfbgraph_photo_lower_bound (GFBGraphPhotoPrivate *priv, guint size, guint (*get_size) (GFBGraphPhotoPrivate *priv, guint i))
+{
+        guint low, high, mid;
+
+        low = 0;
+        high = priv->n_images;
+        while (low < high) {
+                mid = low + (high - low) / 2;
+                if (get_size (priv, mid) < size)
+                        low = mid + 1;
+                else
+                        high = mid;
         }
 
-        return photo->priv->hires_image;
+        return low;
+}
+
+/* Picks between the positions around @pos the nearest one to @size. On a tie
+ * the bigger one wins, so the image doesn't need to be scaled up. */
+static guint
+gfbgraph_photo_nearest (GFBGraphPhotoPrivate *priv, guint size, guint pos, guint (*get_size) (GFBGraphPhotoPrivate *priv, guint i))
+{
+        if (pos == priv->n_images)
+                return pos - 1;
+        if (pos == 0)
+                return pos;
+
+        if (size - get_size (priv, pos - 1) < get_size (priv, pos) - size)
+                return pos - 1;
+
+        return pos;
+}
+
+static guint
+gfbgraph_photo_image_width (GFBGraphPhotoPrivate *priv, guint i)
+{
+        return priv->images[i].width;
+}
+
+static guint
+gfbgraph_photo_image_height (GFBGraphPhotoPrivate *priv, guint i)
+{
+        return priv->images[priv->height_index[i]].height;
 }
 
+/**
+ * gfbgraph_photo_get_image_near_width:
+ * @photo: a #GFBGraphPhoto.
+ * @width: the desired width.
+ *
+ * Returns: (transfer none): the #GFBGraphPhotoImage with the width nearest to @width, or %NULL.
+ **/
 const GFBGraphPhotoImage*
 gfbgraph_photo_get_image_near_width (GFBGraphPhoto *photo, guint width)
 {
-        GList *images_list;
-        GFBGraphPhotoImage *tmp_photo_image;
-        GFBGraphPhotoImage *photo_image;
-        gint tmp_w_dif, w_dif;
+        GFBGraphPhotoPrivate *priv;
+        guint pos;
 
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
 
-        photo_image = NULL;
-        images_list = photo->priv->images;
-        while (images_list) {
-                tmp_photo_image = (GFBGraphPhotoImage *) images_list->data;
-                tmp_w_dif = tmp_photo_image->width - width;
-                tmp_w_dif = (tmp_w_dif > 0) ? tmp_w_dif : (tmp_w_dif * -1);
-
-                if (photo_image == NULL
-                    || tmp_w_dif < w_dif) {
-                        w_dif = tmp_w_dif;
-                        photo_image = tmp_photo_image;
-                } else {
-                }
+        priv = photo->priv;
 
-                images_list = g_list_next (images_list);
-        }
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
+
+        if (priv->n_images == 0)
+                return NULL;
+
+        pos = gfbgraph_photo_lower_bound (priv, width, gfbgraph_photo_image_width);
+        pos = gfbgraph_photo_nearest (priv, width, pos, gfbgraph_photo_image_width);
 
-        return photo_image;
+        return &priv->images[pos];
 }
 
+/**
+ * gfbgraph_photo_get_image_near_height:
+ * @photo: a #GFBGraphPhoto.
+ * @height: the desired height.
+ *
+ * Returns: (transfer none): the #GFBGraphPhotoImage with the height nearest to @height, or %NULL.
+ **/
 const GFBGraphPhotoImage*
 gfbgraph_photo_get_image_near_height (GFBGraphPhoto *photo, guint height)
 {
-        GList *images_list;
-        GFBGraphPhotoImage *tmp_photo_image;
-        GFBGraphPhotoImage *photo_image;
-        gint tmp_h_dif, h_dif;
+        GFBGraphPhotoPrivate *priv;
+        guint pos;
 
         g_return_val_if_fail (GFBGRAPH_IS_PHOTO (photo), NULL);
 
-        photo_image = NULL;
-        images_list = photo->priv->images;
-        while (images_list) {
-                tmp_photo_image = (GFBGraphPhotoImage *) images_list->data;
-                tmp_h_dif = ABS(tmp_photo_image->height - height);
+        priv = photo->priv;
 
-                if (photo_image == NULL
-                    || tmp_h_dif < h_dif) {
-                        h_dif = tmp_h_dif;
-                        photo_image = tmp_photo_image;
-                }
+        gfbgraph_node_materialize (GFBGRAPH_NODE (photo));
 
-                images_list = g_list_next (images_list);
-        }
+        if (priv->n_images == 0)
+                return NULL;
+
+        pos = gfbgraph_photo_lower_bound (priv, height, gfbgraph_photo_image_height);
+        pos = gfbgraph_photo_nearest (priv, height, pos, gfbgraph_photo_image_height);
 
-        return photo_image;
+        return &priv->images[priv->height_index[pos]];
 }
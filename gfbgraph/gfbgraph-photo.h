@@ -64,12 +64,15 @@ GType          gfbgraph_photo_get_type (void) G_GNUC_CONST;
 GFBGraphPhoto* gfbgraph_photo_new      (void);
 GFBGraphPhoto* gfbgraph_photo_new_from_id (GFBGraphAuthorizer *authorizer, const gchar *id, GError **error);
 GInputStream*  gfbgraph_photo_download_default_size (GFBGraphPhoto *photo, GFBGraphAuthorizer *authorizer, GError **error);
+GInputStream*  gfbgraph_photo_download_image        (GFBGraphPhoto *photo, const GFBGraphPhotoImage *image, GFBGraphAuthorizer *authorizer, GError **error);
+gboolean       gfbgraph_photo_prefetch              (GList *photos, guint width, GFBGraphAuthorizer *authorizer, GCancellable *cancellable, GError **error);
 
 const gchar*        gfbgraph_photo_get_name               (GFBGraphPhoto *photo);
 const gchar*        gfbgraph_photo_get_default_source_uri (GFBGraphPhoto *photo);
 guint               gfbgraph_photo_get_default_width      (GFBGraphPhoto *photo);
 guint               gfbgraph_photo_get_default_height     (GFBGraphPhoto *photo);
 GList*              gfbgraph_photo_get_images             (GFBGraphPhoto *photo);
+const GFBGraphPhotoImage* gfbgraph_photo_get_images_array       (GFBGraphPhoto *photo, guint *n_images);
 const GFBGraphPhotoImage* gfbgraph_photo_get_image_hires        (GFBGraphPhoto *photo);
 const GFBGraphPhotoImage* gfbgraph_photo_get_image_near_width   (GFBGraphPhoto *photo, guint width);
 const GFBGraphPhotoImage* gfbgraph_photo_get_image_near_height  (GFBGraphPhoto *photo, guint height);
@@ -0,0 +1,127 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Library internal API, shared between the node implementations.
+ * This header isn't installed. */
+
+#ifndef __GFBGRAPH_PRIVATE_H__
+#define __GFBGRAPH_PRIVATE_H__
+
+#include <json-glib/json-glib.h>
+#include <rest/rest-proxy.h>
+
+#include "gfbgraph-node.h"
+#include "gfbgraph-request.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GFBGraphArena GFBGraphArena;
+
+GFBGraphArena* gfbgraph_arena_new      (void);
+GFBGraphArena* gfbgraph_arena_ref      (GFBGraphArena *arena);
+void           gfbgraph_arena_unref    (GFBGraphArena *arena);
+gchar*         gfbgraph_arena_strdup   (GFBGraphArena *arena, const gchar *str);
+gboolean       gfbgraph_arena_contains (GFBGraphArena *arena, gconstpointer mem);
+
+RestProxy*     gfbgraph_transfer_get_proxy      (void);
+void           gfbgraph_transfer_set_endpoint   (const gchar *endpoint);
+GInputStream*  gfbgraph_transfer_download       (GFBGraphAuthorizer *authorizer, const gchar *uri, guint *status_code, GError **error);
+gboolean       gfbgraph_transfer_call_sync      (RestProxyCall *call, GError **error);
+
+GInputStream*  gfbgraph_image_cache_download    (GFBGraphAuthorizer *authorizer, const gchar *photo_id,
+                                                 guint width, guint height, const gchar *uri, GError **error);
+gboolean       gfbgraph_image_cache_prefetch    (GFBGraphAuthorizer *authorizer, const gchar *photo_id,
+                                                 guint width, guint height, const gchar *uri, GError **error);
+
+typedef enum {
+        GFBGRAPH_COUNTER_REQUESTS,
+        GFBGRAPH_COUNTER_REQUESTS_IN_FLIGHT,
+        GFBGRAPH_COUNTER_BYTES_SENT,
+        GFBGRAPH_COUNTER_BYTES_RECEIVED,
+        GFBGRAPH_COUNTER_CONNECTIONS_OPENED,
+        GFBGRAPH_COUNTER_CONNECTIONS_REUSED,
+        GFBGRAPH_COUNTER_CACHE_HITS,
+        GFBGRAPH_COUNTER_TOKEN_REFRESHES,
+        GFBGRAPH_COUNTER_RETRIES,
+        /* For gfbgraph_get_transfer_stats() */
+        GFBGRAPH_COUNTER_WIRE_BYTES,
+        GFBGRAPH_COUNTER_DECODED_BYTES,
+        GFBGRAPH_N_COUNTERS
+} GFBGraphCounter;
+
+void           gfbgraph_counter_add             (GFBGraphCounter counter, gssize value);
+gsize          gfbgraph_counter_get             (GFBGraphCounter counter);
+void           gfbgraph_stats_node_alive        (GType node_type, gint delta);
+
+void           gfbgraph_simple_async_run_in_thread (GSimpleAsyncResult *simple_async, GSimpleAsyncThreadFunc func, GCancellable *cancellable);
+
+GFBGraphRequestRecord* gfbgraph_request_record_begin       (const gchar *method, const gchar *function);
+GFBGraphRequestRecord* gfbgraph_request_record_get_current (void);
+void                   gfbgraph_request_record_end         (GFBGraphRequestRecord *record, GFBGraphAuthorizer *authorizer);
+gboolean               gfbgraph_request_record_check_deadline (GFBGraphRequestRecord *record, GError **error);
+
+GFBGraphNode*  gfbgraph_node_deserialize        (GType node_type, JsonNode *json_node, GFBGraphArena *arena);
+
+gboolean       gfbgraph_node_deserialize_string (GFBGraphNode *node, JsonNode *member_node, gchar **field);
+gboolean       gfbgraph_node_deserialize_uint   (GFBGraphNode *node, JsonNode *member_node, guint *field);
+
+void           gfbgraph_node_serialize_string   (JsonBuilder *builder, const gchar *member_name, const gchar *value);
+void           gfbgraph_node_serialize_uint     (JsonBuilder *builder, const gchar *member_name, guint value);
+
+void           gfbgraph_node_materialize        (GFBGraphNode *node);
+gboolean       gfbgraph_node_check_writable     (GFBGraphNode *node);
+
+void           gfbgraph_node_set_expanded_nodes (GFBGraphNode *node, GType node_type, GPtrArray *nodes);
+guint          gfbgraph_expansion_apply         (GFBGraphExpansion *expansion, GFBGraphNode *node,
+                                                 JsonObject *json_object, GFBGraphArena *arena);
+
+gchar*         gfbgraph_node_dup_string         (GFBGraphNode *node, const gchar *str);
+void           gfbgraph_node_free_string        (GFBGraphNode *node, gchar *str);
+
+GPtrArray*     gfbgraph_connectable_type_parse_connected_data_array (GType self_type, const gchar *payload, gchar **next_url,
+                                                                     gint64 *total_count, GError **error);
+
+GPtrArray*     gfbgraph_node_fetch_connection_page (GFBGraphNode        *node,
+                                                    GType                node_type,
+                                                    GFBGraphAuthorizer  *authorizer,
+                                                    GHashTable          *params,
+                                                    GHashTable         **next_params,
+                                                    gint64              *total_count,
+                                                    GError             **error);
+
+RestProxyCall* gfbgraph_new_function_call       (GFBGraphAuthorizer *authorizer, const gchar *method, const gchar *function);
+gint64         gfbgraph_iso8601_to_unix         (const gchar *iso_time);
+GType          gfbgraph_node_type_from_name     (const gchar *type_name);
+
+typedef gpointer (*GFBGraphFlightFunc) (gpointer user_data, GError **error);
+
+gchar*         gfbgraph_request_key             (GFBGraphAuthorizer *authorizer, const gchar *function, GHashTable *params);
+gpointer       gfbgraph_single_flight           (const gchar        *key,
+                                                 GFBGraphFlightFunc  func,
+                                                 gpointer            user_data,
+                                                 GBoxedCopyFunc      copy_func,
+                                                 GDestroyNotify      free_func,
+                                                 GError            **error);
+
+GList*         gfbgraph_ptr_array_steal_to_list (GPtrArray *array);
+GPtrArray*     gfbgraph_list_steal_to_ptr_array (GList *list);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_PRIVATE_H__ */
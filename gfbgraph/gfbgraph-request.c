@@ -0,0 +1,501 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-request
+ * @short_description: Instrumentation of the requests
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * Every request done by GFBGraph on behalf of a #GFBGraphAuthorizer, like the ones of
+ * gfbgraph_node_new_from_id() or gfbgraph_node_get_connection_nodes(), emits the
+ * #GFBGraphAuthorizer::request-finished signal on it when finished, with a
+ * #GFBGraphRequestRecord telling where the time went: the network phases, the
+ * server and the deserialization of the response.
+ *
+ * Besides, the library keeps a few cumulative counters, cheap enough to be always
+ * enabled, which can be read at any time with gfbgraph_get_stats() and
+ * gfbgraph_get_nodes_alive().
+ *
+ * Each request belongs to a #GFBGraphPriority class, taken from the thread doing it,
+ * see gfbgraph_set_thread_priority(). The asynchronous functions use the priority of
+ * the thread calling them. A request waits while its class is at its limit of
+ * concurrent requests, see gfbgraph_set_priority_limit(), or while all the requests
+ * the library does at the same time are taken, see gfbgraph_set_max_requests(). Each
+ * request that finishes frees its place for the waiting request of the highest
+ * class. So the interactive requests don't queue behind a bulk download.
+ *
+ * The asynchronous functions run in a thread pool owned by the library, not in the
+ * GIO one shared with the rest of the process. Its size and the threads each priority
+ * class can take are set with gfbgraph_set_executor_limits() and
+ * gfbgraph_set_executor_priority_limit(), and its queue can be watched with
+ * gfbgraph_get_executor_stats().
+ *
+ * The requests can be bounded in time. gfbgraph_set_thread_deadline() sets when all
+ * the requests of the calling thread have to be done, including the following pages
+ * of a connection and the photo downloads, and the asynchronous functions carry the
+ * deadline of the thread calling them. gfbgraph_set_request_timeout() bounds each
+ * request on its own. The deadline covers the wait for its turn, the connection, the
+ * server and the transfer of the response. A request which misses it is aborted and
+ * fails with %G_IO_ERROR_TIMED_OUT.
+ **/
+
+#include "gfbgraph-request.h"
+#include "gfbgraph-private.h"
+#include "gfbgraph-trace.h"
+
+#define SCHEDULER_DEFAULT_MAX_REQUESTS 8
+
+/* The record of the request in progress in each thread. The requests are
+ * synchronous, so the HTTP layer fills the record of the calling thread. */
+static GPrivate current_record = G_PRIVATE_INIT (NULL);
+
+static volatile gsize counters[GFBGRAPH_N_COUNTERS];
+
+static GQuark nodes_alive_quark;
+G_LOCK_DEFINE_STATIC (nodes_alive);
+
+/* The thread priority is kept plus one, so the unset default is NORMAL */
+static GPrivate thread_priority = G_PRIVATE_INIT (NULL);
+
+/* A gint64 doesn't fit a pointer everywhere, so the thread deadline is allocated */
+static GPrivate thread_deadline = G_PRIVATE_INIT (g_free);
+static volatile gint request_timeout;
+
+static GMutex   scheduler_mutex;
+static GCond    scheduler_cond;
+/* Background requests don't take over all the connections by default */
+static guint    scheduler_limit[GFBGRAPH_N_PRIORITIES] = { 0, 0, 2 };
+/* Shared by all the classes, handed out by priority */
+static guint    scheduler_max_requests = SCHEDULER_DEFAULT_MAX_REQUESTS;
+static guint    scheduler_active[GFBGRAPH_N_PRIORITIES];
+static guint    scheduler_waiting[GFBGRAPH_N_PRIORITIES];
+
+G_DEFINE_BOXED_TYPE (GFBGraphRequestRecord, gfbgraph_request_record, gfbgraph_request_record_copy, gfbgraph_request_record_free)
+
+/**
+ * gfbgraph_request_record_copy:
+ * @record: a #GFBGraphRequestRecord.
+ *
+ * Returns: (transfer full): a copy of @record, to be freed with gfbgraph_request_record_free().
+ **/
+GFBGraphRequestRecord*
+gfbgraph_request_record_copy (const GFBGraphRequestRecord *record)
+{
+        GFBGraphRequestRecord *copy;
+
+        g_return_val_if_fail (record != NULL, NULL);
+
+        copy = g_slice_dup (GFBGraphRequestRecord, record);
+        copy->method = g_strdup (record->method);
+        copy->function = g_strdup (record->function);
+
+        return copy;
+}
+
+/**
+ * gfbgraph_request_record_free:
+ * @record: a #GFBGraphRequestRecord.
+ *
+ * Frees @record.
+ **/
+void
+gfbgraph_request_record_free (GFBGraphRequestRecord *record)
+{
+        if (record == NULL)
+                return;
+
+        g_free (record->method);
+        g_free (record->function);
+
+        g_slice_free (GFBGraphRequestRecord, record);
+}
+
+static gboolean
+gfbgraph_scheduler_can_start_locked (GFBGraphPriority priority)
+{
+        guint active = 0;
+        guint i;
+
+        if (scheduler_limit[priority] > 0 && scheduler_active[priority] >= scheduler_limit[priority])
+                return FALSE;
+
+        /* Without a shared capacity, yielding wouldn't help any other class */
+        if (scheduler_max_requests == 0)
+                return TRUE;
+
+        for (i = 0; i < GFBGRAPH_N_PRIORITIES; i++)
+                active += scheduler_active[i];
+        if (active >= scheduler_max_requests)
+                return FALSE;
+
+        /* The free places go to the higher classes first, unless their own
+         * limit keeps them waiting anyway */
+        for (i = 0; i < priority; i++) {
+                if (scheduler_waiting[i] > 0
+                    && (scheduler_limit[i] == 0 || scheduler_active[i] < scheduler_limit[i]))
+                        return FALSE;
+        }
+
+        return TRUE;
+}
+
+/* Waits until a request of @priority can start, or until @deadline. A late
+ * request starts anyway, to fail at once in the HTTP layer. */
+static void
+gfbgraph_scheduler_acquire (GFBGraphPriority priority, gint64 deadline)
+{
+        g_mutex_lock (&scheduler_mutex);
+
+        if (!gfbgraph_scheduler_can_start_locked (priority)) {
+                scheduler_waiting[priority]++;
+                while (!gfbgraph_scheduler_can_start_locked (priority)) {
+                        if (deadline == 0)
+                                g_cond_wait (&scheduler_cond, &scheduler_mutex);
+                        else if (!g_cond_wait_until (&scheduler_cond, &scheduler_mutex, deadline))
+                                break;
+                }
+                scheduler_waiting[priority]--;
+
+                /* Others of lower priority could be waiting for this one */
+                g_cond_broadcast (&scheduler_cond);
+        }
+
+        scheduler_active[priority]++;
+
+        g_mutex_unlock (&scheduler_mutex);
+}
+
+static void
+gfbgraph_scheduler_release (GFBGraphPriority priority)
+{
+        g_mutex_lock (&scheduler_mutex);
+        scheduler_active[priority]--;
+        g_cond_broadcast (&scheduler_cond);
+        g_mutex_unlock (&scheduler_mutex);
+}
+
+/* Starts recording a request done by the calling thread */
+GFBGraphRequestRecord*
+gfbgraph_request_record_begin (const gchar *method, const gchar *function)
+{
+        GFBGraphRequestRecord *record;
+        gint timeout;
+
+        record = g_slice_new0 (GFBGraphRequestRecord);
+        record->method = g_strdup (method);
+        record->function = g_strdup (function);
+        record->start_time = g_get_monotonic_time ();
+        record->priority = gfbgraph_get_thread_priority ();
+
+        /* The earliest of the thread deadline and the request timeout */
+        record->deadline = gfbgraph_get_thread_deadline ();
+        timeout = g_atomic_int_get (&request_timeout);
+        if (timeout > 0) {
+                gint64 timeout_deadline;
+
+                timeout_deadline = record->start_time + (gint64) timeout * G_TIME_SPAN_MILLISECOND;
+                if (record->deadline == 0 || timeout_deadline < record->deadline)
+                        record->deadline = timeout_deadline;
+        }
+
+        gfbgraph_scheduler_acquire (record->priority, record->deadline);
+        record->admitted_time = g_get_monotonic_time ();
+
+        g_private_set (&current_record, record);
+
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_REQUESTS, 1);
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_REQUESTS_IN_FLIGHT, 1);
+
+        GFBGRAPH_TRACE2 (request__start, record->method, record->function);
+
+        return record;
+}
+
+/* Gets the record of the request in progress in the calling thread, if any */
+GFBGraphRequestRecord*
+gfbgraph_request_record_get_current (void)
+{
+        return g_private_get (&current_record);
+}
+
+/* Checks if @record is past its deadline. If so, sets @error and returns %TRUE */
+gboolean
+gfbgraph_request_record_check_deadline (GFBGraphRequestRecord *record, GError **error)
+{
+        if (record == NULL || record->deadline == 0 || g_get_monotonic_time () < record->deadline)
+                return FALSE;
+
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "The request missed its deadline");
+
+        return TRUE;
+}
+
+/* Finishes @record, hands it to the handlers of @authorizer and frees it */
+void
+gfbgraph_request_record_end (GFBGraphRequestRecord *record, GFBGraphAuthorizer *authorizer)
+{
+        g_return_if_fail (record != NULL);
+
+        record->end_time = g_get_monotonic_time ();
+
+        GFBGRAPH_TRACE3 (request__end, record->function, record->status_code, record->nodes);
+
+        if (g_private_get (&current_record) == record)
+                g_private_set (&current_record, NULL);
+
+        gfbgraph_scheduler_release (record->priority);
+
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_REQUESTS_IN_FLIGHT, -1);
+        if (record->cache_hit)
+                gfbgraph_counter_add (GFBGRAPH_COUNTER_CACHE_HITS, 1);
+        if (record->retries > 0)
+                gfbgraph_counter_add (GFBGRAPH_COUNTER_RETRIES, record->retries);
+
+        if (authorizer != NULL)
+                g_signal_emit_by_name (authorizer, "request-finished", record);
+
+        gfbgraph_request_record_free (record);
+}
+
+void
+gfbgraph_counter_add (GFBGraphCounter counter, gssize value)
+{
+        g_return_if_fail (counter < GFBGRAPH_N_COUNTERS);
+
+        g_atomic_pointer_add (&counters[counter], value);
+}
+
+gsize
+gfbgraph_counter_get (GFBGraphCounter counter)
+{
+        g_return_val_if_fail (counter < GFBGRAPH_N_COUNTERS, 0);
+
+        return (gsize) g_atomic_pointer_get (&counters[counter]);
+}
+
+static volatile gint*
+gfbgraph_get_nodes_alive_counter (GType node_type)
+{
+        volatile gint *counter;
+
+        if (G_UNLIKELY (nodes_alive_quark == 0))
+                nodes_alive_quark = g_quark_from_static_string ("gfbgraph-nodes-alive");
+
+        counter = g_type_get_qdata (node_type, nodes_alive_quark);
+        if (G_UNLIKELY (counter == NULL)) {
+                G_LOCK (nodes_alive);
+                counter = g_type_get_qdata (node_type, nodes_alive_quark);
+                if (counter == NULL) {
+                        /* Lives as long as the type, which is forever */
+                        counter = g_new0 (gint, 1);
+                        g_type_set_qdata (node_type, nodes_alive_quark, (gpointer) counter);
+                }
+                G_UNLOCK (nodes_alive);
+        }
+
+        return counter;
+}
+
+/* Accounts a node of @node_type created (@delta 1) or finalized (@delta -1) */
+void
+gfbgraph_stats_node_alive (GType node_type, gint delta)
+{
+        g_atomic_int_add (gfbgraph_get_nodes_alive_counter (node_type), delta);
+}
+
+/**
+ * gfbgraph_get_stats:
+ * @stats: (out caller-allocates): a #GFBGraphStats to fill.
+ *
+ * Fills @stats with the current value of the library counters. Every counter is
+ * read atomically, but they aren't read all at once, so they can be slightly
+ * inconsistent between them while requests are in progress.
+ **/
+void
+gfbgraph_get_stats (GFBGraphStats *stats)
+{
+        g_return_if_fail (stats != NULL);
+
+        stats->requests = gfbgraph_counter_get (GFBGRAPH_COUNTER_REQUESTS);
+        stats->requests_in_flight = gfbgraph_counter_get (GFBGRAPH_COUNTER_REQUESTS_IN_FLIGHT);
+        stats->bytes_sent = gfbgraph_counter_get (GFBGRAPH_COUNTER_BYTES_SENT);
+        stats->bytes_received = gfbgraph_counter_get (GFBGRAPH_COUNTER_BYTES_RECEIVED);
+        stats->connections_opened = gfbgraph_counter_get (GFBGRAPH_COUNTER_CONNECTIONS_OPENED);
+        stats->connections_reused = gfbgraph_counter_get (GFBGRAPH_COUNTER_CONNECTIONS_REUSED);
+        stats->cache_hits = gfbgraph_counter_get (GFBGRAPH_COUNTER_CACHE_HITS);
+        stats->token_refreshes = gfbgraph_counter_get (GFBGRAPH_COUNTER_TOKEN_REFRESHES);
+        stats->retries = gfbgraph_counter_get (GFBGRAPH_COUNTER_RETRIES);
+}
+
+/**
+ * gfbgraph_get_nodes_alive:
+ * @node_type: a #GFBGraphNode type.
+ *
+ * Gets how many nodes of exactly @node_type exist, the subtypes aren't counted.
+ *
+ * Returns: the number of @node_type instances not yet finalized.
+ **/
+guint
+gfbgraph_get_nodes_alive (GType node_type)
+{
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), 0);
+
+        return g_atomic_int_get (gfbgraph_get_nodes_alive_counter (node_type));
+}
+
+/**
+ * gfbgraph_set_thread_priority:
+ * @priority: a #GFBGraphPriority.
+ *
+ * Sets the priority class of the requests done from the calling thread, and of the
+ * asynchronous operations started from it. The threads start with
+ * %GFBGRAPH_PRIORITY_NORMAL.
+ *
+ * Returns: the previous priority of the thread, to restore it when done.
+ **/
+GFBGraphPriority
+gfbgraph_set_thread_priority (GFBGraphPriority priority)
+{
+        GFBGraphPriority previous;
+
+        g_return_val_if_fail (priority < GFBGRAPH_N_PRIORITIES, GFBGRAPH_PRIORITY_NORMAL);
+
+        previous = gfbgraph_get_thread_priority ();
+        g_private_set (&thread_priority, GINT_TO_POINTER (priority + 1));
+
+        return previous;
+}
+
+/**
+ * gfbgraph_get_thread_priority:
+ *
+ * Returns: the #GFBGraphPriority of the requests done from the calling thread.
+ **/
+GFBGraphPriority
+gfbgraph_get_thread_priority (void)
+{
+        gint priority;
+
+        priority = GPOINTER_TO_INT (g_private_get (&thread_priority));
+
+        return priority > 0 ? priority - 1 : GFBGRAPH_PRIORITY_NORMAL;
+}
+
+/**
+ * gfbgraph_set_thread_deadline:
+ * @deadline: the g_get_monotonic_time() by which the requests have to be done, or 0 for none.
+ *
+ * Sets when the requests done from the calling thread, and the asynchronous operations
+ * started from it, have to be done. A connection fetched in several pages, or a photo
+ * and its download, share the deadline. The requests which miss it fail with
+ * %G_IO_ERROR_TIMED_OUT. The threads start without a deadline.
+ *
+ * Returns: the previous deadline of the thread, to restore it when done.
+ **/
+gint64
+gfbgraph_set_thread_deadline (gint64 deadline)
+{
+        gint64 *thread_value;
+        gint64 previous;
+
+        g_return_val_if_fail (deadline >= 0, 0);
+
+        thread_value = g_private_get (&thread_deadline);
+        if (thread_value == NULL) {
+                thread_value = g_new0 (gint64, 1);
+                g_private_set (&thread_deadline, thread_value);
+        }
+
+        previous = *thread_value;
+        *thread_value = deadline;
+
+        return previous;
+}
+
+/**
+ * gfbgraph_get_thread_deadline:
+ *
+ * Returns: the deadline of the requests done from the calling thread, or 0 if they have none.
+ **/
+gint64
+gfbgraph_get_thread_deadline (void)
+{
+        gint64 *thread_value;
+
+        thread_value = g_private_get (&thread_deadline);
+
+        return thread_value != NULL ? *thread_value : 0;
+}
+
+/**
+ * gfbgraph_set_request_timeout:
+ * @timeout_ms: the maximum duration of each request, in milliseconds, or 0 for no limit.
+ *
+ * Bounds the duration of every request of the library, from when it is issued until
+ * the whole response is received. Unlike gfbgraph_set_thread_deadline(), it applies to
+ * each request on its own, and to all the threads. When both are set, the earliest
+ * wins. The requests taking longer fail with %G_IO_ERROR_TIMED_OUT. There is no
+ * limit by default.
+ **/
+void
+gfbgraph_set_request_timeout (guint timeout_ms)
+{
+        g_return_if_fail (timeout_ms <= G_MAXINT);
+
+        g_atomic_int_set (&request_timeout, timeout_ms);
+}
+
+/**
+ * gfbgraph_set_priority_limit:
+ * @priority: a #GFBGraphPriority.
+ * @max_requests: the maximum concurrent requests of @priority, or 0 for no limit.
+ *
+ * Limits how many requests of the @priority class can be in progress at the same
+ * time. The others wait for their turn. By default only the %GFBGRAPH_PRIORITY_BACKGROUND
+ * class is limited, to 2 requests.
+ **/
+void
+gfbgraph_set_priority_limit (GFBGraphPriority priority, guint max_requests)
+{
+        g_return_if_fail (priority < GFBGRAPH_N_PRIORITIES);
+
+        g_mutex_lock (&scheduler_mutex);
+        scheduler_limit[priority] = max_requests;
+        g_cond_broadcast (&scheduler_cond);
+        g_mutex_unlock (&scheduler_mutex);
+}
+
+/**
+ * gfbgraph_set_max_requests:
+ * @max_requests: the maximum concurrent requests of all the classes, or 0 for no limit.
+ *
+ * Limits how many requests can be in progress at the same time, whatever their
+ * #GFBGraphPriority. When all of them are taken, the place of the next finished
+ * request goes to a waiting request of the highest class, so the interactive ones
+ * go before the ones already waiting in the lower classes. The default is 8.
+ **/
+void
+gfbgraph_set_max_requests (guint max_requests)
+{
+        g_mutex_lock (&scheduler_mutex);
+        scheduler_max_requests = max_requests;
+        g_cond_broadcast (&scheduler_cond);
+        g_mutex_unlock (&scheduler_mutex);
+}
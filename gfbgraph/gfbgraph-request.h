@@ -0,0 +1,177 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_REQUEST_H__
+#define __GFBGRAPH_REQUEST_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_REQUEST_RECORD (gfbgraph_request_record_get_type ())
+
+/**
+ * GFBGraphPriority:
+ * @GFBGRAPH_PRIORITY_INTERACTIVE: requests an user is waiting for.
+ * @GFBGRAPH_PRIORITY_NORMAL: the default priority.
+ * @GFBGRAPH_PRIORITY_BACKGROUND: bulk requests, like a backup or a prefetch.
+ *
+ * The priority classes of the requests, see gfbgraph_set_thread_priority().
+ **/
+typedef enum {
+        GFBGRAPH_PRIORITY_INTERACTIVE,
+        GFBGRAPH_PRIORITY_NORMAL,
+        GFBGRAPH_PRIORITY_BACKGROUND,
+        GFBGRAPH_N_PRIORITIES /*< skip >*/
+} GFBGraphPriority;
+
+typedef struct _GFBGraphRequestRecord GFBGraphRequestRecord;
+
+/**
+ * GFBGraphRequestRecord:
+ * @method: the HTTP method.
+ * @function: the Graph API function requested, or the URI of a download.
+ * @status_code: the HTTP status of the response, or 0 if no response was received.
+ * @start_time: when the request started.
+ * @resolved_time: when the host name was resolved.
+ * @connected_time: when the connection to the server was established.
+ * @tls_time: when the TLS handshake finished.
+ * @request_sent_time: when the request was completely sent.
+ * @response_headers_time: when the response headers arrived, the time to first byte.
+ * @response_body_time: when the response body was completely received.
+ * @parse_start_time: when the deserialization of the response started.
+ * @parse_end_time: when the deserialization of the response finished.
+ * @end_time: when the request finished.
+ * @bytes_sent: the size of the request body.
+ * @bytes_received: the size of the response body on the wire.
+ * @retries: how many times the request was repeated.
+ * @cache_hit: %TRUE if the result didn't come from the server but was shared
+ *  from an identical request already in progress.
+ * @nodes: the number of nodes deserialized from the response.
+ * @priority: the #GFBGraphPriority of the request.
+ * @admitted_time: when the request was allowed to start, after waiting for the
+ *  requests of higher priority, see gfbgraph_set_priority_limit() and
+ *  gfbgraph_set_max_requests().
+ * @deadline: when the request had to be done, or 0 if it had no deadline, see
+ *  gfbgraph_set_thread_deadline() and gfbgraph_set_request_timeout().
+ *
+ * The record of a request, given by the #GFBGraphAuthorizer::request-finished signal.
+ * All the times come from g_get_monotonic_time(). The times of the phases that didn't
+ * happen are 0, like the connection phases when an existing connection was reused.
+ **/
+struct _GFBGraphRequestRecord {
+        gchar    *method;
+        gchar    *function;
+        guint     status_code;
+
+        gint64    start_time;
+        gint64    resolved_time;
+        gint64    connected_time;
+        gint64    tls_time;
+        gint64    request_sent_time;
+        gint64    response_headers_time;
+        gint64    response_body_time;
+        gint64    parse_start_time;
+        gint64    parse_end_time;
+        gint64    end_time;
+
+        guint64   bytes_sent;
+        guint64   bytes_received;
+        guint     retries;
+        gboolean  cache_hit;
+        guint     nodes;
+
+        GFBGraphPriority priority;
+        gint64    admitted_time;
+        gint64    deadline;
+};
+
+typedef struct _GFBGraphStats GFBGraphStats;
+
+/**
+ * GFBGraphStats:
+ * @requests: the requests issued.
+ * @requests_in_flight: the requests in progress.
+ * @bytes_sent: the bytes of the request bodies sent.
+ * @bytes_received: the bytes of the response bodies received on the wire.
+ * @connections_opened: the connections opened to the servers.
+ * @connections_reused: the requests sent through an already opened connection.
+ * @cache_hits: the requests answered without asking the server.
+ * @token_refreshes: the calls to gfbgraph_authorizer_refresh_authorization().
+ * @retries: the requests repeated after a failure.
+ *
+ * The cumulative counters of the library since the process started, see gfbgraph_get_stats().
+ **/
+struct _GFBGraphStats {
+        guint64 requests;
+        guint64 requests_in_flight;
+        guint64 bytes_sent;
+        guint64 bytes_received;
+        guint64 connections_opened;
+        guint64 connections_reused;
+        guint64 cache_hits;
+        guint64 token_refreshes;
+        guint64 retries;
+};
+
+typedef struct _GFBGraphExecutorStats GFBGraphExecutorStats;
+
+/**
+ * GFBGraphExecutorStats:
+ * @completed: the operations run since the process started.
+ * @rejected: the operations refused because the queue was full.
+ * @queued: the operations waiting for a thread.
+ * @running: the operations in progress.
+ * @total_wait_time: the sum of the microseconds the run operations waited for a thread.
+ * @max_wait_time: the longest wait for a thread, in microseconds.
+ *
+ * The state of the pool of the asynchronous functions, see gfbgraph_get_executor_stats().
+ **/
+struct _GFBGraphExecutorStats {
+        guint64 completed;
+        guint64 rejected;
+        guint   queued;
+        guint   running;
+        gint64  total_wait_time;
+        gint64  max_wait_time;
+};
+
+GType                  gfbgraph_request_record_get_type (void) G_GNUC_CONST;
+GFBGraphRequestRecord* gfbgraph_request_record_copy     (const GFBGraphRequestRecord *record);
+void                   gfbgraph_request_record_free     (GFBGraphRequestRecord *record);
+
+void                   gfbgraph_get_stats               (GFBGraphStats *stats);
+guint                  gfbgraph_get_nodes_alive         (GType node_type);
+
+GFBGraphPriority       gfbgraph_set_thread_priority     (GFBGraphPriority priority);
+GFBGraphPriority       gfbgraph_get_thread_priority     (void);
+void                   gfbgraph_set_priority_limit      (GFBGraphPriority priority, guint max_requests);
+void                   gfbgraph_set_max_requests        (guint max_requests);
+
+gint64                 gfbgraph_set_thread_deadline     (gint64 deadline);
+gint64                 gfbgraph_get_thread_deadline     (void);
+void                   gfbgraph_set_request_timeout     (guint timeout_ms);
+
+void                   gfbgraph_set_executor_limits          (guint max_threads, guint max_queued);
+void                   gfbgraph_set_executor_priority_limit  (GFBGraphPriority priority, guint max_threads);
+void                   gfbgraph_get_executor_stats           (GFBGraphExecutorStats *stats);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_REQUEST_H__ */
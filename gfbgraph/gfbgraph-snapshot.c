@@ -0,0 +1,360 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-snapshot
+ * @short_description: Memory mapped snapshots of node sets
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * A #GFBGraphSnapshot is a set of nodes saved with gfbgraph_snapshot_write() in a
+ * compact, versioned binary file, in the #GVariant serialization format. Opening it
+ * with gfbgraph_snapshot_new_from_file() only maps the file into memory, nothing is
+ * parsed, so it takes the same time for ten nodes as for a hundred thousand.
+ *
+ * The nodes are created on access, with gfbgraph_snapshot_get_node() or, by their ID,
+ * with gfbgraph_snapshot_lookup(), which does a binary search on the sorted index
+ * stored in the file. Only the members of the requested node are read.
+ *
+ * Any #GFBGraphNode type can be saved; the images of the #GFBGraphPhoto nodes are
+ * kept too.
+ **/
+
+#include <string.h>
+
+#include "gfbgraph-snapshot.h"
+#include "gfbgraph-common.h"
+#include "gfbgraph-private.h"
+
+/* The magic, the format version, the nodes with their type and their
+ * serialized members, and the (ID, node index) pairs sorted by ID */
+#define SNAPSHOT_FORMAT "(uua(sa{sv})a(su))"
+#define SNAPSHOT_MAGIC 0x53424647 /* "GFBS" */
+#define SNAPSHOT_VERSION 1
+
+struct _GFBGraphSnapshot {
+        volatile gint ref_count;
+
+        GMappedFile *mapped_file;
+        GVariant *nodes;
+        GVariant *index;
+};
+
+typedef struct {
+        const gchar *id;
+        guint32 position;
+} GFBGraphSnapshotIndexEntry;
+
+G_DEFINE_BOXED_TYPE (GFBGraphSnapshot, gfbgraph_snapshot, gfbgraph_snapshot_ref, gfbgraph_snapshot_unref)
+
+static gint
+gfbgraph_snapshot_index_entry_compare (gconstpointer a, gconstpointer b)
+{
+        return strcmp (((const GFBGraphSnapshotIndexEntry *) a)->id,
+                       ((const GFBGraphSnapshotIndexEntry *) b)->id);
+}
+
+/**
+ * gfbgraph_snapshot_write:
+ * @nodes: (element-type GFBGraphNode): a #GPtrArray of #GFBGraphNode.
+ * @filename: the path of the snapshot file.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Saves @nodes to @filename, replacing it atomically. The nodes keep their order,
+ * which is the one of gfbgraph_snapshot_get_node().
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_snapshot_write (GPtrArray *nodes, const gchar *filename, GError **error)
+{
+        GVariantBuilder nodes_builder;
+        GVariantBuilder index_builder;
+        GArray *index;
+        GVariant *snapshot;
+        gboolean ret = TRUE;
+        guint i;
+
+        g_return_val_if_fail (nodes != NULL, FALSE);
+        g_return_val_if_fail (filename != NULL, FALSE);
+
+        index = g_array_sized_new (FALSE, FALSE, sizeof (GFBGraphSnapshotIndexEntry), nodes->len);
+
+        g_variant_builder_init (&nodes_builder, G_VARIANT_TYPE ("a(sa{sv})"));
+        for (i = 0; i < nodes->len && ret; i++) {
+                GFBGraphNode *node;
+                JsonNode *json_node;
+                GVariant *members;
+
+                node = GFBGRAPH_NODE (g_ptr_array_index (nodes, i));
+
+                json_node = gfbgraph_node_serialize (node);
+                members = json_gvariant_deserialize (json_node, "a{sv}", error);
+                json_node_free (json_node);
+
+                if (members == NULL) {
+                        ret = FALSE;
+                        break;
+                }
+
+                g_variant_builder_add (&nodes_builder, "(s@a{sv})", G_OBJECT_TYPE_NAME (node), members);
+
+                if (gfbgraph_node_get_id (node) != NULL) {
+                        GFBGraphSnapshotIndexEntry entry;
+
+                        entry.id = gfbgraph_node_get_id (node);
+                        entry.position = i;
+                        g_array_append_val (index, entry);
+                }
+        }
+
+        if (!ret) {
+                g_variant_builder_clear (&nodes_builder);
+                g_array_free (index, TRUE);
+                return FALSE;
+        }
+
+        g_array_sort (index, gfbgraph_snapshot_index_entry_compare);
+
+        g_variant_builder_init (&index_builder, G_VARIANT_TYPE ("a(su)"));
+        for (i = 0; i < index->len; i++) {
+                GFBGraphSnapshotIndexEntry *entry;
+
+                entry = &g_array_index (index, GFBGraphSnapshotIndexEntry, i);
+                g_variant_builder_add (&index_builder, "(su)", entry->id, entry->position);
+        }
+        g_array_free (index, TRUE);
+
+        snapshot = g_variant_new ("(uua(sa{sv})a(su))",
+                                  (guint32) SNAPSHOT_MAGIC, (guint32) SNAPSHOT_VERSION,
+                                  &nodes_builder, &index_builder);
+        g_variant_ref_sink (snapshot);
+
+        ret = g_file_set_contents (filename, g_variant_get_data (snapshot), g_variant_get_size (snapshot), error);
+
+        g_variant_unref (snapshot);
+
+        return ret;
+}
+
+/**
+ * gfbgraph_snapshot_new_from_file:
+ * @filename: the path of a file saved with gfbgraph_snapshot_write().
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Opens the snapshot saved in @filename, mapping it into memory.
+ *
+ * Returns: (transfer full): a new #GFBGraphSnapshot, free it with gfbgraph_snapshot_unref(),
+ * or %NULL if an error ocurred.
+ **/
+GFBGraphSnapshot*
+gfbgraph_snapshot_new_from_file (const gchar *filename, GError **error)
+{
+        GFBGraphSnapshot *snapshot;
+        GMappedFile *mapped_file;
+        GVariant *root;
+        GBytes *bytes;
+        guint32 magic, version;
+
+        g_return_val_if_fail (filename != NULL, NULL);
+
+        mapped_file = g_mapped_file_new (filename, FALSE, error);
+        if (mapped_file == NULL)
+                return NULL;
+
+        bytes = g_mapped_file_get_bytes (mapped_file);
+        root = g_variant_new_from_bytes (G_VARIANT_TYPE (SNAPSHOT_FORMAT), bytes, FALSE);
+        g_variant_ref_sink (root);
+        g_bytes_unref (bytes);
+
+        g_variant_get_child (root, 0, "u", &magic);
+        g_variant_get_child (root, 1, "u", &version);
+
+        /* Written on a machine with the other byte order */
+        if (magic == GUINT32_SWAP_LE_BE (SNAPSHOT_MAGIC)) {
+                GVariant *swapped;
+
+                swapped = g_variant_byteswap (root);
+                g_variant_unref (root);
+                root = g_variant_ref_sink (swapped);
+
+                g_variant_get_child (root, 0, "u", &magic);
+                g_variant_get_child (root, 1, "u", &version);
+        }
+
+        if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+                g_set_error (error, GFBGRAPH_NODE_ERROR,
+                             GFBGRAPH_NODE_ERROR_INVALID_DATA,
+                             "%s isn't a supported snapshot file", filename);
+                g_variant_unref (root);
+                g_mapped_file_unref (mapped_file);
+                return NULL;
+        }
+
+        snapshot = g_slice_new0 (GFBGraphSnapshot);
+        snapshot->ref_count = 1;
+        snapshot->mapped_file = mapped_file;
+        snapshot->nodes = g_variant_get_child_value (root, 2);
+        snapshot->index = g_variant_get_child_value (root, 3);
+
+        g_variant_unref (root);
+
+        return snapshot;
+}
+
+/**
+ * gfbgraph_snapshot_ref:
+ * @snapshot: a #GFBGraphSnapshot.
+ *
+ * Returns: (transfer full): @snapshot with its reference count increased.
+ **/
+GFBGraphSnapshot*
+gfbgraph_snapshot_ref (GFBGraphSnapshot *snapshot)
+{
+        g_return_val_if_fail (snapshot != NULL, NULL);
+
+        g_atomic_int_inc (&snapshot->ref_count);
+
+        return snapshot;
+}
+
+/**
+ * gfbgraph_snapshot_unref:
+ * @snapshot: a #GFBGraphSnapshot.
+ *
+ * Decreases the reference count of @snapshot, unmapping the file when it reaches
+ * zero. The nodes already created from it aren't affected.
+ **/
+void
+gfbgraph_snapshot_unref (GFBGraphSnapshot *snapshot)
+{
+        g_return_if_fail (snapshot != NULL);
+
+        if (!g_atomic_int_dec_and_test (&snapshot->ref_count))
+                return;
+
+        g_variant_unref (snapshot->nodes);
+        g_variant_unref (snapshot->index);
+        g_mapped_file_unref (snapshot->mapped_file);
+
+        g_slice_free (GFBGraphSnapshot, snapshot);
+}
+
+/**
+ * gfbgraph_snapshot_get_n_nodes:
+ * @snapshot: a #GFBGraphSnapshot.
+ *
+ * Returns: the number of nodes in @snapshot.
+ **/
+guint
+gfbgraph_snapshot_get_n_nodes (GFBGraphSnapshot *snapshot)
+{
+        g_return_val_if_fail (snapshot != NULL, 0);
+
+        return g_variant_n_children (snapshot->nodes);
+}
+
+/**
+ * gfbgraph_snapshot_get_node:
+ * @snapshot: a #GFBGraphSnapshot.
+ * @index: the position of the node, lower than gfbgraph_snapshot_get_n_nodes().
+ *
+ * Creates the node saved at @index. Every call creates a new node.
+ *
+ * Returns: (transfer full): a new #GFBGraphNode, or %NULL if its type isn't known.
+ **/
+GFBGraphNode*
+gfbgraph_snapshot_get_node (GFBGraphSnapshot *snapshot, guint index)
+{
+        GFBGraphNode *node;
+        GVariant *child;
+        GVariant *members;
+        JsonNode *json_node;
+        const gchar *type_name;
+        GType node_type;
+
+        g_return_val_if_fail (snapshot != NULL, NULL);
+        g_return_val_if_fail (index < g_variant_n_children (snapshot->nodes), NULL);
+
+        child = g_variant_get_child_value (snapshot->nodes, index);
+        g_variant_get_child (child, 0, "&s", &type_name);
+
+        node_type = gfbgraph_node_type_from_name (type_name);
+        if (node_type == G_TYPE_INVALID) {
+                g_warning ("Unknown node type %s in the snapshot", type_name);
+                g_variant_unref (child);
+                return NULL;
+        }
+
+        members = g_variant_get_child_value (child, 1);
+        json_node = json_gvariant_serialize (members);
+        /* Without an arena, which would outlive the node or waste a whole
+         * block on its few strings */
+        node = gfbgraph_node_deserialize (node_type, json_node, NULL);
+
+        json_node_free (json_node);
+        g_variant_unref (members);
+        g_variant_unref (child);
+
+        return node;
+}
+
+/**
+ * gfbgraph_snapshot_lookup:
+ * @snapshot: a #GFBGraphSnapshot.
+ * @id: a node ID.
+ *
+ * Creates the node with the given @id, found with a binary search on the index of
+ * @snapshot.
+ *
+ * Returns: (transfer full): a new #GFBGraphNode, or %NULL if @snapshot doesn't have it.
+ **/
+GFBGraphNode*
+gfbgraph_snapshot_lookup (GFBGraphSnapshot *snapshot, const gchar *id)
+{
+        gsize low, high;
+
+        g_return_val_if_fail (snapshot != NULL, NULL);
+        g_return_val_if_fail (id != NULL, NULL);
+
+        low = 0;
+        high = g_variant_n_children (snapshot->index);
+
+        while (low < high) {
+                const gchar *entry_id;
+                guint32 position;
+                gsize middle;
+                gint cmp;
+
+                middle = low + (high - low) / 2;
+
+                g_variant_get_child (snapshot->index, middle, "(&su)", &entry_id, &position);
+                cmp = strcmp (id, entry_id);
+
+                if (cmp == 0)
+                        return position < g_variant_n_children (snapshot->nodes)
+                                ? gfbgraph_snapshot_get_node (snapshot, position) : NULL;
+                else if (cmp < 0)
+                        high = middle;
+                else
+                        low = middle + 1;
+        }
+
+        return NULL;
+}
@@ -0,0 +1,45 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_SNAPSHOT_H__
+#define __GFBGRAPH_SNAPSHOT_H__
+
+#include <glib-object.h>
+#include <gfbgraph/gfbgraph-node.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_SNAPSHOT (gfbgraph_snapshot_get_type ())
+
+typedef struct _GFBGraphSnapshot GFBGraphSnapshot;
+
+GType             gfbgraph_snapshot_get_type       (void) G_GNUC_CONST;
+GFBGraphSnapshot* gfbgraph_snapshot_new_from_file  (const gchar *filename, GError **error);
+GFBGraphSnapshot* gfbgraph_snapshot_ref            (GFBGraphSnapshot *snapshot);
+void              gfbgraph_snapshot_unref          (GFBGraphSnapshot *snapshot);
+
+gboolean          gfbgraph_snapshot_write          (GPtrArray *nodes, const gchar *filename, GError **error);
+
+guint             gfbgraph_snapshot_get_n_nodes    (GFBGraphSnapshot *snapshot);
+GFBGraphNode*     gfbgraph_snapshot_get_node       (GFBGraphSnapshot *snapshot, guint index);
+GFBGraphNode*     gfbgraph_snapshot_lookup         (GFBGraphSnapshot *snapshot, const gchar *id);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_SNAPSHOT_H__ */
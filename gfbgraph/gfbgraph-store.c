@@ -0,0 +1,1014 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-store
+ * @short_description: Local persistent copy of nodes
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * #GFBGraphStore keeps nodes on disk, so an application can show them right
+ * after starting instead of retrieving them again from the Graph API.
+ *
+ * The nodes are saved in an append-only log, one JSON record per line, which is
+ * mapped in memory and replayed when the store is opened. The store keeps the nodes
+ * indexed by ID and by the connection they were retrieved from, ordered by their
+ * created time, so gfbgraph_store_get_connection_nodes() answers without any request.
+ *
+ * gfbgraph_store_refresh_connection_async() updates a connection in the store from the
+ * Graph API in a thread. Since the log only grows, call gfbgraph_store_compact() from
+ * time to time to drop the replaced and removed records.
+ **/
+
+#include "gfbgraph-store.h"
+#include "gfbgraph-private.h"
+
+#include <string.h>
+#include <json-glib/json-glib.h>
+
+enum
+{
+        PROP_0,
+
+        PROP_PATH
+};
+
+typedef struct {
+        gchar         *id;
+        const gchar   *type_name;
+        gint64         created_time;
+        JsonNode      *json;
+        /* The connections the node belongs to, as a node can be in several, like
+         * a photo of an user and of an album of the user. "parent ID/node type
+         * name" -> GSequenceIter of the entry in that connection. */
+        GHashTable    *parents;
+} GFBGraphStoreEntry;
+
+struct _GFBGraphStorePrivate {
+        GMutex mutex;
+        gchar *path;
+        GOutputStream *log;
+
+        /* Node ID -> GFBGraphStoreEntry */
+        GHashTable *entries;
+        /* "parent ID/node type name" -> GSequence of GFBGraphStoreEntry, newest first */
+        GHashTable *connections;
+};
+
+typedef struct {
+        GFBGraphNode *node;
+        GType node_type;
+        GFBGraphAuthorizer *authorizer;
+} GFBGraphStoreRefreshAsyncData;
+
+static void gfbgraph_store_init         (GFBGraphStore *obj);
+static void gfbgraph_store_class_init   (GFBGraphStoreClass *klass);
+static void gfbgraph_store_finalize     (GObject *obj);
+static void gfbgraph_store_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
+static void gfbgraph_store_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+static void     gfbgraph_store_entry_free     (GFBGraphStoreEntry *entry);
+static gint     gfbgraph_store_entry_compare  (gconstpointer a, gconstpointer b, gpointer user_data);
+static gchar*   gfbgraph_store_parent_key     (const gchar *parent_id, const gchar *type_name);
+static void     gfbgraph_store_index_entry    (GFBGraphStore *store, GFBGraphStoreEntry *entry);
+static void     gfbgraph_store_apply_record   (GFBGraphStore *store, JsonObject *record);
+static gchar*   gfbgraph_store_entry_to_line  (GFBGraphStoreEntry *entry);
+static gboolean gfbgraph_store_open_log       (GFBGraphStore *store, GError **error);
+static gboolean gfbgraph_store_load           (GFBGraphStore *store, GError **error);
+static gboolean gfbgraph_store_append         (GFBGraphStore *store, const gchar *line, GError **error);
+static gboolean gfbgraph_store_put_locked     (GFBGraphStore *store, GFBGraphNode *node, const gchar *parent_id, GError **error);
+static gboolean gfbgraph_store_remove_locked  (GFBGraphStore *store, const gchar *id, GError **error);
+
+static void gfbgraph_store_refresh_async_data_free (GFBGraphStoreRefreshAsyncData *data);
+static void gfbgraph_store_refresh_connection_async_thread (GSimpleAsyncResult *simple_async, GFBGraphStore *store, GCancellable *cancellable);
+
+#define GFBGRAPH_STORE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE((o), GFBGRAPH_TYPE_STORE, GFBGraphStorePrivate))
+
+static GObjectClass *parent_class = NULL;
+
+G_DEFINE_TYPE (GFBGraphStore, gfbgraph_store, G_TYPE_OBJECT);
+
+static void
+gfbgraph_store_init (GFBGraphStore *obj)
+{
+        obj->priv = GFBGRAPH_STORE_GET_PRIVATE(obj);
+
+        g_mutex_init (&obj->priv->mutex);
+        obj->priv->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) gfbgraph_store_entry_free);
+        obj->priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_sequence_free);
+}
+
+static void
+gfbgraph_store_class_init (GFBGraphStoreClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        parent_class            = g_type_class_peek_parent (klass);
+        gobject_class->finalize = gfbgraph_store_finalize;
+        gobject_class->set_property = gfbgraph_store_set_property;
+        gobject_class->get_property = gfbgraph_store_get_property;
+
+        g_type_class_add_private (gobject_class, sizeof(GFBGraphStorePrivate));
+
+        /**
+         * GFBGraphStore:path:
+         *
+         * The path of the store log file.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_PATH,
+                                         g_param_spec_string ("path",
+                                                              "The store path", "The path of the store log file",
+                                                              NULL,
+                                                              G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+gfbgraph_store_finalize (GObject *obj)
+{
+        GFBGraphStorePrivate *priv;
+
+        priv = GFBGRAPH_STORE_GET_PRIVATE (obj);
+
+        if (priv->log) {
+                g_output_stream_close (priv->log, NULL, NULL);
+                g_object_unref (priv->log);
+        }
+
+        /* The sequences don't own the entries, so they go first */
+        g_hash_table_unref (priv->connections);
+        g_hash_table_unref (priv->entries);
+        g_free (priv->path);
+        g_mutex_clear (&priv->mutex);
+
+        G_OBJECT_CLASS(parent_class)->finalize (obj);
+}
+
+static void
+gfbgraph_store_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+        GFBGraphStorePrivate *priv;
+
+        priv = GFBGRAPH_STORE_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_PATH:
+                        g_free (priv->path);
+                        priv->path = g_value_dup_string (value);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_store_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+        GFBGraphStorePrivate *priv;
+
+        priv = GFBGRAPH_STORE_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_PATH:
+                        g_value_set_string (value, priv->path);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static GFBGraphStoreEntry*
+gfbgraph_store_entry_new (const gchar *id, const gchar *type_name)
+{
+        GFBGraphStoreEntry *entry;
+
+        entry = g_slice_new0 (GFBGraphStoreEntry);
+        entry->id = g_strdup (id);
+        entry->type_name = g_intern_string (type_name);
+        entry->parents = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        return entry;
+}
+
+static void
+gfbgraph_store_entry_free (GFBGraphStoreEntry *entry)
+{
+        g_free (entry->id);
+        g_hash_table_unref (entry->parents);
+        if (entry->json)
+                json_node_free (entry->json);
+
+        g_slice_free (GFBGraphStoreEntry, entry);
+}
+
+/* Adds the connections of @source to @entry, not indexed yet */
+static void
+gfbgraph_store_entry_add_parents (GFBGraphStoreEntry *entry, GFBGraphStoreEntry *source)
+{
+        GHashTableIter iter;
+        gpointer parent_key;
+
+        g_hash_table_iter_init (&iter, source->parents);
+        while (g_hash_table_iter_next (&iter, &parent_key, NULL))
+                g_hash_table_insert (entry->parents, g_strdup (parent_key), NULL);
+}
+
+/* Newest first, like the Graph API returns the connections */
+static gint
+gfbgraph_store_entry_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+        const GFBGraphStoreEntry *entry_a = a;
+        const GFBGraphStoreEntry *entry_b = b;
+
+        if (entry_a->created_time != entry_b->created_time)
+                return (entry_a->created_time > entry_b->created_time) ? -1 : 1;
+
+        return strcmp (entry_a->id, entry_b->id);
+}
+
+static gchar*
+gfbgraph_store_parent_key (const gchar *parent_id, const gchar *type_name)
+{
+        return g_strdup_printf ("%s/%s", parent_id, type_name);
+}
+
+static void
+gfbgraph_store_unindex_id (GFBGraphStore *store, const gchar *id)
+{
+        GFBGraphStoreEntry *entry;
+        GHashTableIter iter;
+        gpointer parent_iter;
+
+        entry = g_hash_table_lookup (store->priv->entries, id);
+        if (entry == NULL)
+                return;
+
+        g_hash_table_iter_init (&iter, entry->parents);
+        while (g_hash_table_iter_next (&iter, NULL, &parent_iter)) {
+                if (parent_iter != NULL)
+                        g_sequence_remove (parent_iter);
+        }
+
+        g_hash_table_remove (store->priv->entries, id);
+}
+
+/* Takes the ownership of @entry, replacing any other with the same ID */
+static void
+gfbgraph_store_index_entry (GFBGraphStore *store, GFBGraphStoreEntry *entry)
+{
+        GFBGraphStorePrivate *priv;
+        GHashTableIter iter;
+        gpointer parent_key;
+
+        priv = store->priv;
+
+        gfbgraph_store_unindex_id (store, entry->id);
+
+        g_hash_table_insert (priv->entries, entry->id, entry);
+
+        g_hash_table_iter_init (&iter, entry->parents);
+        while (g_hash_table_iter_next (&iter, &parent_key, NULL)) {
+                GSequence *sequence;
+
+                sequence = g_hash_table_lookup (priv->connections, parent_key);
+                if (sequence == NULL) {
+                        sequence = g_sequence_new (NULL);
+                        g_hash_table_insert (priv->connections, g_strdup (parent_key), sequence);
+                }
+
+                g_hash_table_iter_replace (&iter, g_sequence_insert_sorted (sequence, entry, gfbgraph_store_entry_compare, NULL));
+        }
+}
+
+/* Returns the string value of the member, or NULL if the record has no such
+ * member or it isn't a string */
+static const gchar*
+gfbgraph_store_record_get_string (JsonObject *record, const gchar *member_name)
+{
+        JsonNode *member;
+
+        member = json_object_get_member (record, member_name);
+        if (member == NULL
+            || !JSON_NODE_HOLDS_VALUE (member)
+            || json_node_get_value_type (member) != G_TYPE_STRING)
+                return NULL;
+
+        return json_node_get_string (member);
+}
+
+/* Replays a record of the log. Records are objects with the node "id" and either
+ * a "removed" mark or the node "type", "created" time, "node" data and, optionally,
+ * the "parents" IDs. Records without a string "id" or "type" are skipped. */
+static void
+gfbgraph_store_apply_record (GFBGraphStore *store, JsonObject *record)
+{
+        GFBGraphStoreEntry *entry;
+        const gchar *id;
+        const gchar *type_name;
+
+        id = gfbgraph_store_record_get_string (record, "id");
+        if (id == NULL)
+                return;
+
+        if (json_object_has_member (record, "removed")) {
+                gfbgraph_store_unindex_id (store, id);
+                return;
+        }
+
+        type_name = gfbgraph_store_record_get_string (record, "type");
+        if (type_name == NULL
+            || json_object_has_member (record, "node") == FALSE)
+                return;
+
+        entry = gfbgraph_store_entry_new (id, type_name);
+        entry->json = json_node_copy (json_object_get_member (record, "node"));
+        if (json_object_has_member (record, "created"))
+                entry->created_time = json_object_get_int_member (record, "created");
+        if (json_object_has_member (record, "parents")) {
+                JsonArray *parents;
+                guint i;
+
+                parents = json_object_get_array_member (record, "parents");
+                for (i = 0; parents != NULL && i < json_array_get_length (parents); i++) {
+                        JsonNode *parent;
+
+                        parent = json_array_get_element (parents, i);
+                        if (!JSON_NODE_HOLDS_VALUE (parent) || json_node_get_value_type (parent) != G_TYPE_STRING)
+                                continue;
+
+                        g_hash_table_insert (entry->parents,
+                                             gfbgraph_store_parent_key (json_node_get_string (parent), entry->type_name),
+                                             NULL);
+                }
+        }
+
+        gfbgraph_store_index_entry (store, entry);
+}
+
+static gchar*
+gfbgraph_store_record_to_line (JsonObject *record)
+{
+        JsonGenerator *generator;
+        JsonNode *root;
+        gchar *data;
+        gchar *line;
+
+        root = json_node_new (JSON_NODE_OBJECT);
+        json_node_set_object (root, record);
+
+        generator = json_generator_new ();
+        json_generator_set_root (generator, root);
+        data = json_generator_to_data (generator, NULL);
+        line = g_strconcat (data, "\n", NULL);
+
+        g_free (data);
+        g_object_unref (generator);
+        json_node_free (root);
+
+        return line;
+}
+
+static gchar*
+gfbgraph_store_entry_to_line (GFBGraphStoreEntry *entry)
+{
+        JsonObject *record;
+        gchar *line;
+
+        record = json_object_new ();
+        json_object_set_string_member (record, "id", entry->id);
+        json_object_set_string_member (record, "type", entry->type_name);
+        json_object_set_int_member (record, "created", entry->created_time);
+        if (g_hash_table_size (entry->parents) > 0) {
+                GHashTableIter iter;
+                JsonArray *parents;
+                gpointer parent_key;
+
+                parents = json_array_new ();
+                g_hash_table_iter_init (&iter, entry->parents);
+                while (g_hash_table_iter_next (&iter, &parent_key, NULL)) {
+                        gchar *parent_id;
+
+                        parent_id = g_strndup (parent_key, strrchr (parent_key, '/') - (gchar *) parent_key);
+                        json_array_add_string_element (parents, parent_id);
+                        g_free (parent_id);
+                }
+                json_object_set_array_member (record, "parents", parents);
+        }
+        json_object_set_member (record, "node", json_node_copy (entry->json));
+
+        line = gfbgraph_store_record_to_line (record);
+        json_object_unref (record);
+
+        return line;
+}
+
+static gboolean
+gfbgraph_store_open_log (GFBGraphStore *store, GError **error)
+{
+        GFile *file;
+        GFileOutputStream *stream;
+
+        file = g_file_new_for_path (store->priv->path);
+        stream = g_file_append_to (file, G_FILE_CREATE_NONE, NULL, error);
+        g_object_unref (file);
+
+        if (stream == NULL)
+                return FALSE;
+
+        store->priv->log = G_OUTPUT_STREAM (stream);
+
+        return TRUE;
+}
+
+static gboolean
+gfbgraph_store_load (GFBGraphStore *store, GError **error)
+{
+        GMappedFile *mapped_file;
+        JsonParser *jparser;
+        const gchar *contents;
+        const gchar *line;
+        const gchar *end;
+        gsize length;
+        gsize valid_length;
+        gboolean res = TRUE;
+
+        if (g_file_test (store->priv->path, G_FILE_TEST_EXISTS) == FALSE)
+                return TRUE;
+
+        mapped_file = g_mapped_file_new (store->priv->path, FALSE, error);
+        if (mapped_file == NULL)
+                return FALSE;
+
+        contents = g_mapped_file_get_contents (mapped_file);
+        length = g_mapped_file_get_length (mapped_file);
+
+        jparser = json_parser_new ();
+
+        valid_length = 0;
+        for (line = contents; line < contents + length; line = end + 1) {
+                end = memchr (line, '\n', contents + length - line);
+                /* A partial last line, left by an interrupted write */
+                if (end == NULL)
+                        break;
+
+                valid_length = end + 1 - contents;
+
+                if (end > line
+                    && json_parser_load_from_data (jparser, line, end - line, NULL)
+                    && JSON_NODE_HOLDS_OBJECT (json_parser_get_root (jparser)))
+                        gfbgraph_store_apply_record (store, json_node_get_object (json_parser_get_root (jparser)));
+        }
+
+        g_object_unref (jparser);
+        g_mapped_file_unref (mapped_file);
+
+        /* Drop the partial line, or the next record would be appended to it
+         * and lost with it on the next load */
+        if (valid_length < length) {
+                GFileIOStream *stream;
+                GFile *file;
+
+                file = g_file_new_for_path (store->priv->path);
+                stream = g_file_open_readwrite (file, NULL, error);
+                g_object_unref (file);
+
+                if (stream == NULL)
+                        return FALSE;
+
+                res = g_seekable_truncate (G_SEEKABLE (stream), valid_length, NULL, error);
+                g_io_stream_close (G_IO_STREAM (stream), NULL, NULL);
+                g_object_unref (stream);
+        }
+
+        return res;
+}
+
+static gboolean
+gfbgraph_store_append (GFBGraphStore *store, const gchar *line, GError **error)
+{
+        if (!g_output_stream_write_all (store->priv->log, line, strlen (line), NULL, NULL, error))
+                return FALSE;
+
+        return g_output_stream_flush (store->priv->log, NULL, error);
+}
+
+/* Logs @entry and indexes it, replacing the previous version. Takes the ownership of @entry. */
+static gboolean
+gfbgraph_store_write_entry_locked (GFBGraphStore *store, GFBGraphStoreEntry *entry, GError **error)
+{
+        gchar *line;
+
+        line = gfbgraph_store_entry_to_line (entry);
+        if (!gfbgraph_store_append (store, line, error)) {
+                g_free (line);
+                gfbgraph_store_entry_free (entry);
+                return FALSE;
+        }
+        g_free (line);
+
+        gfbgraph_store_index_entry (store, entry);
+
+        return TRUE;
+}
+
+static gboolean
+gfbgraph_store_put_locked (GFBGraphStore *store, GFBGraphNode *node, const gchar *parent_id, GError **error)
+{
+        GFBGraphStoreEntry *entry;
+        GFBGraphStoreEntry *old_entry;
+
+        entry = gfbgraph_store_entry_new (gfbgraph_node_get_id (node), G_OBJECT_TYPE_NAME (node));
+        entry->created_time = gfbgraph_iso8601_to_unix (gfbgraph_node_get_created_time (node));
+        entry->json = gfbgraph_node_serialize (node);
+
+        /* Keep the connections of a node already stored */
+        old_entry = g_hash_table_lookup (store->priv->entries, entry->id);
+        if (old_entry != NULL)
+                gfbgraph_store_entry_add_parents (entry, old_entry);
+
+        if (parent_id != NULL)
+                g_hash_table_insert (entry->parents, gfbgraph_store_parent_key (parent_id, entry->type_name), NULL);
+
+        return gfbgraph_store_write_entry_locked (store, entry, error);
+}
+
+static gboolean
+gfbgraph_store_remove_locked (GFBGraphStore *store, const gchar *id, GError **error)
+{
+        JsonObject *record;
+        gchar *line;
+        gboolean res;
+
+        if (g_hash_table_contains (store->priv->entries, id) == FALSE)
+                return TRUE;
+
+        record = json_object_new ();
+        json_object_set_string_member (record, "id", id);
+        json_object_set_boolean_member (record, "removed", TRUE);
+        line = gfbgraph_store_record_to_line (record);
+        json_object_unref (record);
+
+        res = gfbgraph_store_append (store, line, error);
+        if (res)
+                gfbgraph_store_unindex_id (store, id);
+
+        g_free (line);
+
+        return res;
+}
+
+/* Takes the node @id out of the connection @parent_key, and removes it if it
+ * isn't in any other connection */
+static gboolean
+gfbgraph_store_unlink_locked (GFBGraphStore *store, const gchar *id, const gchar *parent_key, GError **error)
+{
+        GFBGraphStoreEntry *entry;
+        GFBGraphStoreEntry *old_entry;
+
+        old_entry = g_hash_table_lookup (store->priv->entries, id);
+        if (old_entry == NULL || !g_hash_table_contains (old_entry->parents, parent_key))
+                return TRUE;
+
+        if (g_hash_table_size (old_entry->parents) == 1)
+                return gfbgraph_store_remove_locked (store, id, error);
+
+        entry = gfbgraph_store_entry_new (old_entry->id, old_entry->type_name);
+        entry->created_time = old_entry->created_time;
+        entry->json = json_node_copy (old_entry->json);
+        gfbgraph_store_entry_add_parents (entry, old_entry);
+        g_hash_table_remove (entry->parents, parent_key);
+
+        return gfbgraph_store_write_entry_locked (store, entry, error);
+}
+
+static GFBGraphNode*
+gfbgraph_store_entry_to_node (GFBGraphStoreEntry *entry)
+{
+        GType node_type;
+
+        node_type = gfbgraph_node_type_from_name (entry->type_name);
+        if (node_type == G_TYPE_INVALID)
+                return NULL;
+
+        return gfbgraph_node_deserialize (node_type, entry->json, NULL);
+}
+
+static void
+gfbgraph_store_refresh_async_data_free (GFBGraphStoreRefreshAsyncData *data)
+{
+        g_object_unref (data->node);
+        g_object_unref (data->authorizer);
+
+        g_slice_free (GFBGraphStoreRefreshAsyncData, data);
+}
+
+static void
+gfbgraph_store_refresh_connection_async_thread (GSimpleAsyncResult *simple_async, GFBGraphStore *store, GCancellable *cancellable)
+{
+        GFBGraphStoreRefreshAsyncData *data;
+        GError *error;
+
+        data = (GFBGraphStoreRefreshAsyncData *) g_simple_async_result_get_op_res_gpointer (simple_async);
+
+        error = NULL;
+        if (!gfbgraph_store_refresh_connection (store, data->node, data->node_type, data->authorizer, &error))
+                g_simple_async_result_take_error (simple_async, error);
+}
+
+/**
+ * gfbgraph_store_new:
+ * @path: the path of the store log file.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Opens the store saved in @path, creating it if it doesn't exist.
+ *
+ * Returns: (transfer full): a new #GFBGraphStore or %NULL in case of error; unref with g_object_unref()
+ **/
+GFBGraphStore*
+gfbgraph_store_new (const gchar *path, GError **error)
+{
+        GFBGraphStore *store;
+
+        g_return_val_if_fail (path != NULL, NULL);
+
+        store = GFBGRAPH_STORE (g_object_new (GFBGRAPH_TYPE_STORE, "path", path, NULL));
+
+        if (!gfbgraph_store_load (store, error) || !gfbgraph_store_open_log (store, error))
+                g_clear_object (&store);
+
+        return store;
+}
+
+/**
+ * gfbgraph_store_put:
+ * @store: a #GFBGraphStore.
+ * @node: the #GFBGraphNode to save.
+ * @parent: (allow-none): the #GFBGraphNode which @node is connected to, or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Saves @node in @store, replacing any previous version of it. When @parent is given,
+ * @node will be returned by gfbgraph_store_get_connection_nodes() for @parent.
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_store_put (GFBGraphStore *store, GFBGraphNode *node, GFBGraphNode *parent, GError **error)
+{
+        gboolean res;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), FALSE);
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), FALSE);
+        g_return_val_if_fail (gfbgraph_node_get_id (node) != NULL, FALSE);
+        g_return_val_if_fail (parent == NULL || GFBGRAPH_IS_NODE (parent), FALSE);
+
+        g_mutex_lock (&store->priv->mutex);
+        res = gfbgraph_store_put_locked (store, node, parent ? gfbgraph_node_get_id (parent) : NULL, error);
+        g_mutex_unlock (&store->priv->mutex);
+
+        return res;
+}
+
+/**
+ * gfbgraph_store_remove:
+ * @store: a #GFBGraphStore.
+ * @id: the ID of the node to remove.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Removes the node with the ID @id from @store.
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_store_remove (GFBGraphStore *store, const gchar *id, GError **error)
+{
+        gboolean res;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), FALSE);
+        g_return_val_if_fail (id != NULL, FALSE);
+
+        g_mutex_lock (&store->priv->mutex);
+        res = gfbgraph_store_remove_locked (store, id, error);
+        g_mutex_unlock (&store->priv->mutex);
+
+        return res;
+}
+
+/**
+ * gfbgraph_store_lookup_node:
+ * @store: a #GFBGraphStore.
+ * @id: the ID of the node.
+ *
+ * Retrieves a node from @store.
+ *
+ * Returns: (transfer full): a new #GFBGraphNode, or %NULL if @store doesn't have it.
+ **/
+GFBGraphNode*
+gfbgraph_store_lookup_node (GFBGraphStore *store, const gchar *id)
+{
+        GFBGraphStoreEntry *entry;
+        GFBGraphNode *node = NULL;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), NULL);
+        g_return_val_if_fail (id != NULL, NULL);
+
+        g_mutex_lock (&store->priv->mutex);
+
+        entry = g_hash_table_lookup (store->priv->entries, id);
+        if (entry != NULL)
+                node = gfbgraph_store_entry_to_node (entry);
+
+        g_mutex_unlock (&store->priv->mutex);
+
+        return node;
+}
+
+/**
+ * gfbgraph_store_get_connection_nodes:
+ * @store: a #GFBGraphStore.
+ * @node: a #GFBGraphNode.
+ * @node_type: a #GFBGraphNode type #GType that determines the kind of nodes to retrieve.
+ * @since: a time in seconds since the Epoch, or 0.
+ *
+ * Retrieves from @store the nodes of type @node_type connected to @node, from the newest
+ * to the oldest one. If @since isn't 0, only the nodes created from that time are returned.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer full): a new #GPtrArray with the nodes.
+ * Free it with g_ptr_array_unref().
+ **/
+GPtrArray*
+gfbgraph_store_get_connection_nodes (GFBGraphStore *store, GFBGraphNode *node, GType node_type, gint64 since)
+{
+        GPtrArray *nodes;
+        GSequence *sequence;
+        gchar *parent_key;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), NULL);
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+        parent_key = gfbgraph_store_parent_key (gfbgraph_node_get_id (node), g_type_name (node_type));
+
+        g_mutex_lock (&store->priv->mutex);
+
+        sequence = g_hash_table_lookup (store->priv->connections, parent_key);
+        if (sequence != NULL) {
+                GSequenceIter *iter;
+
+                for (iter = g_sequence_get_begin_iter (sequence);
+                     !g_sequence_iter_is_end (iter);
+                     iter = g_sequence_iter_next (iter)) {
+                        GFBGraphStoreEntry *entry;
+                        GFBGraphNode *connected_node;
+
+                        entry = g_sequence_get (iter);
+                        if (since > 0 && entry->created_time < since)
+                                break;
+
+                        connected_node = gfbgraph_store_entry_to_node (entry);
+                        if (connected_node != NULL)
+                                g_ptr_array_add (nodes, connected_node);
+                }
+        }
+
+        g_mutex_unlock (&store->priv->mutex);
+
+        g_free (parent_key);
+
+        return nodes;
+}
+
+/**
+ * gfbgraph_store_compact:
+ * @store: a #GFBGraphStore.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Rewrites the store log with just the current version of every node. The log
+ * is replaced atomically, so it's never left half written.
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_store_compact (GFBGraphStore *store, GError **error)
+{
+        GFBGraphStorePrivate *priv;
+        GHashTableIter iter;
+        GString *contents;
+        gpointer entry;
+        gboolean res;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), FALSE);
+
+        priv = store->priv;
+
+        g_mutex_lock (&priv->mutex);
+
+        contents = g_string_new (NULL);
+        g_hash_table_iter_init (&iter, priv->entries);
+        while (g_hash_table_iter_next (&iter, NULL, &entry)) {
+                gchar *line;
+
+                line = gfbgraph_store_entry_to_line ((GFBGraphStoreEntry *) entry);
+                g_string_append (contents, line);
+                g_free (line);
+        }
+
+        res = g_file_set_contents (priv->path, contents->str, contents->len, error);
+        if (res) {
+                /* The old log was replaced, so append to the new one */
+                g_output_stream_close (priv->log, NULL, NULL);
+                g_clear_object (&priv->log);
+                res = gfbgraph_store_open_log (store, error);
+        }
+
+        g_mutex_unlock (&priv->mutex);
+
+        g_string_free (contents, TRUE);
+
+        return res;
+}
+
+/**
+ * gfbgraph_store_refresh_connection:
+ * @store: a #GFBGraphStore.
+ * @node: a #GFBGraphNode.
+ * @node_type: a #GFBGraphNode type #GType, connectable to @node.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Retrieves all the nodes of type @node_type connected to @node from the Graph API
+ * and updates @store with them, removing the ones that aren't connected anymore, unless
+ * they are still in another connection of the store.
+ * See gfbgraph_store_refresh_connection_async() for the asynchronous version of this call.
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_store_refresh_connection (GFBGraphStore *store, GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        GFBGraphStorePrivate *priv;
+        GPtrArray *nodes;
+        GHashTable *params;
+        GHashTable *seen_ids;
+        GPtrArray *removed_ids;
+        GSequence *sequence;
+        gchar *parent_key;
+        gboolean res;
+        guint i;
+
+        g_return_val_if_fail (GFBGRAPH_IS_STORE (store), FALSE);
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), FALSE);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), FALSE);
+
+        priv = store->priv;
+
+        /* Retrieve everything first, so the store isn't locked during the requests */
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+        params = NULL;
+        do {
+                GPtrArray *page;
+                GHashTable *next_params;
+
+                page = gfbgraph_node_fetch_connection_page (node, node_type, authorizer, params, &next_params, NULL, error);
+                if (params != NULL)
+                        g_hash_table_unref (params);
+                params = next_params;
+
+                if (page == NULL) {
+                        if (params != NULL)
+                                g_hash_table_unref (params);
+                        g_ptr_array_unref (nodes);
+                        return FALSE;
+                }
+
+                for (i = 0; i < page->len; i++)
+                        g_ptr_array_add (nodes, g_object_ref (g_ptr_array_index (page, i)));
+                g_ptr_array_unref (page);
+        } while (params != NULL);
+
+        seen_ids = g_hash_table_new (g_str_hash, g_str_equal);
+        removed_ids = g_ptr_array_new_with_free_func (g_free);
+        parent_key = gfbgraph_store_parent_key (gfbgraph_node_get_id (node), g_type_name (node_type));
+        res = TRUE;
+
+        g_mutex_lock (&priv->mutex);
+
+        for (i = 0; i < nodes->len && res; i++) {
+                GFBGraphNode *connected_node;
+
+                connected_node = g_ptr_array_index (nodes, i);
+                if (gfbgraph_node_get_id (connected_node) == NULL)
+                        continue;
+
+                g_hash_table_add (seen_ids, (gpointer) gfbgraph_node_get_id (connected_node));
+                res = gfbgraph_store_put_locked (store, connected_node, gfbgraph_node_get_id (node), error);
+        }
+
+        sequence = g_hash_table_lookup (priv->connections, parent_key);
+        if (res && sequence != NULL) {
+                GSequenceIter *iter;
+
+                for (iter = g_sequence_get_begin_iter (sequence);
+                     !g_sequence_iter_is_end (iter);
+                     iter = g_sequence_iter_next (iter)) {
+                        GFBGraphStoreEntry *entry;
+
+                        entry = g_sequence_get (iter);
+                        if (g_hash_table_contains (seen_ids, entry->id) == FALSE)
+                                g_ptr_array_add (removed_ids, g_strdup (entry->id));
+                }
+        }
+
+        /* They could still be in other connections */
+        for (i = 0; i < removed_ids->len && res; i++)
+                res = gfbgraph_store_unlink_locked (store, g_ptr_array_index (removed_ids, i), parent_key, error);
+
+        g_mutex_unlock (&priv->mutex);
+
+        g_free (parent_key);
+        g_ptr_array_unref (removed_ids);
+        g_hash_table_unref (seen_ids);
+        g_ptr_array_unref (nodes);
+
+        return res;
+}
+
+/**
+ * gfbgraph_store_refresh_connection_async:
+ * @store: a #GFBGraphStore.
+ * @node: a #GFBGraphNode.
+ * @node_type: a #GFBGraphNode type #GType, connectable to @node.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @cancellable: (allow-none): An optional #GCancellable object, or %NULL.
+ * @callback: (scope async): A #GAsyncReadyCallback to call when the request is completed.
+ * @user_data: (closure): The data to pass to @callback.
+ *
+ * Asynchronously updates the nodes connected to @node in @store. See
+ * gfbgraph_store_refresh_connection() for the synchronous version of this call.
+ *
+ * When the operation is finished, @callback will be called. You can then call
+ * gfbgraph_store_refresh_connection_async_finish() to get the result of the operation.
+ **/
+void
+gfbgraph_store_refresh_connection_async (GFBGraphStore *store, GFBGraphNode *node, GType node_type, GFBGraphAuthorizer *authorizer, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+        GSimpleAsyncResult *result;
+        GFBGraphStoreRefreshAsyncData *data;
+
+        g_return_if_fail (GFBGRAPH_IS_STORE (store));
+        g_return_if_fail (GFBGRAPH_IS_NODE (node));
+        g_return_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer));
+        g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+        g_return_if_fail (callback != NULL);
+
+        result = g_simple_async_result_new (G_OBJECT (store), callback, user_data, gfbgraph_store_refresh_connection_async);
+        g_simple_async_result_set_check_cancellable (result, cancellable);
+
+        data = g_slice_new (GFBGraphStoreRefreshAsyncData);
+        data->node = g_object_ref (node);
+        data->node_type = node_type;
+        data->authorizer = g_object_ref (authorizer);
+
+        g_simple_async_result_set_op_res_gpointer (result, data, (GDestroyNotify) gfbgraph_store_refresh_async_data_free);
+        gfbgraph_simple_async_run_in_thread (result, (GSimpleAsyncThreadFunc) gfbgraph_store_refresh_connection_async_thread, cancellable);
+
+        g_object_unref (result);
+}
+
+/**
+ * gfbgraph_store_refresh_connection_async_finish:
+ * @store: a #GFBGraphStore.
+ * @result: A #GAsyncResult.
+ * @error: (allow-none): An optional #GError, or %NULL.
+ *
+ * Finishes an asynchronous operation started with
+ * gfbgraph_store_refresh_connection_async().
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_store_refresh_connection_async_finish (GFBGraphStore *store, GAsyncResult *result, GError **error)
+{
+        g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (store), gfbgraph_store_refresh_connection_async), FALSE);
+        g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+        return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error);
+}
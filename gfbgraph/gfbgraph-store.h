@@ -0,0 +1,78 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_STORE_H__
+#define __GFBGRAPH_STORE_H__
+
+#include <gio/gio.h>
+#include <gfbgraph/gfbgraph-authorizer.h>
+#include <gfbgraph/gfbgraph-node.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_STORE             (gfbgraph_store_get_type())
+#define GFBGRAPH_STORE(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GFBGRAPH_TYPE_STORE,GFBGraphStore))
+#define GFBGRAPH_STORE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass),GFBGRAPH_TYPE_STORE,GFBGraphStoreClass))
+#define GFBGRAPH_IS_STORE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj),GFBGRAPH_TYPE_STORE))
+#define GFBGRAPH_IS_STORE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass),GFBGRAPH_TYPE_STORE))
+#define GFBGRAPH_STORE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj),GFBGRAPH_TYPE_STORE,GFBGraphStoreClass))
+
+typedef struct _GFBGraphStore        GFBGraphStore;
+typedef struct _GFBGraphStoreClass   GFBGraphStoreClass;
+typedef struct _GFBGraphStorePrivate GFBGraphStorePrivate;
+
+struct _GFBGraphStore {
+        GObject parent;
+
+        /*< private >*/
+        GFBGraphStorePrivate *priv;
+};
+
+struct _GFBGraphStoreClass {
+        GObjectClass parent_class;
+};
+
+GType          gfbgraph_store_get_type (void) G_GNUC_CONST;
+GFBGraphStore* gfbgraph_store_new      (const gchar *path, GError **error);
+
+gboolean       gfbgraph_store_put         (GFBGraphStore *store, GFBGraphNode *node, GFBGraphNode *parent, GError **error);
+gboolean       gfbgraph_store_remove      (GFBGraphStore *store, const gchar *id, GError **error);
+GFBGraphNode*  gfbgraph_store_lookup_node (GFBGraphStore *store, const gchar *id);
+GPtrArray*     gfbgraph_store_get_connection_nodes (GFBGraphStore *store, GFBGraphNode *node, GType node_type, gint64 since);
+gboolean       gfbgraph_store_compact     (GFBGraphStore *store, GError **error);
+
+gboolean       gfbgraph_store_refresh_connection              (GFBGraphStore       *store,
+                                                               GFBGraphNode        *node,
+                                                               GType                node_type,
+                                                               GFBGraphAuthorizer  *authorizer,
+                                                               GError             **error);
+void           gfbgraph_store_refresh_connection_async        (GFBGraphStore       *store,
+                                                               GFBGraphNode        *node,
+                                                               GType                node_type,
+                                                               GFBGraphAuthorizer  *authorizer,
+                                                               GCancellable        *cancellable,
+                                                               GAsyncReadyCallback  callback,
+                                                               gpointer             user_data);
+gboolean       gfbgraph_store_refresh_connection_async_finish (GFBGraphStore       *store,
+                                                               GAsyncResult        *result,
+                                                               GError             **error);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_STORE_H__ */
@@ -0,0 +1,553 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gfbgraph-sync
+ * @short_description: Incremental synchronization of node connections
+ * @stability: Unstable
+ * @include: gfbgraph/gfbgraph.h
+ *
+ * #GFBGraphSync keeps a local copy of the nodes connected to a node up to date without
+ * listing all of them on every round. It remembers the newest created or updated time seen
+ * (the high-water mark) and asks the Graph API only for the nodes after it with the
+ * "since" param, following the pages of the response.
+ *
+ * After every gfbgraph_sync_run() the nodes new to the synchronization are available with
+ * gfbgraph_sync_get_added(), the ones already known but modified with
+ * gfbgraph_sync_get_changed(), and the IDs of the nodes that disappeared with
+ * gfbgraph_sync_get_removed(). Detecting removals requires listing the IDs of all the
+ * connected nodes, which can be disabled with the #GFBGraphSync:track-removals property.
+ *
+ * The synchronization state can be saved with gfbgraph_sync_save_state() and restored in
+ * another session with gfbgraph_sync_load_state().
+ **/
+
+#include "gfbgraph-sync.h"
+#include "gfbgraph-private.h"
+
+#define SYNC_STATE_FORMAT "(xas)"
+
+/* Listing just the IDs is cheap, so ask for big pages */
+#define SYNC_IDS_PAGE_LIMIT "500"
+
+enum
+{
+        PROP_0,
+
+        PROP_NODE,
+        PROP_NODE_TYPE,
+        PROP_TRACK_REMOVALS
+};
+
+struct _GFBGraphSyncPrivate {
+        GFBGraphNode *node;
+        GType node_type;
+        gboolean track_removals;
+
+        gint64 high_water_mark;
+        GHashTable *known_ids;
+
+        GPtrArray *added;
+        GPtrArray *changed;
+        GPtrArray *removed;
+};
+
+static void gfbgraph_sync_init         (GFBGraphSync *obj);
+static void gfbgraph_sync_class_init   (GFBGraphSyncClass *klass);
+static void gfbgraph_sync_finalize     (GObject *obj);
+static void gfbgraph_sync_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
+static void gfbgraph_sync_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+static gint64   gfbgraph_sync_node_time      (GFBGraphNode *node);
+static gboolean gfbgraph_sync_fetch_changes  (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GHashTable *new_ids, gint64 *new_high_water_mark, GError **error);
+static gboolean gfbgraph_sync_fetch_removals (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GError **error);
+
+#define GFBGRAPH_SYNC_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE((o), GFBGRAPH_TYPE_SYNC, GFBGraphSyncPrivate))
+
+static GObjectClass *parent_class = NULL;
+
+G_DEFINE_TYPE (GFBGraphSync, gfbgraph_sync, G_TYPE_OBJECT);
+
+static void
+gfbgraph_sync_init (GFBGraphSync *obj)
+{
+        obj->priv = GFBGRAPH_SYNC_GET_PRIVATE(obj);
+
+        obj->priv->track_removals = TRUE;
+        obj->priv->known_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        obj->priv->added = g_ptr_array_new_with_free_func (g_object_unref);
+        obj->priv->changed = g_ptr_array_new_with_free_func (g_object_unref);
+        obj->priv->removed = g_ptr_array_new_with_free_func (g_free);
+}
+
+static void
+gfbgraph_sync_class_init (GFBGraphSyncClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        parent_class            = g_type_class_peek_parent (klass);
+        gobject_class->finalize = gfbgraph_sync_finalize;
+        gobject_class->set_property = gfbgraph_sync_set_property;
+        gobject_class->get_property = gfbgraph_sync_get_property;
+
+        g_type_class_add_private (gobject_class, sizeof(GFBGraphSyncPrivate));
+
+        /**
+         * GFBGraphSync:node:
+         *
+         * The node whose connections are synchronized.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_NODE,
+                                         g_param_spec_object ("node",
+                                                              "The synchronized node", "The node whose connections are synchronized",
+                                                              GFBGRAPH_TYPE_NODE,
+                                                              G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphSync:node-type:
+         *
+         * The #GType of the connected nodes, it must implement the #GFBGraphConnectable interface.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_NODE_TYPE,
+                                         g_param_spec_gtype ("node-type",
+                                                             "The connected nodes type", "The GType of the connected nodes",
+                                                             GFBGRAPH_TYPE_NODE,
+                                                             G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+
+        /**
+         * GFBGraphSync:track-removals:
+         *
+         * Whether to look for removed nodes on every run. It needs to list the IDs of
+         * all the connected nodes, so disable it if the removals aren't interesting.
+         **/
+        g_object_class_install_property (gobject_class,
+                                         PROP_TRACK_REMOVALS,
+                                         g_param_spec_boolean ("track-removals",
+                                                               "Track removals", "Whether to look for removed nodes",
+                                                               TRUE,
+                                                               G_PARAM_READABLE | G_PARAM_WRITABLE));
+}
+
+static void
+gfbgraph_sync_finalize (GObject *obj)
+{
+        GFBGraphSyncPrivate *priv;
+
+        priv = GFBGRAPH_SYNC_GET_PRIVATE (obj);
+
+        g_clear_object (&priv->node);
+        g_hash_table_unref (priv->known_ids);
+        g_ptr_array_unref (priv->added);
+        g_ptr_array_unref (priv->changed);
+        g_ptr_array_unref (priv->removed);
+
+        G_OBJECT_CLASS(parent_class)->finalize (obj);
+}
+
+static void
+gfbgraph_sync_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+        GFBGraphSyncPrivate *priv;
+
+        priv = GFBGRAPH_SYNC_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_NODE:
+                        priv->node = g_value_dup_object (value);
+                        break;
+                case PROP_NODE_TYPE:
+                        priv->node_type = g_value_get_gtype (value);
+                        break;
+                case PROP_TRACK_REMOVALS:
+                        priv->track_removals = g_value_get_boolean (value);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_sync_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+        GFBGraphSyncPrivate *priv;
+
+        priv = GFBGRAPH_SYNC_GET_PRIVATE (object);
+
+        switch (prop_id) {
+                case PROP_NODE:
+                        g_value_set_object (value, priv->node);
+                        break;
+                case PROP_NODE_TYPE:
+                        g_value_set_gtype (value, priv->node_type);
+                        break;
+                case PROP_TRACK_REMOVALS:
+                        g_value_set_boolean (value, priv->track_removals);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+/* The last time the node was modified, in seconds since the Epoch, or 0 if unknown */
+static gint64
+gfbgraph_sync_node_time (GFBGraphNode *node)
+{
+        const gchar *iso_time;
+
+        iso_time = gfbgraph_node_get_updated_time (node);
+        if (iso_time == NULL)
+                iso_time = gfbgraph_node_get_created_time (node);
+
+        return gfbgraph_iso8601_to_unix (iso_time);
+}
+
+/* Adds the nodes new or modified since the high-water mark to the added and
+ * changed arrays. The IDs of the added nodes and the new mark are only staged
+ * in @new_ids and @new_high_water_mark, and committed by gfbgraph_sync_run()
+ * once the whole run succeeded, so a failed run can be retried as is. */
+static gboolean
+gfbgraph_sync_fetch_changes (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GHashTable *new_ids, gint64 *new_high_water_mark, GError **error)
+{
+        GFBGraphSyncPrivate *priv;
+        GHashTable *params;
+
+        priv = sync->priv;
+
+        params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        if (priv->high_water_mark > 0)
+                g_hash_table_insert (params, g_strdup ("since"), g_strdup_printf ("%" G_GINT64_FORMAT, priv->high_water_mark));
+
+        *new_high_water_mark = priv->high_water_mark;
+
+        while (params != NULL) {
+                GPtrArray *nodes;
+                GHashTable *next_params;
+                guint i;
+
+                nodes = gfbgraph_node_fetch_connection_page (priv->node, priv->node_type, authorizer, params, &next_params, NULL, error);
+                g_hash_table_unref (params);
+                params = next_params;
+
+                if (nodes == NULL) {
+                        if (params != NULL)
+                                g_hash_table_unref (params);
+                        return FALSE;
+                }
+
+                for (i = 0; i < nodes->len; i++) {
+                        GFBGraphNode *node;
+                        const gchar *id;
+                        gint64 node_time;
+                        gboolean known;
+
+                        node = g_ptr_array_index (nodes, i);
+                        id = gfbgraph_node_get_id (node);
+                        if (id == NULL || g_hash_table_contains (new_ids, id))
+                                continue;
+
+                        /* "since" filters by the creation time on most connections, so
+                         * known nodes not modified after the mark can still show up here */
+                        node_time = gfbgraph_sync_node_time (node);
+                        known = g_hash_table_contains (priv->known_ids, id);
+                        if (known && node_time <= priv->high_water_mark)
+                                continue;
+
+                        *new_high_water_mark = MAX (*new_high_water_mark, node_time);
+
+                        if (known) {
+                                g_ptr_array_add (priv->changed, g_object_ref (node));
+                        } else {
+                                g_hash_table_add (new_ids, g_strdup (id));
+                                g_ptr_array_add (priv->added, g_object_ref (node));
+                        }
+                }
+
+                g_ptr_array_unref (nodes);
+        }
+
+        return TRUE;
+}
+
+/* Adds the known IDs no longer connected to the removed array, without
+ * forgetting them yet */
+static gboolean
+gfbgraph_sync_fetch_removals (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        GFBGraphSyncPrivate *priv;
+        GHashTable *params;
+        GHashTable *current_ids;
+        GHashTableIter iter;
+        gpointer id;
+
+        priv = sync->priv;
+
+        params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        g_hash_table_insert (params, g_strdup ("fields"), g_strdup ("id"));
+        g_hash_table_insert (params, g_strdup ("limit"), g_strdup (SYNC_IDS_PAGE_LIMIT));
+
+        current_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        while (params != NULL) {
+                GPtrArray *nodes;
+                GHashTable *next_params;
+                guint i;
+
+                nodes = gfbgraph_node_fetch_connection_page (priv->node, priv->node_type, authorizer, params, &next_params, NULL, error);
+                g_hash_table_unref (params);
+                params = next_params;
+
+                if (nodes == NULL) {
+                        if (params != NULL)
+                                g_hash_table_unref (params);
+                        g_hash_table_unref (current_ids);
+                        return FALSE;
+                }
+
+                for (i = 0; i < nodes->len; i++) {
+                        const gchar *node_id;
+
+                        node_id = gfbgraph_node_get_id (GFBGRAPH_NODE (g_ptr_array_index (nodes, i)));
+                        if (node_id != NULL)
+                                g_hash_table_add (current_ids, g_strdup (node_id));
+                }
+
+                g_ptr_array_unref (nodes);
+        }
+
+        g_hash_table_iter_init (&iter, priv->known_ids);
+        while (g_hash_table_iter_next (&iter, &id, NULL)) {
+                if (g_hash_table_contains (current_ids, id) == FALSE)
+                        g_ptr_array_add (priv->removed, g_strdup (id));
+        }
+
+        g_hash_table_unref (current_ids);
+
+        return TRUE;
+}
+
+/**
+ * gfbgraph_sync_new:
+ * @node: a #GFBGraphNode.
+ * @node_type: a #GFBGraphNode type #GType, connectable to @node.
+ *
+ * Creates a new #GFBGraphSync to synchronize the nodes of type @node_type
+ * connected to @node.
+ *
+ * Returns: (transfer full): a new #GFBGraphSync; unref with g_object_unref()
+ **/
+GFBGraphSync*
+gfbgraph_sync_new (GFBGraphNode *node, GType node_type)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_NODE (node), NULL);
+        g_return_val_if_fail (g_type_is_a (node_type, GFBGRAPH_TYPE_NODE), NULL);
+
+        return GFBGRAPH_SYNC (g_object_new (GFBGRAPH_TYPE_SYNC,
+                                            "node", node,
+                                            "node-type", node_type,
+                                            NULL));
+}
+
+/**
+ * gfbgraph_sync_run:
+ * @sync: a #GFBGraphSync.
+ * @authorizer: a #GFBGraphAuthorizer.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Retrieves the changes in the connected nodes since the previous run. The first
+ * run, or the first one after loading an empty state, reports all the connected
+ * nodes as added. The results of the previous run are discarded.
+ *
+ * On error, no result is reported and neither the high-water mark nor the known
+ * nodes change, so the next run retrieves and reports the same changes again.
+ *
+ * Returns: %TRUE on success, %FALSE if an error ocurred.
+ **/
+gboolean
+gfbgraph_sync_run (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GError **error)
+{
+        GFBGraphSyncPrivate *priv;
+        GHashTable *new_ids;
+        gint64 new_high_water_mark;
+        gboolean res;
+
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), FALSE);
+        g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), FALSE);
+
+        priv = sync->priv;
+
+        g_ptr_array_set_size (priv->added, 0);
+        g_ptr_array_set_size (priv->changed, 0);
+        g_ptr_array_set_size (priv->removed, 0);
+
+        new_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+        res = gfbgraph_sync_fetch_changes (sync, authorizer, new_ids, &new_high_water_mark, error);
+
+        /* Nothing could have been removed on the first run */
+        if (res && priv->track_removals && g_hash_table_size (priv->known_ids) > 0)
+                res = gfbgraph_sync_fetch_removals (sync, authorizer, error);
+
+        if (res) {
+                GHashTableIter iter;
+                gpointer id;
+                guint i;
+
+                g_hash_table_iter_init (&iter, new_ids);
+                while (g_hash_table_iter_next (&iter, &id, NULL)) {
+                        g_hash_table_iter_steal (&iter);
+                        g_hash_table_add (priv->known_ids, id);
+                }
+
+                for (i = 0; i < priv->removed->len; i++)
+                        g_hash_table_remove (priv->known_ids, g_ptr_array_index (priv->removed, i));
+
+                priv->high_water_mark = new_high_water_mark;
+        } else {
+                g_ptr_array_set_size (priv->added, 0);
+                g_ptr_array_set_size (priv->changed, 0);
+                g_ptr_array_set_size (priv->removed, 0);
+        }
+
+        g_hash_table_unref (new_ids);
+
+        return res;
+}
+
+/**
+ * gfbgraph_sync_get_added:
+ * @sync: a #GFBGraphSync.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer none): the nodes found for the first time in the last run.
+ **/
+GPtrArray*
+gfbgraph_sync_get_added (GFBGraphSync *sync)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), NULL);
+
+        return sync->priv->added;
+}
+
+/**
+ * gfbgraph_sync_get_changed:
+ * @sync: a #GFBGraphSync.
+ *
+ * Returns: (element-type GFBGraphNode) (transfer none): the already known nodes updated since the previous run.
+ **/
+GPtrArray*
+gfbgraph_sync_get_changed (GFBGraphSync *sync)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), NULL);
+
+        return sync->priv->changed;
+}
+
+/**
+ * gfbgraph_sync_get_removed:
+ * @sync: a #GFBGraphSync.
+ *
+ * Returns: (element-type utf8) (transfer none): the IDs of the nodes removed since the previous run.
+ **/
+GPtrArray*
+gfbgraph_sync_get_removed (GFBGraphSync *sync)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), NULL);
+
+        return sync->priv->removed;
+}
+
+/**
+ * gfbgraph_sync_get_high_water_mark:
+ * @sync: a #GFBGraphSync.
+ *
+ * Returns: the newest created or updated time of the synchronized nodes, in seconds
+ * since the Epoch, or 0 if nothing was synchronized yet.
+ **/
+gint64
+gfbgraph_sync_get_high_water_mark (GFBGraphSync *sync)
+{
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), 0);
+
+        return sync->priv->high_water_mark;
+}
+
+/**
+ * gfbgraph_sync_save_state:
+ * @sync: a #GFBGraphSync.
+ *
+ * Saves the high-water mark and the known node IDs, so the synchronization can
+ * continue later with gfbgraph_sync_load_state().
+ *
+ * Returns: (transfer full): a floating #GVariant with the synchronization state.
+ **/
+GVariant*
+gfbgraph_sync_save_state (GFBGraphSync *sync)
+{
+        GVariantBuilder ids_builder;
+        GHashTableIter iter;
+        gpointer id;
+
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), NULL);
+
+        g_variant_builder_init (&ids_builder, G_VARIANT_TYPE ("as"));
+
+        g_hash_table_iter_init (&iter, sync->priv->known_ids);
+        while (g_hash_table_iter_next (&iter, &id, NULL))
+                g_variant_builder_add (&ids_builder, "s", id);
+
+        return g_variant_new (SYNC_STATE_FORMAT, sync->priv->high_water_mark, &ids_builder);
+}
+
+/**
+ * gfbgraph_sync_load_state:
+ * @sync: a #GFBGraphSync.
+ * @state: a #GVariant returned by gfbgraph_sync_save_state().
+ *
+ * Restores a synchronization state, replacing the current one.
+ *
+ * Returns: %TRUE if @state was loaded, %FALSE if it isn't a valid state.
+ **/
+gboolean
+gfbgraph_sync_load_state (GFBGraphSync *sync, GVariant *state)
+{
+        GFBGraphSyncPrivate *priv;
+        gchar **ids;
+        guint i;
+
+        g_return_val_if_fail (GFBGRAPH_IS_SYNC (sync), FALSE);
+        g_return_val_if_fail (state != NULL, FALSE);
+
+        if (g_variant_is_of_type (state, G_VARIANT_TYPE (SYNC_STATE_FORMAT)) == FALSE)
+                return FALSE;
+
+        priv = sync->priv;
+
+        g_hash_table_remove_all (priv->known_ids);
+        g_variant_get (state, "(x^as)", &priv->high_water_mark, &ids);
+        for (i = 0; ids[i] != NULL; i++)
+                g_hash_table_add (priv->known_ids, ids[i]);
+
+        /* The hash table owns the strings now */
+        g_free (ids);
+
+        return TRUE;
+}
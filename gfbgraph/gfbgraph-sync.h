@@ -0,0 +1,67 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_SYNC_H__
+#define __GFBGRAPH_SYNC_H__
+
+#include <glib-object.h>
+#include <gfbgraph/gfbgraph-authorizer.h>
+#include <gfbgraph/gfbgraph-node.h>
+
+G_BEGIN_DECLS
+
+#define GFBGRAPH_TYPE_SYNC             (gfbgraph_sync_get_type())
+#define GFBGRAPH_SYNC(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GFBGRAPH_TYPE_SYNC,GFBGraphSync))
+#define GFBGRAPH_SYNC_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass),GFBGRAPH_TYPE_SYNC,GFBGraphSyncClass))
+#define GFBGRAPH_IS_SYNC(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj),GFBGRAPH_TYPE_SYNC))
+#define GFBGRAPH_IS_SYNC_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass),GFBGRAPH_TYPE_SYNC))
+#define GFBGRAPH_SYNC_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj),GFBGRAPH_TYPE_SYNC,GFBGraphSyncClass))
+
+typedef struct _GFBGraphSync        GFBGraphSync;
+typedef struct _GFBGraphSyncClass   GFBGraphSyncClass;
+typedef struct _GFBGraphSyncPrivate GFBGraphSyncPrivate;
+
+struct _GFBGraphSync {
+        GObject parent;
+
+        /*< private >*/
+        GFBGraphSyncPrivate *priv;
+};
+
+struct _GFBGraphSyncClass {
+        GObjectClass parent_class;
+};
+
+GType         gfbgraph_sync_get_type (void) G_GNUC_CONST;
+GFBGraphSync* gfbgraph_sync_new      (GFBGraphNode *node, GType node_type);
+
+gboolean      gfbgraph_sync_run      (GFBGraphSync *sync, GFBGraphAuthorizer *authorizer, GError **error);
+
+GPtrArray*    gfbgraph_sync_get_added   (GFBGraphSync *sync);
+GPtrArray*    gfbgraph_sync_get_changed (GFBGraphSync *sync);
+GPtrArray*    gfbgraph_sync_get_removed (GFBGraphSync *sync);
+
+gint64        gfbgraph_sync_get_high_water_mark (GFBGraphSync *sync);
+
+GVariant*     gfbgraph_sync_save_state (GFBGraphSync *sync);
+gboolean      gfbgraph_sync_load_state (GFBGraphSync *sync, GVariant *state);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_SYNC_H__ */
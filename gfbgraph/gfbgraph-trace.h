@@ -0,0 +1,62 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Static tracepoints for SystemTap, bpftrace and perf, built when configured
+ * with --enable-dtrace. Otherwise they compile to nothing. This header isn't
+ * installed.
+ *
+ * The probes of the "gfbgraph" provider are:
+ *   request__start (method, function)
+ *   request__end (function, status_code, nodes)
+ *   auth__start (function), auth__end (function), the function is NULL for
+ *     the calls made with the public gfbgraph_new_rest_call()
+ *   parse__start (node_type_name), parse__end (node_type_name, nodes)
+ *   response__chunk (bytes), for the responses read by the library
+ *   download__start (uri), download__end (uri, status_code)
+ *   request__timeout (path), for the requests aborted at their deadline
+ */
+
+#ifndef __GFBGRAPH_TRACE_H__
+#define __GFBGRAPH_TRACE_H__
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_DTRACE
+
+#include <sys/sdt.h>
+
+#define GFBGRAPH_TRACE_ENABLED 1
+
+#define GFBGRAPH_TRACE1(probe, a)       DTRACE_PROBE1 (gfbgraph, probe, a)
+#define GFBGRAPH_TRACE2(probe, a, b)    DTRACE_PROBE2 (gfbgraph, probe, a, b)
+#define GFBGRAPH_TRACE3(probe, a, b, c) DTRACE_PROBE3 (gfbgraph, probe, a, b, c)
+
+#else
+
+#define GFBGRAPH_TRACE_ENABLED 0
+
+#define GFBGRAPH_TRACE1(probe, a)
+#define GFBGRAPH_TRACE2(probe, a, b)
+#define GFBGRAPH_TRACE3(probe, a, b, c)
+
+#endif /* HAVE_DTRACE */
+
+#endif /* __GFBGRAPH_TRACE_H__ */
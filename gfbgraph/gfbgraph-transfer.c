@@ -0,0 +1,744 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The HTTP layer shared by all the requests: one RestProxy for the Graph API
+ * calls and one SoupSession for the photo downloads, so the connections are
+ * reused and the responses are compressed on the wire. A session feature
+ * attached to both accounts the transferred bytes and fills the record of
+ * the request in progress, see gfbgraph-request.c. It also arms a watchdog
+ * on the messages of the requests with a deadline, which aborts them when
+ * the deadline passes, whatever phase they are in. Attaching it raises the
+ * connection limits of the sessions, as every thread of the library goes
+ * through them. */
+
+#include <libsoup/soup.h>
+#include <libsoup/soup-requester.h>
+
+#include "gfbgraph-private.h"
+#include "gfbgraph-trace.h"
+
+#define FACEBOOK_ENDPOINT "https://graph.facebook.com/v2.3"
+
+/* The libsoup default is 2 per host. Room for the 8 executor threads and the
+ * 4 crawler workers by default, plus the synchronous callers. */
+#define TRANSFER_MAX_CONNS_PER_HOST 16
+#define TRANSFER_MAX_CONNS 32
+
+#define GFBGRAPH_TYPE_TRANSFER_FEATURE (gfbgraph_transfer_feature_get_type ())
+
+typedef struct {
+        GObject parent;
+} GFBGraphTransferFeature;
+
+typedef struct {
+        GObjectClass parent_class;
+} GFBGraphTransferFeatureClass;
+
+static GType gfbgraph_transfer_feature_get_type (void);
+static void  gfbgraph_transfer_feature_session_feature_init (SoupSessionFeatureInterface *iface);
+static void  gfbgraph_transfer_feature_attach (SoupSessionFeature *feature, SoupSession *session);
+static void  gfbgraph_transfer_feature_request_queued (SoupSessionFeature *feature, SoupSession *session, SoupMessage *message);
+static void  gfbgraph_transfer_network_event_cb (SoupMessage *message, GSocketClientEvent event, GIOStream *connection, gpointer user_data);
+static void  gfbgraph_transfer_wrote_body_cb (SoupMessage *message, gpointer user_data);
+static void  gfbgraph_transfer_got_headers_cb (SoupMessage *message, gpointer user_data);
+static void  gfbgraph_transfer_got_body_cb (SoupMessage *message, gpointer user_data);
+#if GFBGRAPH_TRACE_ENABLED
+static void  gfbgraph_transfer_got_chunk_cb (SoupMessage *message, SoupBuffer *chunk, gpointer user_data);
+#endif
+
+G_DEFINE_TYPE_WITH_CODE (GFBGraphTransferFeature, gfbgraph_transfer_feature, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (SOUP_TYPE_SESSION_FEATURE, gfbgraph_transfer_feature_session_feature_init));
+
+#define NEW_CONNECTION_KEY "gfbgraph-new-connection"
+
+/* A message being watched. It is shared by the timeout source and the
+ * "finished" handler of the message, whichever runs first disarms the other.
+ * The handler holds a reference, dropped when it is disconnected, which breaks
+ * the cycle with the message. */
+typedef struct {
+        volatile gint ref_count;
+        SoupSession *session;
+        SoupMessage *message;
+        GSource *source;
+        gboolean done;
+        gboolean connected;
+} GFBGraphTransferWatch;
+
+G_LOCK_DEFINE_STATIC (watch);
+
+static void (*parent_attach) (SoupSessionFeature *feature, SoupSession *session) = NULL;
+
+static void
+gfbgraph_transfer_feature_init (GFBGraphTransferFeature *feature)
+{
+}
+
+static void
+gfbgraph_transfer_feature_class_init (GFBGraphTransferFeatureClass *klass)
+{
+}
+
+static void
+gfbgraph_transfer_feature_session_feature_init (SoupSessionFeatureInterface *iface)
+{
+        /* The default one connects the request signals of the session */
+        parent_attach = iface->attach;
+
+        iface->attach = gfbgraph_transfer_feature_attach;
+        iface->request_queued = gfbgraph_transfer_feature_request_queued;
+}
+
+static void
+gfbgraph_transfer_feature_attach (SoupSessionFeature *feature, SoupSession *session)
+{
+        g_object_set (session,
+                      SOUP_SESSION_MAX_CONNS_PER_HOST, TRANSFER_MAX_CONNS_PER_HOST,
+                      SOUP_SESSION_MAX_CONNS, TRANSFER_MAX_CONNS,
+                      NULL);
+
+        if (parent_attach != NULL)
+                parent_attach (feature, session);
+}
+
+static GFBGraphTransferWatch*
+gfbgraph_transfer_watch_ref (GFBGraphTransferWatch *watch)
+{
+        g_atomic_int_inc (&watch->ref_count);
+
+        return watch;
+}
+
+static void
+gfbgraph_transfer_watch_unref (GFBGraphTransferWatch *watch)
+{
+        if (!g_atomic_int_dec_and_test (&watch->ref_count))
+                return;
+
+        g_source_unref (watch->source);
+        g_object_unref (watch->message);
+        g_object_unref (watch->session);
+
+        g_slice_free (GFBGraphTransferWatch, watch);
+}
+
+static gpointer
+gfbgraph_transfer_watchdog_thread (gpointer data)
+{
+        GMainContext *context = data;
+
+        while (TRUE)
+                g_main_context_iteration (context, TRUE);
+
+        return NULL;
+}
+
+/* The context where the watchdog waits for the deadlines. The requests are
+ * synchronous, so their own threads can't do it. */
+static GMainContext*
+gfbgraph_transfer_get_watchdog_context (void)
+{
+        static gsize context = 0;
+
+        if (g_once_init_enter (&context)) {
+                GMainContext *new_context;
+
+                new_context = g_main_context_new ();
+                g_thread_unref (g_thread_new ("gfbgraph-watchdog", gfbgraph_transfer_watchdog_thread, new_context));
+
+                g_once_init_leave (&context, (gsize) new_context);
+        }
+
+        return (GMainContext *) context;
+}
+
+/* Disconnects the "finished" handler of @watch, if still connected, and drops its reference */
+static void
+gfbgraph_transfer_watch_disconnect (GFBGraphTransferWatch *watch)
+{
+        gboolean connected;
+
+        G_LOCK (watch);
+        connected = watch->connected;
+        watch->connected = FALSE;
+        G_UNLOCK (watch);
+
+        if (!connected)
+                return;
+
+        g_signal_handlers_disconnect_by_data (watch->message, watch);
+        gfbgraph_transfer_watch_unref (watch);
+}
+
+static gboolean
+gfbgraph_transfer_watch_expired_cb (gpointer user_data)
+{
+        GFBGraphTransferWatch *watch = user_data;
+        gboolean cancel;
+
+        G_LOCK (watch);
+        cancel = !watch->done;
+        watch->done = TRUE;
+        G_UNLOCK (watch);
+
+        /* The source keeps its own reference until this returns */
+        gfbgraph_transfer_watch_disconnect (watch);
+
+        /* A sync session allows cancelling from another thread. The caller
+         * turns the cancellation into a timeout, see gfbgraph_transfer_call_sync(). */
+        if (cancel) {
+                GFBGRAPH_TRACE1 (request__timeout, soup_message_get_uri (watch->message)->path);
+                soup_session_cancel_message (watch->session, watch->message, SOUP_STATUS_CANCELLED);
+        }
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+gfbgraph_transfer_watch_finished_cb (SoupMessage *message, gpointer user_data)
+{
+        GFBGraphTransferWatch *watch = user_data;
+
+        G_LOCK (watch);
+        if (!watch->done) {
+                watch->done = TRUE;
+                g_source_destroy (watch->source);
+        }
+        G_UNLOCK (watch);
+
+        gfbgraph_transfer_watch_disconnect (watch);
+}
+
+/* Aborts @message if it isn't finished by @deadline */
+static void
+gfbgraph_transfer_watch_message (SoupSession *session, SoupMessage *message, gint64 deadline)
+{
+        GFBGraphTransferWatch *watch;
+        gint64 timeout;
+
+        timeout = MAX (deadline - g_get_monotonic_time (), 0);
+
+        watch = g_slice_new0 (GFBGraphTransferWatch);
+        watch->ref_count = 1;
+        watch->session = g_object_ref (session);
+        watch->message = g_object_ref (message);
+        watch->source = g_timeout_source_new ((timeout + G_TIME_SPAN_MILLISECOND - 1) / G_TIME_SPAN_MILLISECOND);
+
+        watch->connected = TRUE;
+        g_signal_connect (message, "finished", G_CALLBACK (gfbgraph_transfer_watch_finished_cb),
+                          gfbgraph_transfer_watch_ref (watch));
+
+        g_source_set_callback (watch->source, gfbgraph_transfer_watch_expired_cb,
+                               watch, (GDestroyNotify) gfbgraph_transfer_watch_unref);
+        g_source_attach (watch->source, gfbgraph_transfer_get_watchdog_context ());
+}
+
+static void
+gfbgraph_transfer_feature_request_queued (SoupSessionFeature *feature, SoupSession *session, SoupMessage *message)
+{
+        GFBGraphRequestRecord *record;
+
+        /* Queued from the thread doing the request, so its record is the current one */
+        record = gfbgraph_request_record_get_current ();
+        if (record != NULL && record->deadline > 0)
+                gfbgraph_transfer_watch_message (session, message, record->deadline);
+
+        g_signal_connect (message, "network-event", G_CALLBACK (gfbgraph_transfer_network_event_cb), NULL);
+        g_signal_connect (message, "wrote-body", G_CALLBACK (gfbgraph_transfer_wrote_body_cb), NULL);
+        g_signal_connect (message, "got-headers", G_CALLBACK (gfbgraph_transfer_got_headers_cb), NULL);
+        g_signal_connect (message, "got-body", G_CALLBACK (gfbgraph_transfer_got_body_cb), NULL);
+#if GFBGRAPH_TRACE_ENABLED
+        g_signal_connect (message, "got-chunk", G_CALLBACK (gfbgraph_transfer_got_chunk_cb), NULL);
+#endif
+}
+
+#if GFBGRAPH_TRACE_ENABLED
+static void
+gfbgraph_transfer_got_chunk_cb (SoupMessage *message, SoupBuffer *chunk, gpointer user_data)
+{
+        GFBGRAPH_TRACE1 (response__chunk, chunk->length);
+}
+#endif
+
+static void
+gfbgraph_transfer_network_event_cb (SoupMessage *message, GSocketClientEvent event, GIOStream *connection, gpointer user_data)
+{
+        GFBGraphRequestRecord *record;
+
+        if (event == G_SOCKET_CLIENT_COMPLETE) {
+                gfbgraph_counter_add (GFBGRAPH_COUNTER_CONNECTIONS_OPENED, 1);
+                g_object_set_data (G_OBJECT (message), NEW_CONNECTION_KEY, GINT_TO_POINTER (TRUE));
+        }
+
+        record = gfbgraph_request_record_get_current ();
+        if (record == NULL)
+                return;
+
+        switch (event) {
+        case G_SOCKET_CLIENT_RESOLVED:
+                record->resolved_time = g_get_monotonic_time ();
+                break;
+        case G_SOCKET_CLIENT_CONNECTED:
+                record->connected_time = g_get_monotonic_time ();
+                break;
+        case G_SOCKET_CLIENT_TLS_HANDSHAKED:
+                record->tls_time = g_get_monotonic_time ();
+                break;
+        default:
+                break;
+        }
+}
+
+static void
+gfbgraph_transfer_wrote_body_cb (SoupMessage *message, gpointer user_data)
+{
+        GFBGraphRequestRecord *record;
+
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_BYTES_SENT, message->request_body->length);
+
+        record = gfbgraph_request_record_get_current ();
+        if (record == NULL)
+                return;
+
+        record->request_sent_time = g_get_monotonic_time ();
+        record->bytes_sent = message->request_body->length;
+}
+
+static void
+gfbgraph_transfer_got_headers_cb (SoupMessage *message, gpointer user_data)
+{
+        GFBGraphRequestRecord *record;
+
+        if (g_object_get_data (G_OBJECT (message), NEW_CONNECTION_KEY) == NULL)
+                gfbgraph_counter_add (GFBGRAPH_COUNTER_CONNECTIONS_REUSED, 1);
+
+        record = gfbgraph_request_record_get_current ();
+        if (record == NULL)
+                return;
+
+        record->response_headers_time = g_get_monotonic_time ();
+        record->status_code = message->status_code;
+}
+
+static void
+gfbgraph_transfer_got_body_cb (SoupMessage *message, gpointer user_data)
+{
+        GFBGraphRequestRecord *record;
+        goffset wire_bytes = -1;
+        goffset decoded_bytes;
+
+        if (soup_message_headers_get_encoding (message->response_headers) == SOUP_ENCODING_CONTENT_LENGTH)
+                wire_bytes = soup_message_headers_get_content_length (message->response_headers);
+
+        /* Streamed requests, like the photo downloads, don't keep the body */
+        decoded_bytes = message->response_body->length;
+
+        if (soup_message_headers_get_one (message->response_headers, "Content-Encoding") == NULL) {
+                if (decoded_bytes == 0)
+                        decoded_bytes = wire_bytes;
+                else
+                        wire_bytes = decoded_bytes;
+        }
+
+        /* Without the size on the wire, the decoded one is the best guess */
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_BYTES_RECEIVED, wire_bytes > 0 ? wire_bytes : MAX (decoded_bytes, 0));
+
+        record = gfbgraph_request_record_get_current ();
+        if (record != NULL) {
+                record->response_body_time = g_get_monotonic_time ();
+                record->status_code = message->status_code;
+                if (wire_bytes > 0)
+                        record->bytes_received = wire_bytes;
+        }
+
+        /* A chunked compressed response doesn't tell its size on the wire */
+        if (wire_bytes <= 0 || decoded_bytes <= 0)
+                return;
+
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_WIRE_BYTES, wire_bytes);
+        gfbgraph_counter_add (GFBGRAPH_COUNTER_DECODED_BYTES, decoded_bytes);
+}
+
+static SoupSessionFeature*
+gfbgraph_transfer_get_feature (void)
+{
+        static gsize feature = 0;
+
+        if (g_once_init_enter (&feature))
+                g_once_init_leave (&feature, (gsize) g_object_new (GFBGRAPH_TYPE_TRANSFER_FEATURE, NULL));
+
+        return SOUP_SESSION_FEATURE (feature);
+}
+
+/* Replaced only by the tests, before the first request */
+static gchar *transfer_endpoint = NULL;
+
+/* Points the library to another Graph API endpoint, like a local server in the
+ * tests. It must be called before the first request, as the proxy keeps it. */
+void
+gfbgraph_transfer_set_endpoint (const gchar *endpoint)
+{
+        g_free (transfer_endpoint);
+        transfer_endpoint = g_strdup (endpoint);
+}
+
+static const gchar*
+gfbgraph_transfer_get_endpoint (void)
+{
+        return transfer_endpoint != NULL ? transfer_endpoint : FACEBOOK_ENDPOINT;
+}
+
+/* Returns the RestProxy shared by all the Graph API calls. Its sessions decode
+ * gzip and deflate responses, and advertise it with Accept-Encoding. */
+RestProxy*
+gfbgraph_transfer_get_proxy (void)
+{
+        static gsize proxy = 0;
+
+        if (g_once_init_enter (&proxy)) {
+                RestProxy *new_proxy;
+                SoupSessionFeature *decoder;
+
+                new_proxy = rest_proxy_new (gfbgraph_transfer_get_endpoint (), FALSE);
+
+                decoder = SOUP_SESSION_FEATURE (g_object_new (SOUP_TYPE_CONTENT_DECODER, NULL));
+                rest_proxy_add_soup_feature (new_proxy, decoder);
+                g_object_unref (decoder);
+
+                rest_proxy_add_soup_feature (new_proxy, gfbgraph_transfer_get_feature ());
+
+                g_once_init_leave (&proxy, (gsize) new_proxy);
+        }
+
+        return (RestProxy *) proxy;
+}
+
+static SoupSession*
+gfbgraph_transfer_get_download_session (void)
+{
+        static gsize session = 0;
+
+        if (g_once_init_enter (&session)) {
+                SoupSession *new_session;
+                SoupRequester *requester;
+
+                new_session = soup_session_sync_new ();
+                soup_session_add_feature_by_type (new_session, SOUP_TYPE_CONTENT_DECODER);
+                soup_session_add_feature (new_session, gfbgraph_transfer_get_feature ());
+
+                requester = soup_requester_new ();
+                soup_session_add_feature (new_session, SOUP_SESSION_FEATURE (requester));
+                g_object_unref (requester);
+
+                /* Alive for the whole process */
+                g_once_init_leave (&session, (gsize) new_session);
+        }
+
+        return (SoupSession *) session;
+}
+
+static SoupRequester*
+gfbgraph_transfer_get_requester (void)
+{
+        return SOUP_REQUESTER (soup_session_get_feature (gfbgraph_transfer_get_download_session (), SOUP_TYPE_REQUESTER));
+}
+
+/* Runs @call like rest_proxy_call_sync(), within the deadline of the request
+ * in progress. Missing it fails with %G_IO_ERROR_TIMED_OUT. */
+gboolean
+gfbgraph_transfer_call_sync (RestProxyCall *call, GError **error)
+{
+        GFBGraphRequestRecord *record;
+        GError *call_error = NULL;
+
+        g_return_val_if_fail (REST_IS_PROXY_CALL (call), FALSE);
+
+        record = gfbgraph_request_record_get_current ();
+        if (gfbgraph_request_record_check_deadline (record, error))
+                return FALSE;
+
+        if (rest_proxy_call_sync (call, &call_error))
+                return TRUE;
+
+        /* The watchdog aborted it, or it failed anyway too late */
+        if (gfbgraph_request_record_check_deadline (record, error))
+                g_error_free (call_error);
+        else
+                g_propagate_error (error, call_error);
+
+        return FALSE;
+}
+
+/* Starts the download of @uri through the shared download session. The
+ * returned stream gives the decoded content. The request is recorded until
+ * the response headers arrive, the body is read later by the caller.
+ * @status_code, if not %NULL, is set to the HTTP status of the response.
+ * The deadline of the request, if any, covers the reading of the body. */
+GInputStream*
+gfbgraph_transfer_download (GFBGraphAuthorizer *authorizer, const gchar *uri, guint *status_code, GError **error)
+{
+        GFBGraphRequestRecord *record;
+        SoupRequest *request;
+        GInputStream *stream = NULL;
+
+        g_return_val_if_fail (uri != NULL, NULL);
+
+        record = gfbgraph_request_record_begin ("GET", uri);
+        GFBGRAPH_TRACE1 (download__start, uri);
+
+        if (gfbgraph_request_record_check_deadline (record, error))
+                request = NULL;
+        else
+                request = soup_requester_request (gfbgraph_transfer_get_requester (), uri, error);
+
+        if (request != NULL) {
+                GError *send_error = NULL;
+
+                stream = soup_request_send (request, NULL, &send_error);
+                if (stream == NULL) {
+                        if (gfbgraph_request_record_check_deadline (record, error))
+                                g_error_free (send_error);
+                        else
+                                g_propagate_error (error, send_error);
+                }
+
+                g_object_unref (request);
+        }
+
+        GFBGRAPH_TRACE2 (download__end, uri, record->status_code);
+
+        if (status_code != NULL)
+                *status_code = record->status_code;
+
+        gfbgraph_request_record_end (record, authorizer);
+
+        return stream;
+}
+
+/* Opens a connection to the Graph API endpoint. Any response will do, the
+ * connection stays in the pool of the proxy for the next requests. */
+static gboolean
+gfbgraph_transfer_warmup_graph (GError **error)
+{
+        GFBGraphRequestRecord *record;
+        RestProxyCall *rest_call;
+        GError *call_error = NULL;
+        gboolean result;
+
+        rest_call = rest_proxy_new_call (gfbgraph_transfer_get_proxy ());
+        rest_proxy_call_set_method (rest_call, "HEAD");
+
+        record = gfbgraph_request_record_begin ("HEAD", gfbgraph_transfer_get_endpoint ());
+        result = gfbgraph_transfer_call_sync (rest_call, &call_error);
+        if (!result && record->status_code != 0 && !g_error_matches (call_error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT)) {
+                /* An error status, but the connection is open */
+                g_clear_error (&call_error);
+                result = TRUE;
+        }
+        gfbgraph_request_record_end (record, NULL);
+
+        if (call_error != NULL)
+                g_propagate_error (error, call_error);
+
+        g_object_unref (rest_call);
+
+        return result;
+}
+
+/* Opens a connection to the host of @uri in the download session */
+static gboolean
+gfbgraph_transfer_warmup_host (const gchar *uri, GError **error)
+{
+        GFBGraphRequestRecord *record;
+        SoupMessage *message;
+        gboolean result = FALSE;
+
+        message = soup_message_new ("HEAD", uri);
+        if (message == NULL) {
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid URI: %s", uri);
+                return FALSE;
+        }
+
+        record = gfbgraph_request_record_begin ("HEAD", uri);
+        if (!gfbgraph_request_record_check_deadline (record, error)) {
+                guint status_code;
+
+                status_code = soup_session_send_message (gfbgraph_transfer_get_download_session (), message);
+                if (gfbgraph_request_record_check_deadline (record, error))
+                        result = FALSE;
+                else if (SOUP_STATUS_IS_TRANSPORT_ERROR (status_code))
+                        g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Cannot connect to %s: %s",
+                                     soup_uri_get_host (soup_message_get_uri (message)), message->reason_phrase);
+                else
+                        result = TRUE;
+        }
+        gfbgraph_request_record_end (record, NULL);
+
+        g_object_unref (message);
+
+        return result;
+}
+
+/**
+ * gfbgraph_warmup:
+ * @uris: (array zero-terminated=1) (allow-none): the URIs of some photos, or %NULL.
+ * @cancellable: (allow-none): An optional #GCancellable object, or %NULL.
+ * @error: (allow-none): a #GError or %NULL.
+ *
+ * Resolves the Graph API host and opens a connection to it, so the first request of
+ * the application doesn't pay for the DNS lookup, the TCP connection and the TLS
+ * handshake. The same is done for the hosts of @uris, one connection per host, which
+ * should be the URIs of photos likely to be downloaded soon, like the ones of the
+ * cached photos, so their first download is also faster.
+ *
+ * The connections are kept open for the next requests, as long as the servers allow.
+ * The requests have the priority and the deadline of the calling thread. See
+ * gfbgraph_warmup_async() for the asynchronous version of this call, which takes
+ * the warmup off the startup of the application.
+ *
+ * Returns: %TRUE if every host could be reached, %FALSE otherwise. The hosts
+ * following an unreachable one are warmed anyway.
+ **/
+gboolean
+gfbgraph_warmup (const gchar * const *uris, GCancellable *cancellable, GError **error)
+{
+        GHashTable *hosts;
+        GError *warmup_error = NULL;
+        guint i;
+
+        g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+
+        if (g_cancellable_set_error_if_cancelled (cancellable, error))
+                return FALSE;
+
+        gfbgraph_transfer_warmup_graph (&warmup_error);
+
+        hosts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        for (i = 0; uris != NULL && uris[i] != NULL; i++) {
+                SoupURI *uri;
+                gchar *host;
+
+                if (g_cancellable_is_cancelled (cancellable))
+                        break;
+
+                uri = soup_uri_new (uris[i]);
+                if (uri == NULL || soup_uri_get_host (uri) == NULL) {
+                        if (uri != NULL)
+                                soup_uri_free (uri);
+                        if (warmup_error == NULL)
+                                g_set_error (&warmup_error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid URI: %s", uris[i]);
+                        continue;
+                }
+
+                /* One connection per host is enough */
+                host = g_strdup_printf ("%s://%s:%u", soup_uri_get_scheme (uri), soup_uri_get_host (uri), soup_uri_get_port (uri));
+                soup_uri_free (uri);
+                if (!g_hash_table_add (hosts, host))
+                        continue;
+
+                gfbgraph_transfer_warmup_host (uris[i], warmup_error == NULL ? &warmup_error : NULL);
+        }
+        g_hash_table_unref (hosts);
+
+        if (warmup_error == NULL && g_cancellable_set_error_if_cancelled (cancellable, error))
+                return FALSE;
+
+        if (warmup_error != NULL) {
+                g_propagate_error (error, warmup_error);
+                return FALSE;
+        }
+
+        return TRUE;
+}
+
+static void
+gfbgraph_warmup_async_thread (GSimpleAsyncResult *simple_async, GObject *source_object, GCancellable *cancellable)
+{
+        const gchar * const *uris;
+        GError *error = NULL;
+
+        uris = g_simple_async_result_get_op_res_gpointer (simple_async);
+        if (!gfbgraph_warmup (uris, cancellable, &error))
+                g_simple_async_result_take_error (simple_async, error);
+}
+
+/**
+ * gfbgraph_warmup_async:
+ * @uris: (array zero-terminated=1) (allow-none): the URIs of some photos, or %NULL.
+ * @cancellable: (allow-none): An optional #GCancellable object, or %NULL.
+ * @callback: (scope async): A #GAsyncReadyCallback to call when the warmup is done.
+ * @user_data: (closure): The data to pass to @callback.
+ *
+ * Asynchronously opens the connections to the Graph API host and to the hosts of
+ * @uris. See gfbgraph_warmup() for the synchronous version of this call.
+ *
+ * When the operation is finished, @callback will be called. You can then call
+ * gfbgraph_warmup_async_finish() to know if every host could be reached.
+ **/
+void
+gfbgraph_warmup_async (const gchar * const *uris, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+        GSimpleAsyncResult *simple_async;
+
+        g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+        simple_async = g_simple_async_result_new (NULL, callback, user_data, gfbgraph_warmup_async);
+        g_simple_async_result_set_check_cancellable (simple_async, cancellable);
+
+        g_simple_async_result_set_op_res_gpointer (simple_async, g_strdupv ((gchar **) uris), (GDestroyNotify) g_strfreev);
+        gfbgraph_simple_async_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_warmup_async_thread, cancellable);
+
+        g_object_unref (simple_async);
+}
+
+/**
+ * gfbgraph_warmup_async_finish:
+ * @result: A #GAsyncResult.
+ * @error: (allow-none): An optional #GError, or %NULL.
+ *
+ * Finishes an asynchronous operation started with gfbgraph_warmup_async().
+ *
+ * Returns: %TRUE if every host could be reached, %FALSE otherwise.
+ **/
+gboolean
+gfbgraph_warmup_async_finish (GAsyncResult *result, GError **error)
+{
+        g_return_val_if_fail (g_simple_async_result_is_valid (result, NULL, gfbgraph_warmup_async), FALSE);
+        g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+        return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error);
+}
+
+/**
+ * gfbgraph_get_transfer_stats:
+ * @wire_bytes: (out) (allow-none): return location for the bytes received on the wire, or %NULL.
+ * @decoded_bytes: (out) (allow-none): return location for the bytes once decoded, or %NULL.
+ *
+ * Gets how many response bytes the library has received since the process started,
+ * before and after decompressing them, so the difference is what compression saved.
+ * Only the responses whose size on the wire is known are counted, which excludes
+ * the compressed responses sent in chunks.
+ **/
+void
+gfbgraph_get_transfer_stats (guint64 *wire_bytes, guint64 *decoded_bytes)
+{
+        if (wire_bytes != NULL)
+                *wire_bytes = gfbgraph_counter_get (GFBGRAPH_COUNTER_WIRE_BYTES);
+        if (decoded_bytes != NULL)
+                *decoded_bytes = gfbgraph_counter_get (GFBGRAPH_COUNTER_DECODED_BYTES);
+}
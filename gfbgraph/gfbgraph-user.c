@@ -32,6 +32,7 @@
 #include "gfbgraph-user.h"
 #include "gfbgraph-album.h"
 #include "gfbgraph-common.h"
+#include "gfbgraph-private.h"
 
 #define ME_FUNCTION "me"
 
@@ -62,6 +63,9 @@ static void gfbgraph_user_finalize     (GObject *obj);
 static void gfbgraph_user_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec);
 static void gfbgraph_user_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
 
+static gboolean gfbgraph_user_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node);
+static void     gfbgraph_user_serialize_members  (GFBGraphNode *node, JsonBuilder *builder);
+
 /* Private functions */
 static void gfbgraph_user_async_data_free (GFBGraphUserAsyncData *data);
 static void gfbgraph_user_connection_async_data_free (GFBGraphUserConnectionAsyncData *data);
@@ -84,12 +88,16 @@ static void
 gfbgraph_user_class_init (GFBGraphUserClass *klass)
 {
         GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+        GFBGraphNodeClass *node_class = GFBGRAPH_NODE_CLASS (klass);
 
         parent_class            = g_type_class_peek_parent (klass);
         gobject_class->finalize = gfbgraph_user_finalize;
         gobject_class->set_property = gfbgraph_user_set_property;
         gobject_class->get_property = gfbgraph_user_get_property;
 
+        node_class->deserialize_member = gfbgraph_user_deserialize_member;
+        node_class->serialize_members = gfbgraph_user_serialize_members;
+
         g_type_class_add_private (gobject_class, sizeof(GFBGraphUserPrivate));
 
         /**
@@ -120,6 +128,13 @@ gfbgraph_user_class_init (GFBGraphUserClass *klass)
 static void
 gfbgraph_user_finalize (GObject *obj)
 {
+        GFBGraphUserPrivate *priv;
+
+        priv = GFBGRAPH_USER_GET_PRIVATE (obj);
+
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->name);
+        gfbgraph_node_free_string (GFBGRAPH_NODE (obj), priv->email);
+
         G_OBJECT_CLASS(parent_class)->finalize (obj);
 }
 
@@ -130,16 +145,18 @@ gfbgraph_user_set_property (GObject *object, guint prop_id, const GValue *value,
 
         priv = GFBGRAPH_USER_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+        if (!gfbgraph_node_check_writable (GFBGRAPH_NODE (object)))
+                return;
+
         switch (prop_id) {
                 case PROP_NAME:
-                        if (priv->name)
-                                g_free (priv->name);
-                        priv->name = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->name);
+                        priv->name = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 case PROP_EMAIL:
-                        if (priv->email)
-                                g_free (priv->email);
-                        priv->email = g_strdup (g_value_get_string (value));
+                        gfbgraph_node_free_string (GFBGRAPH_NODE (object), priv->email);
+                        priv->email = gfbgraph_node_dup_string (GFBGRAPH_NODE (object), g_value_get_string (value));
                         break;
                 default:
                         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -154,6 +171,8 @@ gfbgraph_user_get_property (GObject *object, guint prop_id, GValue *value, GPara
 
         priv = GFBGRAPH_USER_GET_PRIVATE (object);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (object));
+
         switch (prop_id) {
                 case PROP_NAME:
                         g_value_set_string (value, priv->name);
@@ -167,6 +186,34 @@ gfbgraph_user_get_property (GObject *object, guint prop_id, GValue *value, GPara
         }
 }
 
+static gboolean
+gfbgraph_user_deserialize_member (GFBGraphNode *node, const gchar *member_name, JsonNode *member_node)
+{
+        GFBGraphUserPrivate *priv;
+
+        priv = GFBGRAPH_USER (node)->priv;
+
+        if (g_strcmp0 (member_name, "name") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->name);
+        else if (g_strcmp0 (member_name, "email") == 0)
+                return gfbgraph_node_deserialize_string (node, member_node, &priv->email);
+
+        return parent_class->deserialize_member (node, member_name, member_node);
+}
+
+static void
+gfbgraph_user_serialize_members (GFBGraphNode *node, JsonBuilder *builder)
+{
+        GFBGraphUserPrivate *priv;
+
+        priv = GFBGRAPH_USER (node)->priv;
+
+        parent_class->serialize_members (node, builder);
+
+        gfbgraph_node_serialize_string (builder, "name", priv->name);
+        gfbgraph_node_serialize_string (builder, "email", priv->email);
+}
+
 static void
 gfbgraph_user_async_data_free (GFBGraphUserAsyncData *data)
 {
@@ -253,35 +300,9 @@ gfbgraph_user_new_from_id (GFBGraphAuthorizer *authorizer, const gchar *id, GErr
 GFBGraphUser*
 gfbgraph_user_get_me (GFBGraphAuthorizer *authorizer, GError **error)
 {
-        GFBGraphUser *me;
-        RestProxyCall *rest_call;
-        const gchar *payload;
-        gboolean result;
-
         g_return_val_if_fail (GFBGRAPH_IS_AUTHORIZER (authorizer), NULL);
 
-        me = NULL;
-
-        rest_call = gfbgraph_new_rest_call (authorizer);
-        rest_proxy_call_set_function (rest_call, ME_FUNCTION);
-        rest_proxy_call_set_method (rest_call, "GET");
-
-        result = rest_proxy_call_sync (rest_call, error);
-        if (result) {
-                JsonParser *parser;
-                JsonNode *node;
-
-                payload = rest_proxy_call_get_payload (rest_call);
-                parser = json_parser_new ();
-                if (json_parser_load_from_data (parser, payload, -1, error)) {
-                        node = json_parser_get_root (parser);
-                        me = GFBGRAPH_USER (json_gobject_deserialize (GFBGRAPH_TYPE_USER, node));
-                }
-
-                g_object_unref (parser);
-        }
-
-        return me;
+        return GFBGRAPH_USER (gfbgraph_node_new_from_id (authorizer, ME_FUNCTION, GFBGRAPH_TYPE_USER, error));
 }
 
 /**
@@ -314,7 +335,7 @@ gfbgraph_user_get_me_async (GFBGraphAuthorizer *authorizer, GCancellable *cancel
         data->user = NULL;
 
         g_simple_async_result_set_op_res_gpointer (simple_async, data, (GDestroyNotify) gfbgraph_user_async_data_free);
-        g_simple_async_result_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_user_get_me_async_thread, G_PRIORITY_DEFAULT, cancellable);
+        gfbgraph_simple_async_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_user_get_me_async_thread, cancellable);
 
         g_object_unref (simple_async);
 }
@@ -401,7 +422,7 @@ gfbgraph_user_get_albums_async (GFBGraphUser *user, GFBGraphAuthorizer *authoriz
         g_object_ref (data->authorizer);
 
         g_simple_async_result_set_op_res_gpointer (simple_async, data, (GDestroyNotify) gfbgraph_user_connection_async_data_free);
-        g_simple_async_result_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_user_get_albums_async_thread, G_PRIORITY_DEFAULT, cancellable);
+        gfbgraph_simple_async_run_in_thread (simple_async, (GSimpleAsyncThreadFunc) gfbgraph_user_get_albums_async_thread, cancellable);
 
         g_object_unref (simple_async);
 }
@@ -449,6 +470,8 @@ gfbgraph_user_get_name (GFBGraphUser *user)
 {
         g_return_val_if_fail (GFBGRAPH_IS_USER (user), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (user));
+
         return user->priv->name;
 }
 
@@ -466,5 +489,7 @@ gfbgraph_user_get_email (GFBGraphUser *user)
 {
         g_return_val_if_fail (GFBGRAPH_IS_USER (user), NULL);
 
+        gfbgraph_node_materialize (GFBGRAPH_NODE (user));
+
         return user->priv->email;
 }
@@ -21,9 +21,17 @@
 #define __GFBGRAPH_H__
 
 #include <gfbgraph/gfbgraph-album.h>
+#include <gfbgraph/gfbgraph-common.h>
 #include <gfbgraph/gfbgraph-connectable.h>
+#include <gfbgraph/gfbgraph-crawler.h>
+#include <gfbgraph/gfbgraph-expansion.h>
 #include <gfbgraph/gfbgraph-node.h>
+#include <gfbgraph/gfbgraph-pager.h>
 #include <gfbgraph/gfbgraph-photo.h>
+#include <gfbgraph/gfbgraph-request.h>
+#include <gfbgraph/gfbgraph-snapshot.h>
+#include <gfbgraph/gfbgraph-store.h>
+#include <gfbgraph/gfbgraph-sync.h>
 #include <gfbgraph/gfbgraph-user.h>
 
 #endif /* __GFBGRAPH_H__ */
@@ -0,0 +1,145 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the string arena shared by the nodes of a page */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+#define PHOTOS_PAGE "{\"data\": [" \
+        "{\"id\": \"p1\", \"name\": \"First\", \"link\": \"https://www.facebook.com/photo.php?fbid=p1\"}," \
+        "{\"id\": \"p2\", \"name\": \"Second\", \"link\": \"https://www.facebook.com/photo.php?fbid=p2\"}]}"
+
+static void
+gfbgraph_test_arena_strdup (void)
+{
+        GFBGraphArena *arena;
+        GPtrArray *copies;
+        gchar *big;
+        gchar *copy;
+        gchar *outside;
+        guint i;
+
+        arena = gfbgraph_arena_new ();
+
+        g_assert (gfbgraph_arena_strdup (arena, NULL) == NULL);
+
+        /* Enough strings to fill several blocks */
+        copies = g_ptr_array_new ();
+        for (i = 0; i < 5000; i++) {
+                gchar *str;
+
+                str = g_strdup_printf ("string number %u", i);
+                copy = gfbgraph_arena_strdup (arena, str);
+                g_assert (copy != str);
+                g_assert_cmpstr (copy, ==, str);
+                g_ptr_array_add (copies, copy);
+                g_free (str);
+        }
+
+        /* A big string gets its own block */
+        big = g_strnfill (10000, 'x');
+        copy = gfbgraph_arena_strdup (arena, big);
+        g_assert_cmpstr (copy, ==, big);
+        g_assert (gfbgraph_arena_contains (arena, copy));
+        g_free (big);
+
+        /* Nothing was overwritten by the later copies */
+        for (i = 0; i < copies->len; i++) {
+                gchar *str;
+
+                str = g_strdup_printf ("string number %u", i);
+                g_assert_cmpstr (g_ptr_array_index (copies, i), ==, str);
+                g_assert (gfbgraph_arena_contains (arena, g_ptr_array_index (copies, i)));
+                g_free (str);
+        }
+        g_ptr_array_unref (copies);
+
+        outside = g_strdup ("outside");
+        g_assert (!gfbgraph_arena_contains (arena, outside));
+        g_free (outside);
+
+        gfbgraph_arena_unref (arena);
+}
+
+static GPtrArray*
+gfbgraph_test_parse_page (void)
+{
+        GPtrArray *nodes;
+        GError *error = NULL;
+
+        nodes = gfbgraph_connectable_type_parse_connected_data_array (GFBGRAPH_TYPE_PHOTO, PHOTOS_PAGE, NULL, NULL, &error);
+        g_assert_no_error (error);
+        g_assert (nodes != NULL);
+        g_assert_cmpuint (nodes->len, ==, 2);
+
+        return nodes;
+}
+
+static void
+gfbgraph_test_arena_page (gconstpointer user_data)
+{
+        GFBGraphPhoto *first;
+        GFBGraphPhoto *second;
+        GPtrArray *nodes;
+
+        gfbgraph_set_string_pooling (GPOINTER_TO_INT (user_data));
+
+        nodes = gfbgraph_test_parse_page ();
+        first = g_object_ref (g_ptr_array_index (nodes, 0));
+        second = g_object_ref (g_ptr_array_index (nodes, 1));
+        g_ptr_array_unref (nodes);
+
+        g_assert_cmpstr (gfbgraph_photo_get_name (first), ==, "First");
+        g_assert_cmpstr (gfbgraph_photo_get_name (second), ==, "Second");
+
+        /* Replacing a string of the page doesn't free it */
+        g_object_set (first, "name", "Renamed", NULL);
+        g_assert_cmpstr (gfbgraph_photo_get_name (first), ==, "Renamed");
+
+        /* Nor does replacing a value set later, which is a copy too */
+        g_object_set (first, "name", "Renamed again", "source", "http://example.com/p1.jpg", NULL);
+        g_object_set (first, "source", NULL, NULL);
+        g_assert_cmpstr (gfbgraph_photo_get_name (first), ==, "Renamed again");
+        g_assert (gfbgraph_photo_get_default_source_uri (first) == NULL);
+
+        /* The strings of the page outlive any of its nodes */
+        g_object_unref (first);
+        g_assert_cmpstr (gfbgraph_photo_get_name (second), ==, "Second");
+        g_assert_cmpstr (gfbgraph_node_get_link (GFBGRAPH_NODE (second)), ==, "https://www.facebook.com/photo.php?fbid=p2");
+        g_object_unref (second);
+
+        gfbgraph_set_string_pooling (TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Arena/Strdup", gfbgraph_test_arena_strdup);
+        g_test_add_data_func ("/GFBGraph/Arena/Page", GINT_TO_POINTER (TRUE), gfbgraph_test_arena_page);
+        g_test_add_data_func ("/GFBGraph/Arena/PageWithoutPooling", GINT_TO_POINTER (FALSE), gfbgraph_test_arena_page);
+
+        return g_test_run ();
+}
@@ -0,0 +1,90 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the connections between the node types */
+
+#include <glib.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+/* The connections are resolved from the types, without instantiating any node */
+static void
+gfbgraph_test_connectable_types (void)
+{
+        GFBGraphPhoto *photo;
+        guint photos;
+        guint albums;
+
+        photos = gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO);
+        albums = gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_ALBUM);
+
+        g_assert (gfbgraph_connectable_type_is_connectable_to (GFBGRAPH_TYPE_PHOTO, GFBGRAPH_TYPE_ALBUM));
+        g_assert (!gfbgraph_connectable_type_is_connectable_to (GFBGRAPH_TYPE_PHOTO, GFBGRAPH_TYPE_USER));
+        g_assert_cmpstr (gfbgraph_connectable_type_get_connection_path (GFBGRAPH_TYPE_PHOTO, GFBGRAPH_TYPE_ALBUM), ==, "photos");
+
+        g_assert (gfbgraph_connectable_type_is_connectable_to (GFBGRAPH_TYPE_ALBUM, GFBGRAPH_TYPE_USER));
+        g_assert (!gfbgraph_connectable_type_is_connectable_to (GFBGRAPH_TYPE_ALBUM, GFBGRAPH_TYPE_ALBUM));
+        g_assert_cmpstr (gfbgraph_connectable_type_get_connection_path (GFBGRAPH_TYPE_ALBUM, GFBGRAPH_TYPE_USER), ==, "albums");
+
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO), ==, photos);
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_ALBUM), ==, albums);
+
+        /* The same answers through an instance */
+        photo = gfbgraph_photo_new ();
+        g_assert (gfbgraph_connectable_is_connectable_to (GFBGRAPH_CONNECTABLE (photo), GFBGRAPH_TYPE_ALBUM));
+        g_assert (!gfbgraph_connectable_is_connectable_to (GFBGRAPH_CONNECTABLE (photo), GFBGRAPH_TYPE_USER));
+        g_assert_cmpstr (gfbgraph_connectable_get_connection_path (GFBGRAPH_CONNECTABLE (photo), GFBGRAPH_TYPE_ALBUM), ==, "photos");
+        g_object_unref (photo);
+}
+
+/* Only the connected nodes are created to parse a response */
+static void
+gfbgraph_test_connectable_parse (void)
+{
+        const gchar *payload = "{\"data\": [{\"id\": \"1\"}, {\"id\": \"2\"}]}";
+        GPtrArray *nodes;
+        GError *error = NULL;
+        guint photos;
+
+        photos = gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO);
+
+        nodes = gfbgraph_connectable_type_parse_connected_data_array (GFBGRAPH_TYPE_PHOTO, payload, NULL, NULL, &error);
+        g_assert_no_error (error);
+        g_assert (nodes != NULL);
+        g_assert_cmpuint (nodes->len, ==, 2);
+        g_assert_cmpstr (gfbgraph_node_get_id (g_ptr_array_index (nodes, 0)), ==, "1");
+        g_assert_cmpstr (gfbgraph_node_get_id (g_ptr_array_index (nodes, 1)), ==, "2");
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO), ==, photos + 2);
+
+        g_ptr_array_unref (nodes);
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO), ==, photos);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Connectable/Types", gfbgraph_test_connectable_types);
+        g_test_add_func ("/GFBGraph/Connectable/Parse", gfbgraph_test_connectable_parse);
+
+        return g_test_run ();
+}
@@ -0,0 +1,209 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the crawler checkpoints, against canned Graph API responses */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+#define PHOTOS_PATH "/1/photos"
+#define NEXT_PAGE_URL "https://graph.facebook.com/v2.3/1/photos?page="
+
+#define GRAPH_ERROR "{\"error\": {\"message\": \"Internal error\", \"type\": \"OAuthException\", \"code\": 2}}"
+
+typedef struct {
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphAlbum *album;
+        GString *ids;
+} GFBGraphTestFixture;
+
+static GFBGraphTestServer *server = NULL;
+
+static void
+gfbgraph_test_fixture_setup (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        fixture->authorizer = gfbgraph_simple_authorizer_new ("token");
+        fixture->album = gfbgraph_album_new ();
+        g_object_set (fixture->album, "id", "1", NULL);
+        fixture->ids = g_string_new (NULL);
+}
+
+static void
+gfbgraph_test_fixture_teardown (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        g_string_free (fixture->ids, TRUE);
+        g_object_unref (fixture->album);
+        g_object_unref (fixture->authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+/* Appends the ID of @node to the found ones, separated by commas */
+static void
+gfbgraph_test_crawler_func (GFBGraphCrawler *crawler, GFBGraphNode *parent, GFBGraphNode *node, gpointer user_data)
+{
+        GFBGraphTestFixture *fixture;
+
+        fixture = (GFBGraphTestFixture *) user_data;
+
+        g_assert_cmpstr (gfbgraph_node_get_id (parent), ==, "1");
+
+        if (fixture->ids->len > 0)
+                g_string_append_c (fixture->ids, ',');
+        g_string_append (fixture->ids, gfbgraph_node_get_id (node));
+}
+
+static GFBGraphCrawler*
+gfbgraph_test_crawler_new (GFBGraphTestFixture *fixture)
+{
+        GFBGraphCrawler *crawler;
+
+        crawler = gfbgraph_crawler_new (GFBGRAPH_NODE (fixture->album));
+        gfbgraph_crawler_add_type (crawler, GFBGRAPH_TYPE_PHOTO);
+
+        return crawler;
+}
+
+static gboolean
+gfbgraph_test_crawler_run (GFBGraphTestFixture *fixture, GFBGraphCrawler *crawler, GError **error)
+{
+        return gfbgraph_crawler_run (crawler, GFBGRAPH_AUTHORIZER (fixture->authorizer),
+                                     gfbgraph_test_crawler_func, fixture, NULL, error);
+}
+
+static void
+gfbgraph_test_crawler_checkpoint (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GFBGraphCrawler *crawler;
+        GVariant *checkpoint;
+        GVariant *unit;
+        GVariant *params;
+        GBytes *bytes;
+        GError *error = NULL;
+        const gchar *page;
+
+        gfbgraph_test_server_add (server, PHOTOS_PATH, NULL, SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p1\"}, {\"id\": \"p2\"}],"
+                                  "\"paging\": {\"next\": \"" NEXT_PAGE_URL "2\"}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=2", SOUP_STATUS_INTERNAL_SERVER_ERROR, GRAPH_ERROR);
+
+        /* The second page fails, so it's the pending work */
+        crawler = gfbgraph_test_crawler_new (fixture);
+        g_assert (!gfbgraph_test_crawler_run (fixture, crawler, &error));
+        g_assert (error != NULL);
+        g_clear_error (&error);
+        g_assert_cmpstr (fixture->ids->str, ==, "p1,p2");
+
+        checkpoint = g_variant_ref_sink (gfbgraph_crawler_save_checkpoint (crawler));
+        g_object_unref (crawler);
+
+        g_assert_cmpuint (g_variant_n_children (checkpoint), ==, 1);
+        unit = g_variant_get_child_value (checkpoint, 0);
+        params = g_variant_get_child_value (unit, 3);
+        g_assert (g_variant_lookup (params, "page", "&s", &page));
+        g_assert_cmpstr (page, ==, "2");
+        g_variant_unref (params);
+        g_variant_unref (unit);
+
+        /* As if it was saved to disk in another session */
+        bytes = g_variant_get_data_as_bytes (checkpoint);
+        g_variant_unref (checkpoint);
+        checkpoint = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("a(sssa{ss}u)"), bytes, FALSE));
+        g_bytes_unref (bytes);
+
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=2", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p3\"}]}");
+        g_string_truncate (fixture->ids, 0);
+
+        /* A new crawler continues from the second page, without asking again for the first */
+        crawler = gfbgraph_test_crawler_new (fixture);
+        g_assert (gfbgraph_crawler_load_checkpoint (crawler, checkpoint));
+        g_variant_unref (checkpoint);
+
+        g_assert (gfbgraph_test_crawler_run (fixture, crawler, &error));
+        g_assert_no_error (error);
+        g_assert_cmpstr (fixture->ids->str, ==, "p3");
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 1);
+
+        /* Nothing is pending after a finished crawl */
+        checkpoint = g_variant_ref_sink (gfbgraph_crawler_save_checkpoint (crawler));
+        g_assert_cmpuint (g_variant_n_children (checkpoint), ==, 0);
+        g_variant_unref (checkpoint);
+
+        g_object_unref (crawler);
+}
+
+static void
+gfbgraph_test_crawler_invalid_checkpoint (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GFBGraphCrawler *crawler;
+        GVariant *checkpoint;
+
+        crawler = gfbgraph_test_crawler_new (fixture);
+
+        checkpoint = g_variant_ref_sink (g_variant_new_string ("not a checkpoint"));
+        g_assert (!gfbgraph_crawler_load_checkpoint (crawler, checkpoint));
+        g_variant_unref (checkpoint);
+
+        /* A type which isn't a node */
+        checkpoint = g_variant_ref_sink (g_variant_new_parsed ("[('GObject', '1', 'GFBGraphPhoto', @a{ss} {}, @u 0)]"));
+        g_assert (!gfbgraph_crawler_load_checkpoint (crawler, checkpoint));
+        g_variant_unref (checkpoint);
+
+        /* An unknown type */
+        checkpoint = g_variant_ref_sink (g_variant_new_parsed ("[('GFBGraphAlbum', '1', 'GFBGraphUnknown', @a{ss} {}, @u 0)]"));
+        g_assert (!gfbgraph_crawler_load_checkpoint (crawler, checkpoint));
+        g_variant_unref (checkpoint);
+
+        /* A connection to a node which can't be connected */
+        checkpoint = g_variant_ref_sink (g_variant_new_parsed ("[('GFBGraphPhoto', '1', 'GFBGraphUser', @a{ss} {}, @u 0)]"));
+        g_assert (!gfbgraph_crawler_load_checkpoint (crawler, checkpoint));
+        g_variant_unref (checkpoint);
+
+        g_object_unref (crawler);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add ("/GFBGraph/Crawler/Checkpoint", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_crawler_checkpoint, gfbgraph_test_fixture_teardown);
+        g_test_add ("/GFBGraph/Crawler/InvalidCheckpoint", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_crawler_invalid_checkpoint, gfbgraph_test_fixture_teardown);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
@@ -0,0 +1,172 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the pool where the asynchronous functions run */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+typedef struct {
+        GMutex mutex;
+        GCond cond;
+        gboolean started;
+        gboolean released;
+        GString *order;
+        GMainLoop *loop;
+        gint pending;
+} GFBGraphTestExecutor;
+
+typedef struct {
+        GFBGraphTestExecutor *executor;
+        const gchar *name;
+        GFBGraphPriority priority;
+        GFBGraphPriority seen_priority;
+        gboolean gate;
+        GError *error;
+} GFBGraphTestJob;
+
+static void
+gfbgraph_test_job_func (GSimpleAsyncResult *simple_async, GObject *object, GCancellable *cancellable)
+{
+        GFBGraphTestExecutor *executor;
+        GFBGraphTestJob *job;
+
+        job = g_simple_async_result_get_op_res_gpointer (simple_async);
+        executor = job->executor;
+
+        job->seen_priority = gfbgraph_get_thread_priority ();
+
+        g_mutex_lock (&executor->mutex);
+        if (job->gate) {
+                executor->started = TRUE;
+                g_cond_broadcast (&executor->cond);
+                while (!executor->released)
+                        g_cond_wait (&executor->cond, &executor->mutex);
+        }
+        g_string_append_printf (executor->order, "%s ", job->name);
+        g_mutex_unlock (&executor->mutex);
+}
+
+static void
+gfbgraph_test_job_done (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+        GFBGraphTestJob *job;
+
+        job = (GFBGraphTestJob *) user_data;
+
+        g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), &job->error);
+
+        job->executor->pending--;
+        if (job->executor->pending == 0)
+                g_main_loop_quit (job->executor->loop);
+}
+
+static void
+gfbgraph_test_job_start (GFBGraphTestJob *job)
+{
+        GSimpleAsyncResult *simple_async;
+        GFBGraphPriority previous;
+
+        simple_async = g_simple_async_result_new (NULL, gfbgraph_test_job_done, job, gfbgraph_test_job_start);
+        g_simple_async_result_set_op_res_gpointer (simple_async, job, NULL);
+
+        job->executor->pending++;
+
+        previous = gfbgraph_set_thread_priority (job->priority);
+        gfbgraph_simple_async_run_in_thread (simple_async, gfbgraph_test_job_func, NULL);
+        gfbgraph_set_thread_priority (previous);
+
+        g_object_unref (simple_async);
+}
+
+static void
+gfbgraph_test_executor_priorities (void)
+{
+        GFBGraphTestExecutor executor = { 0, };
+        GFBGraphExecutorStats before;
+        GFBGraphExecutorStats stats;
+        GFBGraphTestJob blocker = { &executor, "blocker", GFBGRAPH_PRIORITY_NORMAL, 0, TRUE, NULL };
+        GFBGraphTestJob background = { &executor, "background", GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GFBGraphTestJob interactive = { &executor, "interactive", GFBGRAPH_PRIORITY_INTERACTIVE, 0, FALSE, NULL };
+        GFBGraphTestJob rejected = { &executor, "rejected", GFBGRAPH_PRIORITY_INTERACTIVE, 0, FALSE, NULL };
+
+        g_mutex_init (&executor.mutex);
+        g_cond_init (&executor.cond);
+        executor.order = g_string_new (NULL);
+        executor.loop = g_main_loop_new (NULL, FALSE);
+
+        /* One thread, and room for two waiting jobs */
+        gfbgraph_set_executor_limits (1, 2);
+        gfbgraph_get_executor_stats (&before);
+
+        gfbgraph_test_job_start (&blocker);
+
+        g_mutex_lock (&executor.mutex);
+        while (!executor.started)
+                g_cond_wait (&executor.cond, &executor.mutex);
+        g_mutex_unlock (&executor.mutex);
+
+        /* The background job waits first, but the interactive one runs first */
+        gfbgraph_test_job_start (&background);
+        gfbgraph_test_job_start (&interactive);
+        gfbgraph_test_job_start (&rejected);
+
+        gfbgraph_get_executor_stats (&stats);
+        g_assert_cmpuint (stats.running, ==, 1);
+        g_assert_cmpuint (stats.queued, ==, 2);
+        g_assert_cmpuint (stats.rejected, ==, before.rejected + 1);
+
+        g_mutex_lock (&executor.mutex);
+        executor.released = TRUE;
+        g_cond_broadcast (&executor.cond);
+        g_mutex_unlock (&executor.mutex);
+
+        g_main_loop_run (executor.loop);
+
+        g_assert_cmpstr (executor.order->str, ==, "blocker interactive background ");
+
+        g_assert_no_error (blocker.error);
+        g_assert_no_error (background.error);
+        g_assert_no_error (interactive.error);
+        g_assert_error (rejected.error, G_IO_ERROR, G_IO_ERROR_BUSY);
+
+        /* Each job runs with the priority of the thread which started it */
+        g_assert_cmpint (blocker.seen_priority, ==, GFBGRAPH_PRIORITY_NORMAL);
+        g_assert_cmpint (background.seen_priority, ==, GFBGRAPH_PRIORITY_BACKGROUND);
+        g_assert_cmpint (interactive.seen_priority, ==, GFBGRAPH_PRIORITY_INTERACTIVE);
+
+        g_error_free (rejected.error);
+        g_string_free (executor.order, TRUE);
+        g_main_loop_unref (executor.loop);
+        g_mutex_clear (&executor.mutex);
+        g_cond_clear (&executor.cond);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Executor/Priorities", gfbgraph_test_executor_priorities);
+
+        return g_test_run ();
+}
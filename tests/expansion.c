@@ -0,0 +1,199 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the field expansions, against canned Graph API responses */
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+#define EXPANSION_FIELDS "name,albums.limit(50){name,count,photos.limit(100){images,source}}"
+
+/* A user with two albums, the first one with two photos */
+#define EXPANDED_USER \
+        "{\"id\": \"100\", \"name\": \"A user\", \"albums\": {\"data\": [" \
+        "{\"id\": \"200\", \"name\": \"First\", \"count\": 2, \"photos\": {\"data\": [" \
+        "{\"id\": \"300\", \"source\": \"http://example.com/300.jpg\"}, {\"id\": \"301\"}]}}," \
+        "{\"id\": \"201\", \"name\": \"Second\"}]," \
+        "\"paging\": {\"cursors\": {\"after\": \"abc\"}}}}"
+
+static GFBGraphTestServer *server = NULL;
+
+static GFBGraphExpansion*
+gfbgraph_test_expansion_new (void)
+{
+        GFBGraphExpansion *expansion;
+        GFBGraphExpansion *albums;
+
+        expansion = gfbgraph_expansion_new (GFBGRAPH_TYPE_USER, "name");
+        albums = gfbgraph_expansion_add_connection (expansion, GFBGRAPH_TYPE_ALBUM, 50, "name,count");
+        gfbgraph_expansion_add_connection (albums, GFBGRAPH_TYPE_PHOTO, 100, "images,source");
+
+        return expansion;
+}
+
+/* Checks the nodes attached to @user from EXPANDED_USER */
+static void
+gfbgraph_test_expansion_assert_user (GFBGraphNode *user)
+{
+        GPtrArray *albums;
+        GPtrArray *photos;
+        GFBGraphNode *album;
+
+        g_assert_cmpstr (gfbgraph_node_get_id (user), ==, "100");
+        g_assert_cmpstr (gfbgraph_user_get_name (GFBGRAPH_USER (user)), ==, "A user");
+        g_assert (gfbgraph_node_get_expanded_nodes (user, GFBGRAPH_TYPE_PHOTO) == NULL);
+
+        albums = gfbgraph_node_get_expanded_nodes (user, GFBGRAPH_TYPE_ALBUM);
+        g_assert (albums != NULL);
+        g_assert_cmpuint (albums->len, ==, 2);
+
+        album = g_ptr_array_index (albums, 0);
+        g_assert (GFBGRAPH_IS_ALBUM (album));
+        g_assert_cmpstr (gfbgraph_node_get_id (album), ==, "200");
+        g_assert_cmpstr (gfbgraph_album_get_name (GFBGRAPH_ALBUM (album)), ==, "First");
+        g_assert_cmpuint (gfbgraph_album_get_count (GFBGRAPH_ALBUM (album)), ==, 2);
+
+        photos = gfbgraph_node_get_expanded_nodes (album, GFBGRAPH_TYPE_PHOTO);
+        g_assert (photos != NULL);
+        g_assert_cmpuint (photos->len, ==, 2);
+        g_assert (GFBGRAPH_IS_PHOTO (g_ptr_array_index (photos, 0)));
+        g_assert_cmpstr (gfbgraph_node_get_id (g_ptr_array_index (photos, 0)), ==, "300");
+        g_assert_cmpstr (gfbgraph_photo_get_default_source_uri (GFBGRAPH_PHOTO (g_ptr_array_index (photos, 0))),
+                         ==, "http://example.com/300.jpg");
+        g_assert_cmpstr (gfbgraph_node_get_id (g_ptr_array_index (photos, 1)), ==, "301");
+
+        /* Not in the response, so not expanded */
+        album = g_ptr_array_index (albums, 1);
+        g_assert_cmpstr (gfbgraph_node_get_id (album), ==, "201");
+        g_assert (gfbgraph_node_get_expanded_nodes (album, GFBGRAPH_TYPE_PHOTO) == NULL);
+}
+
+static void
+gfbgraph_test_expansion_to_string (void)
+{
+        GFBGraphExpansion *expansion;
+        GFBGraphExpansion *albums;
+        gchar *fields;
+
+        expansion = gfbgraph_test_expansion_new ();
+        g_assert (gfbgraph_expansion_get_node_type (expansion) == GFBGRAPH_TYPE_USER);
+        fields = gfbgraph_expansion_to_string (expansion);
+        g_assert_cmpstr (fields, ==, EXPANSION_FIELDS);
+        g_free (fields);
+        gfbgraph_expansion_unref (expansion);
+
+        /* Without fields nor limits */
+        expansion = gfbgraph_expansion_new (GFBGRAPH_TYPE_USER, NULL);
+        fields = gfbgraph_expansion_to_string (expansion);
+        g_assert_cmpstr (fields, ==, "");
+        g_free (fields);
+
+        albums = gfbgraph_expansion_add_connection (expansion, GFBGRAPH_TYPE_ALBUM, 0, NULL);
+        g_assert (gfbgraph_expansion_get_node_type (albums) == GFBGRAPH_TYPE_ALBUM);
+        fields = gfbgraph_expansion_to_string (expansion);
+        g_assert_cmpstr (fields, ==, "albums");
+        g_free (fields);
+
+        gfbgraph_expansion_add_connection (albums, GFBGRAPH_TYPE_PHOTO, 10, NULL);
+        fields = gfbgraph_expansion_to_string (expansion);
+        g_assert_cmpstr (fields, ==, "albums{photos.limit(10)}");
+        g_free (fields);
+
+        gfbgraph_expansion_unref (expansion);
+}
+
+static void
+gfbgraph_test_expansion_apply (void)
+{
+        GFBGraphExpansion *expansion;
+        GFBGraphNode *user;
+        JsonParser *parser;
+        JsonNode *root;
+        GError *error = NULL;
+
+        parser = json_parser_new ();
+        json_parser_load_from_data (parser, EXPANDED_USER, -1, &error);
+        g_assert_no_error (error);
+        root = json_parser_get_root (parser);
+
+        expansion = gfbgraph_test_expansion_new ();
+        user = gfbgraph_node_new_from_json (GFBGRAPH_TYPE_USER, root);
+
+        /* Two albums and two photos */
+        g_assert_cmpuint (gfbgraph_expansion_apply (expansion, user, json_node_get_object (root), NULL), ==, 4);
+        gfbgraph_test_expansion_assert_user (user);
+
+        g_object_unref (user);
+        gfbgraph_expansion_unref (expansion);
+        g_object_unref (parser);
+}
+
+static void
+gfbgraph_test_expansion_request (void)
+{
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphExpansion *expansion;
+        GFBGraphNode *user;
+        GError *error = NULL;
+
+        gfbgraph_test_server_add (server, "/100", "fields=" EXPANSION_FIELDS, SOUP_STATUS_OK, EXPANDED_USER);
+
+        authorizer = gfbgraph_simple_authorizer_new ("token");
+        expansion = gfbgraph_test_expansion_new ();
+
+        /* The whole tree in one request */
+        user = gfbgraph_node_new_from_id_expanded (GFBGRAPH_AUTHORIZER (authorizer), "100", expansion, &error);
+        g_assert_no_error (error);
+        g_assert (GFBGRAPH_IS_USER (user));
+        gfbgraph_test_expansion_assert_user (user);
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 1);
+
+        g_object_unref (user);
+        gfbgraph_expansion_unref (expansion);
+        g_object_unref (authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add_func ("/GFBGraph/Expansion/ToString", gfbgraph_test_expansion_to_string);
+        g_test_add_func ("/GFBGraph/Expansion/Apply", gfbgraph_test_expansion_apply);
+        g_test_add_func ("/GFBGraph/Expansion/Request", gfbgraph_test_expansion_request);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
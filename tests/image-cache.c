@@ -0,0 +1,200 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the image cache, over a temporary directory */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <utime.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+#include "test-server.h"
+
+#define OLD_NAME    "0000000000000000000000000000000000000001"
+#define NEW_NAME    "0000000000000000000000000000000000000002"
+#define UPPER_NAME  "ABCDEF0000000000000000000000000000000003"
+
+static GFBGraphTestServer *server;
+
+static void
+gfbgraph_test_write_file (const gchar *directory, const gchar *name, gsize size, time_t mtime)
+{
+        struct utimbuf times;
+        gchar *contents;
+        gchar *path;
+
+        contents = g_malloc0 (size);
+        path = g_build_filename (directory, name, NULL);
+
+        g_assert (g_file_set_contents (path, contents, size, NULL));
+        times.actime = mtime;
+        times.modtime = mtime;
+        g_assert_cmpint (utime (path, &times), ==, 0);
+
+        g_free (path);
+        g_free (contents);
+}
+
+static gboolean
+gfbgraph_test_file_exists (const gchar *directory, const gchar *name)
+{
+        gboolean exists;
+        gchar *path;
+
+        path = g_build_filename (directory, name, NULL);
+        exists = g_file_test (path, G_FILE_TEST_EXISTS);
+        g_free (path);
+
+        return exists;
+}
+
+static guint
+gfbgraph_test_count_files (const gchar *directory)
+{
+        GDir *dir;
+        guint count = 0;
+
+        dir = g_dir_open (directory, 0, NULL);
+        while (g_dir_read_name (dir) != NULL)
+                count++;
+        g_dir_close (dir);
+
+        return count;
+}
+
+static void
+gfbgraph_test_remove_dir (const gchar *directory)
+{
+        const gchar *name;
+        GDir *dir;
+
+        dir = g_dir_open (directory, 0, NULL);
+        while ((name = g_dir_read_name (dir)) != NULL) {
+                gchar *path;
+
+                path = g_build_filename (directory, name, NULL);
+                g_unlink (path);
+                g_free (path);
+        }
+        g_dir_close (dir);
+
+        g_rmdir (directory);
+}
+
+/* The least recently used images go first, and the files which aren't
+ * images of the cache are never touched */
+static void
+gfbgraph_test_image_cache_eviction (void)
+{
+        GError *error = NULL;
+        gchar *directory;
+
+        directory = g_dir_make_tmp ("gfbgraph-image-cache-XXXXXX", &error);
+        g_assert_no_error (error);
+
+        gfbgraph_test_write_file (directory, OLD_NAME, 1000, 1000);
+        gfbgraph_test_write_file (directory, NEW_NAME, 1000, 2000);
+        gfbgraph_test_write_file (directory, UPPER_NAME, 1000, 10);
+        gfbgraph_test_write_file (directory, "notes.txt", 1000, 10);
+        gfbgraph_test_write_file (directory, "README", 1000, 10);
+
+        g_assert (gfbgraph_set_image_cache (directory, 1500, &error));
+        g_assert_no_error (error);
+
+        g_assert (!gfbgraph_test_file_exists (directory, OLD_NAME));
+        g_assert (gfbgraph_test_file_exists (directory, NEW_NAME));
+        g_assert (gfbgraph_test_file_exists (directory, UPPER_NAME));
+        g_assert (gfbgraph_test_file_exists (directory, "notes.txt"));
+        g_assert (gfbgraph_test_file_exists (directory, "README"));
+
+        /* The most recent one is kept even if it alone is over the limit */
+        g_assert (gfbgraph_set_image_cache (directory, 10, &error));
+        g_assert (gfbgraph_test_file_exists (directory, NEW_NAME));
+
+        g_assert (gfbgraph_set_image_cache (NULL, 0, &error));
+        g_assert_no_error (error);
+
+        gfbgraph_test_remove_dir (directory);
+        g_free (directory);
+}
+
+/* An error answer is an error, its body never gets in the cache */
+static void
+gfbgraph_test_image_cache_prefetch (void)
+{
+        GInputStream *stream;
+        GError *error = NULL;
+        gchar *directory;
+        gchar *found_uri;
+        gchar *missing_uri;
+
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add (server, "/photo.jpg", NULL, 200, "image");
+        found_uri = g_strconcat (gfbgraph_test_server_get_uri (server), "/photo.jpg", NULL);
+        missing_uri = g_strconcat (gfbgraph_test_server_get_uri (server), "/missing.jpg", NULL);
+
+        directory = g_dir_make_tmp ("gfbgraph-image-cache-XXXXXX", &error);
+        g_assert_no_error (error);
+        g_assert (gfbgraph_set_image_cache (directory, 1000000, &error));
+        g_assert_no_error (error);
+
+        g_assert (gfbgraph_image_cache_prefetch (NULL, "1", 100, 100, found_uri, &error));
+        g_assert_no_error (error);
+        g_assert_cmpuint (gfbgraph_test_count_files (directory), ==, 1);
+
+        g_assert (!gfbgraph_image_cache_prefetch (NULL, "2", 100, 100, missing_uri, &error));
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+        g_clear_error (&error);
+        g_assert_cmpuint (gfbgraph_test_count_files (directory), ==, 1);
+
+        stream = gfbgraph_image_cache_download (NULL, "2", 100, 100, missing_uri, &error);
+        g_assert (stream == NULL);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+        g_clear_error (&error);
+
+        g_assert (gfbgraph_set_image_cache (NULL, 0, &error));
+        g_assert_no_error (error);
+
+        gfbgraph_test_remove_dir (directory);
+        g_free (directory);
+        g_free (missing_uri);
+        g_free (found_uri);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add_func ("/GFBGraph/ImageCache/Eviction", gfbgraph_test_image_cache_eviction);
+        g_test_add_func ("/GFBGraph/ImageCache/Prefetch", gfbgraph_test_image_cache_prefetch);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
@@ -0,0 +1,234 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the nodes, which don't need any server */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+/* A node defined outside the library, read only through its properties */
+typedef struct {
+        GFBGraphNode parent;
+        gint64 count;
+        gchar **tags;
+} GFBGraphTestNode;
+
+typedef struct {
+        GFBGraphNodeClass parent_class;
+} GFBGraphTestNodeClass;
+
+enum {
+        PROP_0,
+        PROP_COUNT,
+        PROP_TAGS
+};
+
+GType gfbgraph_test_node_get_type (void);
+
+G_DEFINE_TYPE (GFBGraphTestNode, gfbgraph_test_node, GFBGRAPH_TYPE_NODE);
+
+static void
+gfbgraph_test_node_finalize (GObject *object)
+{
+        g_strfreev (((GFBGraphTestNode *) object)->tags);
+
+        G_OBJECT_CLASS (gfbgraph_test_node_parent_class)->finalize (object);
+}
+
+static void
+gfbgraph_test_node_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+        GFBGraphTestNode *node;
+
+        node = (GFBGraphTestNode *) object;
+
+        switch (prop_id) {
+                case PROP_COUNT:
+                        node->count = g_value_get_int64 (value);
+                        break;
+                case PROP_TAGS:
+                        g_strfreev (node->tags);
+                        node->tags = g_value_dup_boxed (value);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_test_node_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+        GFBGraphTestNode *node;
+
+        node = (GFBGraphTestNode *) object;
+
+        switch (prop_id) {
+                case PROP_COUNT:
+                        g_value_set_int64 (value, node->count);
+                        break;
+                case PROP_TAGS:
+                        g_value_set_boxed (value, node->tags);
+                        break;
+                default:
+                        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                        break;
+        }
+}
+
+static void
+gfbgraph_test_node_init (GFBGraphTestNode *node)
+{
+}
+
+static void
+gfbgraph_test_node_class_init (GFBGraphTestNodeClass *klass)
+{
+        GObjectClass *gobject_class;
+
+        gobject_class = G_OBJECT_CLASS (klass);
+
+        gobject_class->finalize = gfbgraph_test_node_finalize;
+        gobject_class->set_property = gfbgraph_test_node_set_property;
+        gobject_class->get_property = gfbgraph_test_node_get_property;
+
+        g_object_class_install_property (gobject_class,
+                                         PROP_COUNT,
+                                         g_param_spec_int64 ("count", "Count", "A number",
+                                                             0, G_MAXINT64, 0, G_PARAM_READWRITE));
+        g_object_class_install_property (gobject_class,
+                                         PROP_TAGS,
+                                         g_param_spec_boxed ("tags", "Tags", "A list of strings",
+                                                             G_TYPE_STRV, G_PARAM_READWRITE));
+}
+
+static void
+gfbgraph_test_node_alive (void)
+{
+        GFBGraphPhoto *photo;
+        guint photos;
+        guint nodes;
+
+        photos = gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO);
+        nodes = gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_NODE);
+
+        photo = gfbgraph_photo_new ();
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO), ==, photos + 1);
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_NODE), ==, nodes);
+
+        g_object_unref (photo);
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_PHOTO), ==, photos);
+        g_assert_cmpuint (gfbgraph_get_nodes_alive (GFBGRAPH_TYPE_NODE), ==, nodes);
+}
+
+static void
+gfbgraph_test_node_properties (gconstpointer user_data)
+{
+        const gchar *data = "{\"id\": \"42\", \"count\": 7, \"tags\": [\"a\", \"b\"], \"unknown\": {\"x\": 1}}";
+        JsonParser *parser;
+        GFBGraphNode *node;
+        GFBGraphTestNode *test_node;
+
+        gfbgraph_set_lazy_deserialization (GPOINTER_TO_INT (user_data));
+
+        parser = json_parser_new ();
+        g_assert (json_parser_load_from_data (parser, data, -1, NULL));
+        node = gfbgraph_node_new_from_json (gfbgraph_test_node_get_type (), json_parser_get_root (parser));
+        g_object_unref (parser);
+
+        g_assert_cmpstr (gfbgraph_node_get_id (node), ==, "42");
+        /* Decodes a lazily deserialized node */
+        g_assert (gfbgraph_node_get_link (node) == NULL);
+
+        /* Members that no deserialize_member() consumes */
+        test_node = (GFBGraphTestNode *) node;
+        g_assert_cmpint (test_node->count, ==, 7);
+        g_assert (test_node->tags != NULL);
+        g_assert_cmpuint (g_strv_length (test_node->tags), ==, 2);
+        g_assert_cmpstr (test_node->tags[0], ==, "a");
+        g_assert_cmpstr (test_node->tags[1], ==, "b");
+
+        g_object_unref (node);
+        gfbgraph_set_lazy_deserialization (FALSE);
+}
+
+static void
+gfbgraph_test_node_freeze (void)
+{
+        const gchar *data = "{\"id\": \"42\", \"count\": 7, \"tags\": [\"a\"]}";
+        GFBGraphAlbum *album;
+        GFBGraphPhoto *photo;
+        GPtrArray *photos;
+        JsonParser *parser;
+        GFBGraphNode *node;
+        GFBGraphTestNode *test_node;
+
+        album = gfbgraph_album_new ();
+        gfbgraph_album_set_name (album, "Before");
+
+        photo = gfbgraph_photo_new ();
+        photos = g_ptr_array_new_with_free_func (g_object_unref);
+        g_ptr_array_add (photos, photo);
+        gfbgraph_node_set_expanded_nodes (GFBGRAPH_NODE (album), GFBGRAPH_TYPE_PHOTO, photos);
+
+        gfbgraph_node_freeze (GFBGRAPH_NODE (album));
+        g_assert (gfbgraph_node_is_frozen (GFBGRAPH_NODE (album)));
+        /* Along with the nodes retrieved with it */
+        g_assert (gfbgraph_node_is_frozen (GFBGRAPH_NODE (photo)));
+
+        g_test_expect_message ("GFBGraph", G_LOG_LEVEL_CRITICAL, "*frozen*");
+        gfbgraph_album_set_name (album, "After");
+        g_test_assert_expected_messages ();
+        g_assert_cmpstr (gfbgraph_album_get_name (album), ==, "Before");
+
+        g_object_unref (album);
+
+        /* The pending members are decoded before the node is frozen */
+        gfbgraph_set_lazy_deserialization (TRUE);
+
+        parser = json_parser_new ();
+        g_assert (json_parser_load_from_data (parser, data, -1, NULL));
+        node = gfbgraph_node_new_from_json (gfbgraph_test_node_get_type (), json_parser_get_root (parser));
+        g_object_unref (parser);
+
+        gfbgraph_node_freeze (node);
+        test_node = (GFBGraphTestNode *) node;
+        g_assert_cmpint (test_node->count, ==, 7);
+        g_assert (test_node->tags != NULL);
+        g_assert_cmpstr (test_node->tags[0], ==, "a");
+
+        g_object_unref (node);
+        gfbgraph_set_lazy_deserialization (FALSE);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Node/Alive", gfbgraph_test_node_alive);
+        g_test_add_data_func ("/GFBGraph/Node/Properties", GINT_TO_POINTER (FALSE), gfbgraph_test_node_properties);
+        g_test_add_data_func ("/GFBGraph/Node/PropertiesLazy", GINT_TO_POINTER (TRUE), gfbgraph_test_node_properties);
+        g_test_add_func ("/GFBGraph/Node/Freeze", gfbgraph_test_node_freeze);
+
+        return g_test_run ();
+}
@@ -0,0 +1,241 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the pager, against canned Graph API responses */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+#define PHOTOS_PATH "/1/photos"
+#define NEXT_PAGE_URL "https://graph.facebook.com/v2.3/1/photos?page="
+
+typedef struct {
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphAlbum *album;
+        GFBGraphPager *pager;
+} GFBGraphTestFixture;
+
+typedef struct {
+        GMainLoop *loop;
+        GPtrArray *nodes;
+        GError *error;
+} GFBGraphTestNext;
+
+static GFBGraphTestServer *server = NULL;
+
+static void
+gfbgraph_test_fixture_setup (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        /* Six photos in four pages, the third one empty */
+        gfbgraph_test_server_add (server, PHOTOS_PATH, NULL, SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p1\"}, {\"id\": \"p2\"}, {\"id\": \"p3\"}],"
+                                  "\"paging\": {\"next\": \"" NEXT_PAGE_URL "2\"},"
+                                  "\"summary\": {\"total_count\": 6}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=2", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p4\"}, {\"id\": \"p5\"}],"
+                                  "\"paging\": {\"next\": \"" NEXT_PAGE_URL "3\"}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=3", SOUP_STATUS_OK,
+                                  "{\"data\": [], \"paging\": {\"next\": \"" NEXT_PAGE_URL "4\"}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=4", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p6\"}]}");
+
+        fixture->authorizer = gfbgraph_simple_authorizer_new ("token");
+        fixture->album = gfbgraph_album_new ();
+        g_object_set (fixture->album, "id", "1", NULL);
+        fixture->pager = gfbgraph_pager_new (GFBGRAPH_NODE (fixture->album), GFBGRAPH_TYPE_PHOTO,
+                                             GFBGRAPH_AUTHORIZER (fixture->authorizer));
+}
+
+static void
+gfbgraph_test_fixture_teardown (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        g_object_unref (fixture->pager);
+        g_object_unref (fixture->album);
+        g_object_unref (fixture->authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+static void
+gfbgraph_test_next_nodes_cb (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+        GFBGraphTestNext *next;
+
+        next = (GFBGraphTestNext *) user_data;
+
+        next->nodes = gfbgraph_pager_next_nodes_finish (GFBGRAPH_PAGER (source_object), result, &next->error);
+        g_main_loop_quit (next->loop);
+}
+
+static GPtrArray*
+gfbgraph_test_pager_next_nodes (GFBGraphPager *pager, guint max_nodes, GCancellable *cancellable, GError **error)
+{
+        GFBGraphTestNext next;
+
+        next.loop = g_main_loop_new (NULL, FALSE);
+        next.nodes = NULL;
+        next.error = NULL;
+
+        gfbgraph_pager_next_nodes_async (pager, max_nodes, cancellable, gfbgraph_test_next_nodes_cb, &next);
+        g_main_loop_run (next.loop);
+        g_main_loop_unref (next.loop);
+
+        if (next.error != NULL)
+                g_propagate_error (error, next.error);
+
+        return next.nodes;
+}
+
+/* Appends the IDs of @nodes to @ids, separated by commas */
+static void
+gfbgraph_test_append_ids (GString *ids, GPtrArray *nodes)
+{
+        guint i;
+
+        for (i = 0; i < nodes->len; i++) {
+                if (ids->len > 0)
+                        g_string_append_c (ids, ',');
+                g_string_append (ids, gfbgraph_node_get_id (GFBGRAPH_NODE (g_ptr_array_index (nodes, i))));
+        }
+}
+
+static void
+gfbgraph_test_pager_pages (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+        GPtrArray *nodes;
+        GString *ids;
+        guint n_pages;
+
+        g_object_set (fixture->pager, "summary", TRUE, NULL);
+
+        ids = g_string_new (NULL);
+        n_pages = 0;
+        while ((nodes = gfbgraph_pager_next (fixture->pager, &error)) != NULL) {
+                if (n_pages == 0) {
+                        g_assert_cmpint (gfbgraph_pager_get_total_count (fixture->pager), ==, 6);
+                        /* Estimated with the size of the first page */
+                        g_assert_cmpint (gfbgraph_pager_get_n_pages (fixture->pager), ==, 2);
+                }
+
+                gfbgraph_test_append_ids (ids, nodes);
+                g_ptr_array_unref (nodes);
+                n_pages++;
+        }
+        g_assert_no_error (error);
+
+        g_assert_cmpuint (n_pages, ==, 4);
+        g_assert_cmpstr (ids->str, ==, "p1,p2,p3,p4,p5,p6");
+        g_assert (gfbgraph_pager_is_done (fixture->pager));
+        g_assert_cmpuint (gfbgraph_pager_get_fetched_count (fixture->pager), ==, 6);
+
+        g_string_free (ids, TRUE);
+}
+
+static void
+gfbgraph_test_pager_chunks (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+        GPtrArray *nodes;
+        GString *ids;
+
+        /* Chunks across the page boundaries, until an empty one */
+        ids = g_string_new (NULL);
+        while ((nodes = gfbgraph_test_pager_next_nodes (fixture->pager, 2, NULL, &error))->len > 0) {
+                g_assert_cmpuint (nodes->len, <=, 2);
+                gfbgraph_test_append_ids (ids, nodes);
+                g_ptr_array_unref (nodes);
+        }
+        g_assert_no_error (error);
+        g_ptr_array_unref (nodes);
+
+        g_assert_cmpstr (ids->str, ==, "p1,p2,p3,p4,p5,p6");
+        g_assert (gfbgraph_pager_is_done (fixture->pager));
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 4);
+
+        g_string_free (ids, TRUE);
+}
+
+static void
+gfbgraph_test_pager_cancel (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GCancellable *cancellable;
+        GError *error = NULL;
+        GPtrArray *nodes;
+
+        cancellable = g_cancellable_new ();
+        g_cancellable_cancel (cancellable);
+
+        /* The call fails, but not the first page it requested */
+        nodes = gfbgraph_test_pager_next_nodes (fixture->pager, 1, cancellable, &error);
+        g_assert (nodes == NULL);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        g_clear_error (&error);
+
+        nodes = gfbgraph_test_pager_next_nodes (fixture->pager, 1, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpuint (nodes->len, ==, 1);
+        g_assert_cmpstr (gfbgraph_node_get_id (GFBGRAPH_NODE (g_ptr_array_index (nodes, 0))), ==, "p1");
+        g_ptr_array_unref (nodes);
+
+        /* The buffered nodes aren't lost */
+        nodes = gfbgraph_test_pager_next_nodes (fixture->pager, 1, cancellable, &error);
+        g_assert (nodes == NULL);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        g_clear_error (&error);
+
+        nodes = gfbgraph_test_pager_next_nodes (fixture->pager, 1, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpuint (nodes->len, ==, 1);
+        g_assert_cmpstr (gfbgraph_node_get_id (GFBGRAPH_NODE (g_ptr_array_index (nodes, 0))), ==, "p2");
+        g_ptr_array_unref (nodes);
+
+        g_object_unref (cancellable);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add ("/GFBGraph/Pager/Pages", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_pager_pages, gfbgraph_test_fixture_teardown);
+        g_test_add ("/GFBGraph/Pager/Chunks", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_pager_chunks, gfbgraph_test_fixture_teardown);
+        g_test_add ("/GFBGraph/Pager/Cancel", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_pager_cancel, gfbgraph_test_fixture_teardown);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
@@ -0,0 +1,141 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the photo images, which don't need any server */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+
+static GFBGraphPhotoImage test_images[] = {
+        { 720, 480, (gchar *) "http://example.com/720x480.jpg" },
+        { 130, 87, (gchar *) "http://example.com/130x87.jpg" },
+        { 320, 640, (gchar *) "http://example.com/320x640.jpg" }
+};
+
+static GFBGraphPhoto*
+gfbgraph_test_photo_new (void)
+{
+        GFBGraphPhoto *photo;
+        GList *images_list;
+        guint i;
+
+        images_list = NULL;
+        for (i = 0; i < G_N_ELEMENTS (test_images); i++)
+                images_list = g_list_append (images_list, &test_images[i]);
+
+        photo = gfbgraph_photo_new ();
+        g_object_set (photo, "images", images_list, NULL);
+        g_list_free (images_list);
+
+        return photo;
+}
+
+static void
+gfbgraph_test_photo_near_width (void)
+{
+        GFBGraphPhoto *photo;
+        const GFBGraphPhotoImage *image;
+
+        photo = gfbgraph_test_photo_new ();
+
+        image = gfbgraph_photo_get_image_near_width (photo, 100);
+        g_assert_cmpuint (image->width, ==, 130);
+        image = gfbgraph_photo_get_image_near_width (photo, 300);
+        g_assert_cmpuint (image->width, ==, 320);
+        image = gfbgraph_photo_get_image_near_width (photo, 720);
+        g_assert_cmpuint (image->width, ==, 720);
+        image = gfbgraph_photo_get_image_near_width (photo, 4000);
+        g_assert_cmpuint (image->width, ==, 720);
+        g_assert_cmpstr (image->source, ==, "http://example.com/720x480.jpg");
+
+        image = gfbgraph_photo_get_image_hires (photo);
+        g_assert_cmpuint (image->width, ==, 720);
+
+        g_object_unref (photo);
+}
+
+static void
+gfbgraph_test_photo_near_height (void)
+{
+        GFBGraphPhoto *photo;
+        const GFBGraphPhotoImage *image;
+
+        photo = gfbgraph_test_photo_new ();
+
+        image = gfbgraph_photo_get_image_near_height (photo, 10);
+        g_assert_cmpuint (image->height, ==, 87);
+        image = gfbgraph_photo_get_image_near_height (photo, 500);
+        g_assert_cmpuint (image->height, ==, 480);
+        image = gfbgraph_photo_get_image_near_height (photo, 600);
+        g_assert_cmpuint (image->height, ==, 640);
+        g_assert_cmpuint (image->width, ==, 320);
+
+        g_object_unref (photo);
+}
+
+static void
+gfbgraph_test_photo_images_copy (void)
+{
+        GFBGraphPhoto *photo;
+        GFBGraphPhoto *other;
+        GList *images_list;
+        const GFBGraphPhotoImage *image;
+
+        photo = gfbgraph_test_photo_new ();
+        other = gfbgraph_photo_new ();
+
+        /* The list got from a photo can be set on another one... */
+        g_object_get (photo, "images", &images_list, NULL);
+        g_assert_cmpuint (g_list_length (images_list), ==, G_N_ELEMENTS (test_images));
+        g_object_set (other, "images", images_list, NULL);
+
+        /* ...and on the same one */
+        g_object_get (photo, "images", &images_list, NULL);
+        g_object_set (photo, "images", images_list, NULL);
+
+        g_assert_cmpuint (g_list_length (gfbgraph_photo_get_images (photo)), ==, G_N_ELEMENTS (test_images));
+        g_assert_cmpuint (g_list_length (gfbgraph_photo_get_images (other)), ==, G_N_ELEMENTS (test_images));
+
+        image = gfbgraph_photo_get_image_near_width (photo, 300);
+        g_assert_cmpstr (image->source, ==, "http://example.com/320x640.jpg");
+        image = gfbgraph_photo_get_image_near_width (other, 300);
+        g_assert_cmpstr (image->source, ==, "http://example.com/320x640.jpg");
+
+        /* The images of the other photo are its own */
+        g_object_unref (photo);
+        image = gfbgraph_photo_get_image_near_height (other, 10);
+        g_assert_cmpstr (image->source, ==, "http://example.com/130x87.jpg");
+
+        g_object_unref (other);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Photo/NearWidth", gfbgraph_test_photo_near_width);
+        g_test_add_func ("/GFBGraph/Photo/NearHeight", gfbgraph_test_photo_near_height);
+        g_test_add_func ("/GFBGraph/Photo/ImagesCopy", gfbgraph_test_photo_images_copy);
+
+        return g_test_run ();
+}
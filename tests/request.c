@@ -0,0 +1,134 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the records of the requests, against the local test server */
+
+#include <glib.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+static GFBGraphTestServer *server = NULL;
+
+static void
+gfbgraph_test_request_finished_cb (GFBGraphAuthorizer *authorizer, GFBGraphRequestRecord *record, gpointer user_data)
+{
+        GFBGraphRequestRecord **last_record;
+
+        last_record = (GFBGraphRequestRecord **) user_data;
+
+        /* Only valid during the emission */
+        if (*last_record != NULL)
+                gfbgraph_request_record_free (*last_record);
+        *last_record = gfbgraph_request_record_copy (record);
+}
+
+/* Fetches the node 42 and returns the record of its request */
+static GFBGraphRequestRecord*
+gfbgraph_test_request_fetch (gboolean found)
+{
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphRequestRecord *record = NULL;
+        GFBGraphNode *node;
+        GError *error = NULL;
+
+        authorizer = gfbgraph_simple_authorizer_new ("token");
+        g_signal_connect (authorizer, "request-finished", G_CALLBACK (gfbgraph_test_request_finished_cb), &record);
+
+        node = gfbgraph_node_new_from_id (GFBGRAPH_AUTHORIZER (authorizer), "42", GFBGRAPH_TYPE_PHOTO, &error);
+        if (found) {
+                g_assert_no_error (error);
+                g_assert (GFBGRAPH_IS_PHOTO (node));
+                g_object_unref (node);
+        } else {
+                g_assert (error != NULL);
+                g_assert (node == NULL);
+                g_clear_error (&error);
+        }
+
+        g_object_unref (authorizer);
+
+        g_assert (record != NULL);
+        g_assert_cmpstr (record->method, ==, "GET");
+        g_assert_cmpstr (record->function, ==, "42");
+        g_assert_cmpint (record->start_time, >, 0);
+        g_assert_cmpint (record->start_time, <=, record->admitted_time);
+        g_assert_cmpint (record->admitted_time, <=, record->end_time);
+        g_assert_cmpuint (record->retries, ==, 0);
+        g_assert (!record->cache_hit);
+
+        return record;
+}
+
+static void
+gfbgraph_test_request_record (void)
+{
+        GFBGraphRequestRecord *record;
+
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add (server, "/42", NULL, 200, "{\"id\": \"42\", \"name\": \"A photo\"}");
+
+        record = gfbgraph_test_request_fetch (TRUE);
+        g_assert_cmpuint (record->status_code, ==, 200);
+        g_assert_cmpuint (record->nodes, ==, 1);
+        g_assert_cmpuint (record->bytes_received, >, 0);
+        g_assert_cmpint (record->response_headers_time, >=, record->start_time);
+        g_assert_cmpint (record->response_body_time, >=, record->response_headers_time);
+        g_assert_cmpint (record->parse_start_time, >=, record->response_body_time);
+        g_assert_cmpint (record->parse_end_time, >=, record->parse_start_time);
+        g_assert_cmpint (record->end_time, >=, record->parse_end_time);
+        gfbgraph_request_record_free (record);
+}
+
+/* A failed request is recorded too */
+static void
+gfbgraph_test_request_record_error (void)
+{
+        GFBGraphRequestRecord *record;
+
+        gfbgraph_test_server_clear (server);
+
+        record = gfbgraph_test_request_fetch (FALSE);
+        g_assert_cmpuint (record->status_code, ==, 404);
+        g_assert_cmpuint (record->nodes, ==, 0);
+        gfbgraph_request_record_free (record);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add_func ("/GFBGraph/Request/Record", gfbgraph_test_request_record);
+        g_test_add_func ("/GFBGraph/Request/RecordError", gfbgraph_test_request_record_error);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
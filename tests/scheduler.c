@@ -0,0 +1,197 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the priority classes of the requests */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+
+/* Time for a blocked request to show it doesn't start */
+#define WAIT_DELAY_MS 200
+
+typedef struct {
+        GFBGraphPriority priority;
+        gint64 deadline;
+        gint admitted;
+        GFBGraphRequestRecord *record;
+} GFBGraphTestRequest;
+
+static gpointer
+gfbgraph_test_request_thread (gpointer user_data)
+{
+        GFBGraphTestRequest *request;
+
+        request = (GFBGraphTestRequest *) user_data;
+
+        gfbgraph_set_thread_priority (request->priority);
+        gfbgraph_set_thread_deadline (request->deadline);
+
+        request->record = gfbgraph_request_record_begin ("GET", "test");
+
+        g_atomic_int_set (&request->admitted, TRUE);
+
+        return NULL;
+}
+
+static void
+gfbgraph_test_scheduler_limit (void)
+{
+        GFBGraphTestRequest first = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GFBGraphTestRequest second = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GThread *thread;
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_BACKGROUND, 1);
+
+        gfbgraph_test_request_thread (&first);
+
+        /* The class is full, so the second request waits for the first */
+        thread = g_thread_new ("second", gfbgraph_test_request_thread, &second);
+        g_usleep (WAIT_DELAY_MS * 1000);
+        g_assert (!g_atomic_int_get (&second.admitted));
+
+        gfbgraph_request_record_end (first.record, NULL);
+        g_thread_join (thread);
+        g_assert (g_atomic_int_get (&second.admitted));
+
+        gfbgraph_request_record_end (second.record, NULL);
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_BACKGROUND, 2);
+        gfbgraph_set_thread_priority (GFBGRAPH_PRIORITY_NORMAL);
+}
+
+static void
+gfbgraph_test_scheduler_own_limit (void)
+{
+        GFBGraphTestRequest first = { GFBGRAPH_PRIORITY_NORMAL, 0, FALSE, NULL };
+        GFBGraphTestRequest normal = { GFBGRAPH_PRIORITY_NORMAL, 0, FALSE, NULL };
+        GFBGraphTestRequest background = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GThread *normal_thread;
+        GThread *background_thread;
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_NORMAL, 1);
+
+        gfbgraph_test_request_thread (&first);
+
+        normal_thread = g_thread_new ("normal", gfbgraph_test_request_thread, &normal);
+        g_usleep (WAIT_DELAY_MS * 1000);
+        g_assert (!g_atomic_int_get (&normal.admitted));
+
+        /* The normal request waits for its own class, so the background one
+         * would free nothing for it by waiting too */
+        background_thread = g_thread_new ("background", gfbgraph_test_request_thread, &background);
+        g_thread_join (background_thread);
+        g_assert (g_atomic_int_get (&background.admitted));
+        g_assert (!g_atomic_int_get (&normal.admitted));
+
+        gfbgraph_request_record_end (first.record, NULL);
+        g_thread_join (normal_thread);
+        g_assert (g_atomic_int_get (&normal.admitted));
+
+        gfbgraph_request_record_end (normal.record, NULL);
+        gfbgraph_request_record_end (background.record, NULL);
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_NORMAL, 0);
+        gfbgraph_set_thread_priority (GFBGRAPH_PRIORITY_NORMAL);
+}
+
+static void
+gfbgraph_test_scheduler_capacity (void)
+{
+        GFBGraphTestRequest first = { GFBGRAPH_PRIORITY_NORMAL, 0, FALSE, NULL };
+        GFBGraphTestRequest background = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GFBGraphTestRequest interactive = { GFBGRAPH_PRIORITY_INTERACTIVE, 0, FALSE, NULL };
+        GThread *background_thread;
+        GThread *interactive_thread;
+
+        /* One place for all the classes */
+        gfbgraph_set_max_requests (1);
+
+        gfbgraph_test_request_thread (&first);
+
+        background_thread = g_thread_new ("background", gfbgraph_test_request_thread, &background);
+        g_usleep (WAIT_DELAY_MS * 1000);
+        interactive_thread = g_thread_new ("interactive", gfbgraph_test_request_thread, &interactive);
+        g_usleep (WAIT_DELAY_MS * 1000);
+        g_assert (!g_atomic_int_get (&background.admitted));
+        g_assert (!g_atomic_int_get (&interactive.admitted));
+
+        /* The freed place goes to the interactive request, though it came later */
+        gfbgraph_request_record_end (first.record, NULL);
+        g_thread_join (interactive_thread);
+        g_usleep (WAIT_DELAY_MS * 1000);
+        g_assert (!g_atomic_int_get (&background.admitted));
+
+        gfbgraph_request_record_end (interactive.record, NULL);
+        g_thread_join (background_thread);
+        g_assert (g_atomic_int_get (&background.admitted));
+
+        gfbgraph_request_record_end (background.record, NULL);
+
+        gfbgraph_set_max_requests (8);
+        gfbgraph_set_thread_priority (GFBGRAPH_PRIORITY_NORMAL);
+}
+
+static void
+gfbgraph_test_scheduler_deadline (void)
+{
+        GFBGraphTestRequest first = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GFBGraphTestRequest late = { GFBGRAPH_PRIORITY_BACKGROUND, 0, FALSE, NULL };
+        GError *error = NULL;
+        GThread *thread;
+        gint64 start_time;
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_BACKGROUND, 1);
+
+        gfbgraph_test_request_thread (&first);
+
+        /* The wait for a turn ends with the deadline of the request */
+        start_time = g_get_monotonic_time ();
+        late.deadline = start_time + WAIT_DELAY_MS * G_TIME_SPAN_MILLISECOND;
+        thread = g_thread_new ("late", gfbgraph_test_request_thread, &late);
+        g_thread_join (thread);
+
+        g_assert (g_atomic_int_get (&late.admitted));
+        g_assert_cmpint (g_get_monotonic_time (), >=, late.deadline);
+        g_assert (gfbgraph_request_record_check_deadline (late.record, &error));
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+        g_error_free (error);
+
+        gfbgraph_request_record_end (late.record, NULL);
+        gfbgraph_request_record_end (first.record, NULL);
+
+        gfbgraph_set_priority_limit (GFBGRAPH_PRIORITY_BACKGROUND, 2);
+        gfbgraph_set_thread_priority (GFBGRAPH_PRIORITY_NORMAL);
+        gfbgraph_set_thread_deadline (0);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Scheduler/Limit", gfbgraph_test_scheduler_limit);
+        g_test_add_func ("/GFBGraph/Scheduler/OwnLimit", gfbgraph_test_scheduler_own_limit);
+        g_test_add_func ("/GFBGraph/Scheduler/Capacity", gfbgraph_test_scheduler_capacity);
+        g_test_add_func ("/GFBGraph/Scheduler/Deadline", gfbgraph_test_scheduler_deadline);
+
+        return g_test_run ();
+}
@@ -0,0 +1,245 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the node serialization and the node streams */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+
+static GFBGraphPhotoImage test_images[] = {
+        { 720, 480, (gchar *) "http://example.com/720x480.jpg" },
+        { 130, 87, (gchar *) "http://example.com/130x87.jpg" }
+};
+
+static GFBGraphNode*
+gfbgraph_test_album_new (void)
+{
+        GFBGraphNode *album;
+
+        album = GFBGRAPH_NODE (g_object_new (GFBGRAPH_TYPE_ALBUM,
+                                             "id", "200",
+                                             "link", "http://example.com/album",
+                                             "created_time", "2015-01-01T00:00:00+0000",
+                                             "name", "An album",
+                                             "description", "With \"quotes\" and ñ",
+                                             "cover_photo", "300",
+                                             "count", 12,
+                                             NULL));
+
+        return album;
+}
+
+static GFBGraphNode*
+gfbgraph_test_photo_new (void)
+{
+        GFBGraphNode *photo;
+        GList *images_list;
+
+        images_list = g_list_append (NULL, &test_images[0]);
+        images_list = g_list_append (images_list, &test_images[1]);
+
+        photo = GFBGRAPH_NODE (g_object_new (GFBGRAPH_TYPE_PHOTO,
+                                             "id", "300",
+                                             "name", "A photo",
+                                             "source", "http://example.com/300.jpg",
+                                             "width", 720,
+                                             "height", 480,
+                                             "images", images_list,
+                                             NULL));
+        g_list_free (images_list);
+
+        return photo;
+}
+
+/* Gets the compact JSON of @node */
+static gchar*
+gfbgraph_test_node_to_data (GFBGraphNode *node)
+{
+        JsonGenerator *generator;
+        JsonNode *json_node;
+        gchar *data;
+
+        json_node = gfbgraph_node_serialize (node);
+        g_assert (JSON_NODE_HOLDS_OBJECT (json_node));
+
+        generator = json_generator_new ();
+        json_generator_set_root (generator, json_node);
+        data = json_generator_to_data (generator, NULL);
+
+        g_object_unref (generator);
+        json_node_free (json_node);
+
+        return data;
+}
+
+/* Checks that @node survives a serialization round trip */
+static GFBGraphNode*
+gfbgraph_test_node_round_trip (GFBGraphNode *node)
+{
+        GFBGraphNode *copy;
+        JsonNode *json_node;
+        gchar *data;
+        gchar *copy_data;
+
+        json_node = gfbgraph_node_serialize (node);
+        copy = gfbgraph_node_new_from_json (G_OBJECT_TYPE (node), json_node);
+        json_node_free (json_node);
+
+        g_assert (copy != node);
+        g_assert (G_OBJECT_TYPE (copy) == G_OBJECT_TYPE (node));
+
+        data = gfbgraph_test_node_to_data (node);
+        copy_data = gfbgraph_test_node_to_data (copy);
+        g_assert_cmpstr (copy_data, ==, data);
+        g_free (copy_data);
+        g_free (data);
+
+        return copy;
+}
+
+static void
+gfbgraph_test_serializer_round_trip (void)
+{
+        GFBGraphNode *node;
+        GFBGraphNode *copy;
+        const GFBGraphPhotoImage *images;
+        guint n_images;
+
+        node = gfbgraph_test_album_new ();
+        copy = gfbgraph_test_node_round_trip (node);
+        g_assert_cmpstr (gfbgraph_node_get_id (copy), ==, "200");
+        g_assert_cmpstr (gfbgraph_node_get_link (copy), ==, "http://example.com/album");
+        g_assert_cmpstr (gfbgraph_node_get_created_time (copy), ==, "2015-01-01T00:00:00+0000");
+        g_assert_cmpstr (gfbgraph_album_get_description (GFBGRAPH_ALBUM (copy)), ==, "With \"quotes\" and ñ");
+        g_assert_cmpstr (gfbgraph_album_get_cover_photo_id (GFBGRAPH_ALBUM (copy)), ==, "300");
+        g_assert_cmpuint (gfbgraph_album_get_count (GFBGRAPH_ALBUM (copy)), ==, 12);
+        g_object_unref (copy);
+        g_object_unref (node);
+
+        node = gfbgraph_test_photo_new ();
+        copy = gfbgraph_test_node_round_trip (node);
+        g_assert_cmpstr (gfbgraph_photo_get_name (GFBGRAPH_PHOTO (copy)), ==, "A photo");
+        g_assert_cmpstr (gfbgraph_photo_get_default_source_uri (GFBGRAPH_PHOTO (copy)), ==, "http://example.com/300.jpg");
+        images = gfbgraph_photo_get_images_array (GFBGRAPH_PHOTO (copy), &n_images);
+        g_assert_cmpuint (n_images, ==, 2);
+        g_assert_cmpuint (images[0].width, ==, 720);
+        g_assert_cmpuint (images[1].height, ==, 87);
+        g_assert_cmpstr (images[1].source, ==, "http://example.com/130x87.jpg");
+        g_object_unref (copy);
+        g_object_unref (node);
+
+        /* The unset fields aren't serialized at all */
+        node = GFBGRAPH_NODE (gfbgraph_album_new ());
+        copy = gfbgraph_test_node_round_trip (node);
+        g_assert (gfbgraph_node_get_id (copy) == NULL);
+        g_assert (gfbgraph_album_get_name (GFBGRAPH_ALBUM (copy)) == NULL);
+        g_object_unref (copy);
+        g_object_unref (node);
+}
+
+static void
+gfbgraph_test_serializer_streams (void)
+{
+        GOutputStream *output;
+        GInputStream *input;
+        GBytes *bytes;
+        GPtrArray *nodes;
+        GPtrArray *read_nodes;
+        GError *error = NULL;
+        guint i;
+
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+        g_ptr_array_add (nodes, gfbgraph_test_album_new ());
+        g_ptr_array_add (nodes, gfbgraph_test_photo_new ());
+        g_ptr_array_add (nodes, gfbgraph_album_new ());
+
+        output = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+        g_assert (gfbgraph_node_write_nodes (nodes, output, NULL, &error));
+        g_assert_no_error (error);
+        g_assert (g_output_stream_close (output, NULL, &error));
+        g_assert_no_error (error);
+
+        bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (output));
+        input = g_memory_input_stream_new_from_bytes (bytes);
+        g_bytes_unref (bytes);
+        read_nodes = gfbgraph_node_read_nodes (input, NULL, &error);
+        g_assert_no_error (error);
+
+        /* The same nodes, in the same order */
+        g_assert_cmpuint (read_nodes->len, ==, nodes->len);
+        for (i = 0; i < nodes->len; i++) {
+                GFBGraphNode *node;
+                GFBGraphNode *read_node;
+                gchar *data;
+                gchar *read_data;
+
+                node = g_ptr_array_index (nodes, i);
+                read_node = g_ptr_array_index (read_nodes, i);
+                g_assert (G_OBJECT_TYPE (read_node) == G_OBJECT_TYPE (node));
+
+                data = gfbgraph_test_node_to_data (node);
+                read_data = gfbgraph_test_node_to_data (read_node);
+                g_assert_cmpstr (read_data, ==, data);
+                g_free (read_data);
+                g_free (data);
+        }
+
+        g_ptr_array_unref (read_nodes);
+        g_object_unref (input);
+        g_object_unref (output);
+        g_ptr_array_unref (nodes);
+}
+
+static void
+gfbgraph_test_serializer_invalid (gconstpointer user_data)
+{
+        GInputStream *input;
+        GPtrArray *nodes;
+        GError *error = NULL;
+
+        input = g_memory_input_stream_new_from_data (user_data, -1, NULL);
+        nodes = gfbgraph_node_read_nodes (input, NULL, &error);
+        g_assert (nodes == NULL);
+        g_assert (error != NULL);
+        g_error_free (error);
+
+        g_object_unref (input);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add_func ("/GFBGraph/Serializer/RoundTrip", gfbgraph_test_serializer_round_trip);
+        g_test_add_func ("/GFBGraph/Serializer/Streams", gfbgraph_test_serializer_streams);
+        g_test_add_data_func ("/GFBGraph/Serializer/UnknownType",
+                              "{\"type\": \"GFBGraphAlbum\", \"node\": {\"id\": \"1\"}}\n"
+                              "{\"type\": \"GObject\", \"node\": {\"id\": \"2\"}}\n",
+                              gfbgraph_test_serializer_invalid);
+        g_test_add_data_func ("/GFBGraph/Serializer/BrokenLine",
+                              "{\"type\": \"GFBGraphAlbum\", \"node\": {\"id\": \"1\"\n",
+                              gfbgraph_test_serializer_invalid);
+
+        return g_test_run ();
+}
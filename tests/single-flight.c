@@ -0,0 +1,309 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the requests shared between concurrent callers */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-private.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+#define FLIGHT_KEY "flight"
+
+/* Time for a second caller to join the running flight */
+#define JOIN_DELAY_MS 200
+
+typedef struct {
+        GMutex mutex;
+        GCond cond;
+        gint calls;
+        gboolean released;
+        gboolean fail;
+        gboolean leader_late;
+} GFBGraphTestFlight;
+
+static GFBGraphTestServer *server = NULL;
+
+static gpointer
+gfbgraph_test_flight_func (gpointer user_data, GError **error)
+{
+        GFBGraphTestFlight *flight;
+        gint calls;
+
+        flight = (GFBGraphTestFlight *) user_data;
+
+        g_mutex_lock (&flight->mutex);
+        calls = ++flight->calls;
+        g_cond_broadcast (&flight->cond);
+        while (!flight->released)
+                g_cond_wait (&flight->cond, &flight->mutex);
+        g_mutex_unlock (&flight->mutex);
+
+        /* As if the first caller had missed its own deadline */
+        if (flight->leader_late && calls == 1) {
+                g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "Late flight");
+                return NULL;
+        }
+
+        if (flight->fail) {
+                g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed flight");
+                return NULL;
+        }
+
+        return g_strdup ("result");
+}
+
+static gpointer
+gfbgraph_test_flight_thread (gpointer user_data)
+{
+        GError *error = NULL;
+        gchar *result;
+
+        result = gfbgraph_single_flight (FLIGHT_KEY, gfbgraph_test_flight_func, user_data,
+                                         (GBoxedCopyFunc) g_strdup, g_free, &error);
+        g_assert ((result == NULL) == (error != NULL));
+        if (error != NULL) {
+                g_assert (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_FAILED)
+                          || g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT));
+                g_error_free (error);
+        }
+
+        return result;
+}
+
+static void
+gfbgraph_test_single_flight_coalesce (gconstpointer user_data)
+{
+        GFBGraphTestFlight flight;
+        GThread *first;
+        GThread *second;
+        gchar *first_result;
+        gchar *second_result;
+
+        memset (&flight, 0, sizeof (flight));
+        g_mutex_init (&flight.mutex);
+        g_cond_init (&flight.cond);
+        flight.fail = GPOINTER_TO_INT (user_data);
+
+        first = g_thread_new ("first", gfbgraph_test_flight_thread, &flight);
+
+        g_mutex_lock (&flight.mutex);
+        while (flight.calls == 0)
+                g_cond_wait (&flight.cond, &flight.mutex);
+        g_mutex_unlock (&flight.mutex);
+
+        second = g_thread_new ("second", gfbgraph_test_flight_thread, &flight);
+        g_usleep (JOIN_DELAY_MS * 1000);
+
+        g_mutex_lock (&flight.mutex);
+        flight.released = TRUE;
+        g_cond_broadcast (&flight.cond);
+        g_mutex_unlock (&flight.mutex);
+
+        first_result = g_thread_join (first);
+        second_result = g_thread_join (second);
+
+        /* One run, a copy of the result or the error for each caller */
+        g_assert_cmpint (flight.calls, ==, 1);
+        if (flight.fail) {
+                g_assert (first_result == NULL);
+                g_assert (second_result == NULL);
+        } else {
+                g_assert_cmpstr (first_result, ==, "result");
+                g_assert_cmpstr (second_result, ==, "result");
+                g_assert (first_result != second_result);
+        }
+
+        /* A finished flight isn't shared with the later callers */
+        g_free (gfbgraph_test_flight_thread (&flight));
+        g_assert_cmpint (flight.calls, ==, 2);
+
+        g_free (first_result);
+        g_free (second_result);
+        g_mutex_clear (&flight.mutex);
+        g_cond_clear (&flight.cond);
+}
+
+static void
+gfbgraph_test_single_flight_leader_late (void)
+{
+        GFBGraphTestFlight flight;
+        GThread *first;
+        GThread *second;
+        gchar *first_result;
+        gchar *second_result;
+
+        memset (&flight, 0, sizeof (flight));
+        g_mutex_init (&flight.mutex);
+        g_cond_init (&flight.cond);
+        flight.leader_late = TRUE;
+
+        first = g_thread_new ("first", gfbgraph_test_flight_thread, &flight);
+
+        g_mutex_lock (&flight.mutex);
+        while (flight.calls == 0)
+                g_cond_wait (&flight.cond, &flight.mutex);
+        g_mutex_unlock (&flight.mutex);
+
+        second = g_thread_new ("second", gfbgraph_test_flight_thread, &flight);
+        g_usleep (JOIN_DELAY_MS * 1000);
+
+        g_mutex_lock (&flight.mutex);
+        flight.released = TRUE;
+        g_cond_broadcast (&flight.cond);
+        g_mutex_unlock (&flight.mutex);
+
+        first_result = g_thread_join (first);
+        second_result = g_thread_join (second);
+
+        /* The timeout stays with the first caller, the second one runs again */
+        g_assert (first_result == NULL);
+        g_assert_cmpstr (second_result, ==, "result");
+        g_assert_cmpint (flight.calls, ==, 2);
+
+        g_free (second_result);
+        g_mutex_clear (&flight.mutex);
+        g_cond_clear (&flight.cond);
+}
+
+static gpointer
+gfbgraph_test_node_thread (gpointer user_data)
+{
+        GError *error = NULL;
+        GFBGraphNode *node;
+
+        node = gfbgraph_node_new_from_id (GFBGRAPH_AUTHORIZER (user_data), "42", GFBGRAPH_TYPE_PHOTO, &error);
+        g_assert_no_error (error);
+
+        return node;
+}
+
+static gpointer
+gfbgraph_test_late_node_thread (gpointer user_data)
+{
+        GError *error = NULL;
+        GFBGraphNode *node;
+
+        gfbgraph_set_thread_deadline (g_get_monotonic_time () + JOIN_DELAY_MS * G_TIME_SPAN_MILLISECOND);
+
+        node = gfbgraph_node_new_from_id (GFBGRAPH_AUTHORIZER (user_data), "42", GFBGRAPH_TYPE_PHOTO, &error);
+        g_assert (node == NULL);
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+        g_error_free (error);
+
+        return NULL;
+}
+
+static void
+gfbgraph_test_single_flight_node_leader_late (void)
+{
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphNode *node;
+        GThread *late;
+        GThread *second;
+
+        /* Longer than the deadline of the first caller */
+        gfbgraph_test_server_add (server, "/42", NULL, SOUP_STATUS_OK, "{\"id\": \"42\", \"name\": \"A photo\"}");
+        gfbgraph_test_server_set_delay (server, JOIN_DELAY_MS * 2);
+
+        authorizer = gfbgraph_simple_authorizer_new ("token");
+
+        late = g_thread_new ("late", gfbgraph_test_late_node_thread, authorizer);
+        g_usleep (JOIN_DELAY_MS * 1000 / 2);
+        second = g_thread_new ("second", gfbgraph_test_node_thread, authorizer);
+
+        g_thread_join (late);
+        node = g_thread_join (second);
+
+        /* The caller without deadline did its own request */
+        g_assert (GFBGRAPH_IS_PHOTO (node));
+        g_assert_cmpstr (gfbgraph_node_get_id (node), ==, "42");
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 2);
+
+        g_object_unref (node);
+        g_object_unref (authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+static void
+gfbgraph_test_single_flight_node (void)
+{
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphNode *first_node;
+        GFBGraphNode *second_node;
+        GThread *first;
+        GThread *second;
+
+        gfbgraph_test_server_add (server, "/42", NULL, SOUP_STATUS_OK, "{\"id\": \"42\", \"name\": \"A photo\"}");
+        gfbgraph_test_server_set_delay (server, JOIN_DELAY_MS);
+
+        authorizer = gfbgraph_simple_authorizer_new ("token");
+
+        first = g_thread_new ("first", gfbgraph_test_node_thread, authorizer);
+        second = g_thread_new ("second", gfbgraph_test_node_thread, authorizer);
+        first_node = g_thread_join (first);
+        second_node = g_thread_join (second);
+
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 1);
+
+        /* The request is shared, but not the node */
+        g_assert (first_node != NULL);
+        g_assert (second_node != NULL);
+        g_assert (first_node != second_node);
+        g_assert_cmpstr (gfbgraph_node_get_id (first_node), ==, "42");
+        g_assert_cmpstr (gfbgraph_node_get_id (second_node), ==, "42");
+
+        g_object_set (first_node, "name", "Renamed", NULL);
+        g_assert_cmpstr (gfbgraph_photo_get_name (GFBGRAPH_PHOTO (second_node)), ==, "A photo");
+
+        g_object_unref (first_node);
+        g_object_unref (second_node);
+        g_object_unref (authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add_data_func ("/GFBGraph/SingleFlight/Coalesce", GINT_TO_POINTER (FALSE), gfbgraph_test_single_flight_coalesce);
+        g_test_add_data_func ("/GFBGraph/SingleFlight/Error", GINT_TO_POINTER (TRUE), gfbgraph_test_single_flight_coalesce);
+        g_test_add_func ("/GFBGraph/SingleFlight/Node", gfbgraph_test_single_flight_node);
+        g_test_add_func ("/GFBGraph/SingleFlight/LeaderLate", gfbgraph_test_single_flight_leader_late);
+        g_test_add_func ("/GFBGraph/SingleFlight/NodeLeaderLate", gfbgraph_test_single_flight_node_leader_late);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
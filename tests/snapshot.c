@@ -0,0 +1,206 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the snapshots, over a temporary file */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+
+typedef struct {
+        gchar *directory;
+        gchar *path;
+} GFBGraphTestSnapshotFixture;
+
+static GFBGraphPhotoImage test_images[] = {
+        { 720, 480, (gchar *) "http://example.com/720x480.jpg" },
+        { 130, 87, (gchar *) "http://example.com/130x87.jpg" }
+};
+
+static GFBGraphNode*
+gfbgraph_test_node_new (GType node_type, const gchar *id, const gchar *name)
+{
+        GFBGraphNode *node;
+
+        node = GFBGRAPH_NODE (g_object_new (node_type, "name", name, NULL));
+        if (id != NULL)
+                gfbgraph_node_set_id (node, id);
+
+        return node;
+}
+
+static void
+gfbgraph_test_snapshot_fixture_setup (GFBGraphTestSnapshotFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+
+        fixture->directory = g_dir_make_tmp ("gfbgraph-snapshot-XXXXXX", &error);
+        g_assert_no_error (error);
+        fixture->path = g_build_filename (fixture->directory, "nodes.snapshot", NULL);
+}
+
+static void
+gfbgraph_test_snapshot_fixture_teardown (GFBGraphTestSnapshotFixture *fixture, gconstpointer user_data)
+{
+        g_unlink (fixture->path);
+        g_rmdir (fixture->directory);
+
+        g_free (fixture->path);
+        g_free (fixture->directory);
+}
+
+static void
+gfbgraph_test_snapshot_round_trip (GFBGraphTestSnapshotFixture *fixture, gconstpointer user_data)
+{
+        GFBGraphSnapshot *snapshot;
+        GFBGraphNode *photo;
+        GFBGraphNode *node;
+        GPtrArray *nodes;
+        GList *images_list;
+        const GFBGraphPhotoImage *image;
+        GError *error = NULL;
+        guint n_images;
+
+        photo = gfbgraph_test_node_new (GFBGRAPH_TYPE_PHOTO, "300", "A photo");
+        images_list = g_list_append (NULL, &test_images[0]);
+        images_list = g_list_append (images_list, &test_images[1]);
+        g_object_set (photo, "images", images_list, NULL);
+        g_list_free (images_list);
+
+        /* Not sorted by ID, and one without ID at all */
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+        g_ptr_array_add (nodes, photo);
+        g_ptr_array_add (nodes, gfbgraph_test_node_new (GFBGRAPH_TYPE_USER, "100", "A user"));
+        g_ptr_array_add (nodes, gfbgraph_test_node_new (GFBGRAPH_TYPE_ALBUM, NULL, "A new album"));
+        g_ptr_array_add (nodes, gfbgraph_test_node_new (GFBGRAPH_TYPE_ALBUM, "200", "An album"));
+
+        g_assert (gfbgraph_snapshot_write (nodes, fixture->path, &error));
+        g_assert_no_error (error);
+        g_ptr_array_unref (nodes);
+
+        snapshot = gfbgraph_snapshot_new_from_file (fixture->path, &error);
+        g_assert_no_error (error);
+        g_assert (snapshot != NULL);
+
+        g_assert_cmpuint (gfbgraph_snapshot_get_n_nodes (snapshot), ==, 4);
+
+        /* The nodes keep their order, type and members */
+        node = gfbgraph_snapshot_get_node (snapshot, 0);
+        g_assert (GFBGRAPH_IS_PHOTO (node));
+        g_assert_cmpstr (gfbgraph_node_get_id (node), ==, "300");
+        g_assert_cmpstr (gfbgraph_photo_get_name (GFBGRAPH_PHOTO (node)), ==, "A photo");
+        image = gfbgraph_photo_get_images_array (GFBGRAPH_PHOTO (node), &n_images);
+        g_assert_cmpuint (n_images, ==, 2);
+        g_assert_cmpuint (image[1].width, ==, 130);
+        g_assert_cmpuint (image[1].height, ==, 87);
+        g_assert_cmpstr (image[1].source, ==, "http://example.com/130x87.jpg");
+        g_object_unref (node);
+
+        node = gfbgraph_snapshot_get_node (snapshot, 2);
+        g_assert (GFBGRAPH_IS_ALBUM (node));
+        g_assert (gfbgraph_node_get_id (node) == NULL);
+        g_assert_cmpstr (gfbgraph_album_get_name (GFBGRAPH_ALBUM (node)), ==, "A new album");
+        g_object_unref (node);
+
+        /* Every call gives a new node */
+        node = gfbgraph_snapshot_get_node (snapshot, 1);
+        photo = gfbgraph_snapshot_get_node (snapshot, 1);
+        g_assert (GFBGRAPH_IS_USER (node));
+        g_assert (node != photo);
+        g_object_unref (photo);
+        g_object_unref (node);
+
+        gfbgraph_snapshot_unref (snapshot);
+}
+
+static void
+gfbgraph_test_snapshot_lookup (GFBGraphTestSnapshotFixture *fixture, gconstpointer user_data)
+{
+        GFBGraphSnapshot *snapshot;
+        GFBGraphNode *node;
+        GPtrArray *nodes;
+        GError *error = NULL;
+        guint i;
+
+        /* Enough nodes for the binary search to take a few steps */
+        nodes = g_ptr_array_new_with_free_func (g_object_unref);
+        for (i = 0; i < 50; i++) {
+                gchar *id;
+
+                id = g_strdup_printf ("%u", (i * 37) % 50 + 1000);
+                g_ptr_array_add (nodes, gfbgraph_test_node_new (GFBGRAPH_TYPE_ALBUM, id, id));
+                g_free (id);
+        }
+
+        g_assert (gfbgraph_snapshot_write (nodes, fixture->path, &error));
+        g_assert_no_error (error);
+        g_ptr_array_unref (nodes);
+
+        snapshot = gfbgraph_snapshot_new_from_file (fixture->path, &error);
+        g_assert_no_error (error);
+
+        for (i = 1000; i < 1050; i++) {
+                gchar *id;
+
+                id = g_strdup_printf ("%u", i);
+                node = gfbgraph_snapshot_lookup (snapshot, id);
+                g_assert (GFBGRAPH_IS_ALBUM (node));
+                g_assert_cmpstr (gfbgraph_node_get_id (node), ==, id);
+                g_assert_cmpstr (gfbgraph_album_get_name (GFBGRAPH_ALBUM (node)), ==, id);
+                g_object_unref (node);
+                g_free (id);
+        }
+
+        g_assert (gfbgraph_snapshot_lookup (snapshot, "0") == NULL);
+        g_assert (gfbgraph_snapshot_lookup (snapshot, "1025a") == NULL);
+        g_assert (gfbgraph_snapshot_lookup (snapshot, "9999") == NULL);
+
+        gfbgraph_snapshot_unref (snapshot);
+}
+
+static void
+gfbgraph_test_snapshot_invalid (GFBGraphTestSnapshotFixture *fixture, gconstpointer user_data)
+{
+        GFBGraphSnapshot *snapshot;
+        GError *error = NULL;
+
+        g_assert (g_file_set_contents (fixture->path, "{\"data\": []}", -1, NULL));
+
+        snapshot = gfbgraph_snapshot_new_from_file (fixture->path, &error);
+        g_assert (snapshot == NULL);
+        g_assert_error (error, GFBGRAPH_NODE_ERROR, GFBGRAPH_NODE_ERROR_INVALID_DATA);
+        g_error_free (error);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add ("/GFBGraph/Snapshot/RoundTrip", GFBGraphTestSnapshotFixture, NULL,
+                    gfbgraph_test_snapshot_fixture_setup, gfbgraph_test_snapshot_round_trip, gfbgraph_test_snapshot_fixture_teardown);
+        g_test_add ("/GFBGraph/Snapshot/Lookup", GFBGraphTestSnapshotFixture, NULL,
+                    gfbgraph_test_snapshot_fixture_setup, gfbgraph_test_snapshot_lookup, gfbgraph_test_snapshot_fixture_teardown);
+        g_test_add ("/GFBGraph/Snapshot/Invalid", GFBGraphTestSnapshotFixture, NULL,
+                    gfbgraph_test_snapshot_fixture_setup, gfbgraph_test_snapshot_invalid, gfbgraph_test_snapshot_fixture_teardown);
+
+        return g_test_run ();
+}
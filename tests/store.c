@@ -0,0 +1,263 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Offline tests of the persistent store, over a temporary file */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+
+typedef struct {
+        gchar *directory;
+        gchar *path;
+
+        GFBGraphNode *user;
+        GFBGraphNode *album;
+} GFBGraphTestStoreFixture;
+
+static GFBGraphNode*
+gfbgraph_test_node_new (GType node_type, const gchar *id, const gchar *created_time)
+{
+        GFBGraphNode *node;
+
+        node = GFBGRAPH_NODE (g_object_new (node_type, "created_time", created_time, NULL));
+        gfbgraph_node_set_id (node, id);
+
+        return node;
+}
+
+static void
+gfbgraph_test_store_fixture_setup (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+
+        fixture->directory = g_dir_make_tmp ("gfbgraph-store-XXXXXX", &error);
+        g_assert_no_error (error);
+        fixture->path = g_build_filename (fixture->directory, "store.log", NULL);
+
+        fixture->user = gfbgraph_test_node_new (GFBGRAPH_TYPE_USER, "100", "2010-01-01T00:00:00+0000");
+        fixture->album = gfbgraph_test_node_new (GFBGRAPH_TYPE_ALBUM, "200", "2011-01-01T00:00:00+0000");
+}
+
+static void
+gfbgraph_test_store_fixture_teardown (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        g_unlink (fixture->path);
+        g_rmdir (fixture->directory);
+
+        g_object_unref (fixture->album);
+        g_object_unref (fixture->user);
+        g_free (fixture->path);
+        g_free (fixture->directory);
+}
+
+static GFBGraphStore*
+gfbgraph_test_store_open (GFBGraphTestStoreFixture *fixture)
+{
+        GFBGraphStore *store;
+        GError *error = NULL;
+
+        store = gfbgraph_store_new (fixture->path, &error);
+        g_assert_no_error (error);
+        g_assert (GFBGRAPH_IS_STORE (store));
+
+        return store;
+}
+
+static void
+gfbgraph_test_store_put (GFBGraphStore *store, const gchar *id, const gchar *created_time, GFBGraphNode *parent)
+{
+        GFBGraphNode *photo;
+        GError *error = NULL;
+
+        photo = gfbgraph_test_node_new (GFBGRAPH_TYPE_PHOTO, id, created_time);
+        g_assert (gfbgraph_store_put (store, photo, parent, &error));
+        g_assert_no_error (error);
+        g_object_unref (photo);
+}
+
+/* Checks the IDs of the photos of @parent in @store, newest first */
+static void
+gfbgraph_test_store_assert_connection (GFBGraphStore *store, GFBGraphNode *parent, const gchar * const *ids)
+{
+        GPtrArray *nodes;
+        guint i;
+
+        nodes = gfbgraph_store_get_connection_nodes (store, parent, GFBGRAPH_TYPE_PHOTO, 0);
+        g_assert_cmpuint (nodes->len, ==, g_strv_length ((gchar **) ids));
+        for (i = 0; i < nodes->len; i++)
+                g_assert_cmpstr (gfbgraph_node_get_id (g_ptr_array_index (nodes, i)), ==, ids[i]);
+
+        g_ptr_array_unref (nodes);
+}
+
+static void
+gfbgraph_test_store_replay (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        const gchar *user_photos[] = { "2", "1", NULL };
+        const gchar *album_photos[] = { "1", NULL };
+        GFBGraphStore *store;
+        GFBGraphNode *node;
+        GError *error = NULL;
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_put (store, "1", "2015-01-01T00:00:00+0000", fixture->user);
+        gfbgraph_test_store_put (store, "2", "2015-02-01T00:00:00+0000", fixture->user);
+        gfbgraph_test_store_put (store, "3", "2015-03-01T00:00:00+0000", fixture->user);
+        g_assert (gfbgraph_store_remove (store, "3", &error));
+        g_assert_no_error (error);
+        /* The same photo in a second connection */
+        gfbgraph_test_store_put (store, "1", "2015-01-01T00:00:00+0000", fixture->album);
+        g_object_unref (store);
+
+        store = gfbgraph_test_store_open (fixture);
+
+        gfbgraph_test_store_assert_connection (store, fixture->user, user_photos);
+        gfbgraph_test_store_assert_connection (store, fixture->album, album_photos);
+
+        node = gfbgraph_store_lookup_node (store, "3");
+        g_assert (node == NULL);
+
+        node = gfbgraph_store_lookup_node (store, "2");
+        g_assert (GFBGRAPH_IS_PHOTO (node));
+        g_assert_cmpstr (gfbgraph_node_get_created_time (node), ==, "2015-02-01T00:00:00+0000");
+        g_object_unref (node);
+
+        g_object_unref (store);
+}
+
+static void
+gfbgraph_test_store_compact (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        const gchar *user_photos[] = { "2", "1", NULL };
+        GFBGraphStore *store;
+        GFBGraphNode *node;
+        GError *error = NULL;
+        GStatBuf before;
+        GStatBuf after;
+        guint i;
+
+        store = gfbgraph_test_store_open (fixture);
+        for (i = 0; i < 10; i++) {
+                gfbgraph_test_store_put (store, "1", "2015-01-01T00:00:00+0000", fixture->user);
+                gfbgraph_test_store_put (store, "2", "2015-02-01T00:00:00+0000", fixture->user);
+        }
+
+        g_assert_cmpint (g_stat (fixture->path, &before), ==, 0);
+        g_assert (gfbgraph_store_compact (store, &error));
+        g_assert_no_error (error);
+        g_assert_cmpint (g_stat (fixture->path, &after), ==, 0);
+        g_assert_cmpint (after.st_size, <, before.st_size);
+
+        /* Still appending after the log was replaced */
+        gfbgraph_test_store_put (store, "3", "2014-01-01T00:00:00+0000", NULL);
+        g_object_unref (store);
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_assert_connection (store, fixture->user, user_photos);
+        node = gfbgraph_store_lookup_node (store, "3");
+        g_assert (GFBGRAPH_IS_PHOTO (node));
+        g_object_unref (node);
+        g_object_unref (store);
+}
+
+/* A record cut by a crash is dropped, and doesn't take the next one with it */
+static void
+gfbgraph_test_store_torn_record (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        const gchar *user_photos[] = { "2", "1", NULL };
+        const gchar *torn = "{\"id\":\"9\",\"type\":\"GFBGra";
+        GFBGraphStore *store;
+        gchar *contents;
+        gchar *torn_contents;
+        GError *error = NULL;
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_put (store, "1", "2015-01-01T00:00:00+0000", fixture->user);
+        g_object_unref (store);
+
+        g_file_get_contents (fixture->path, &contents, NULL, &error);
+        g_assert_no_error (error);
+        torn_contents = g_strconcat (contents, torn, NULL);
+        g_file_set_contents (fixture->path, torn_contents, -1, &error);
+        g_assert_no_error (error);
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_put (store, "2", "2015-02-01T00:00:00+0000", fixture->user);
+        g_object_unref (store);
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_assert_connection (store, fixture->user, user_photos);
+        g_assert (gfbgraph_store_lookup_node (store, "9") == NULL);
+        g_object_unref (store);
+
+        g_free (torn_contents);
+        g_free (contents);
+}
+
+/* Records whose "id" or "type" aren't strings are skipped */
+static void
+gfbgraph_test_store_mistyped_record (GFBGraphTestStoreFixture *fixture, gconstpointer user_data)
+{
+        const gchar *user_photos[] = { "1", NULL };
+        const gchar *mistyped = "{\"id\":1,\"removed\":true}\n"
+                                "{\"id\":9,\"type\":\"GFBGraphPhoto\",\"node\":{}}\n"
+                                "{\"id\":\"8\",\"type\":8,\"node\":{}}\n";
+        GFBGraphStore *store;
+        gchar *contents;
+        gchar *mistyped_contents;
+        GError *error = NULL;
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_put (store, "1", "2015-01-01T00:00:00+0000", fixture->user);
+        g_object_unref (store);
+
+        g_file_get_contents (fixture->path, &contents, NULL, &error);
+        g_assert_no_error (error);
+        mistyped_contents = g_strconcat (contents, mistyped, NULL);
+        g_file_set_contents (fixture->path, mistyped_contents, -1, &error);
+        g_assert_no_error (error);
+
+        store = gfbgraph_test_store_open (fixture);
+        gfbgraph_test_store_assert_connection (store, fixture->user, user_photos);
+        g_assert (gfbgraph_store_lookup_node (store, "8") == NULL);
+        g_object_unref (store);
+
+        g_free (mistyped_contents);
+        g_free (contents);
+}
+
+int
+main (int argc, char **argv)
+{
+        g_test_init (&argc, &argv, NULL);
+
+        g_test_add ("/GFBGraph/Store/Replay", GFBGraphTestStoreFixture, NULL,
+                    gfbgraph_test_store_fixture_setup, gfbgraph_test_store_replay, gfbgraph_test_store_fixture_teardown);
+        g_test_add ("/GFBGraph/Store/Compact", GFBGraphTestStoreFixture, NULL,
+                    gfbgraph_test_store_fixture_setup, gfbgraph_test_store_compact, gfbgraph_test_store_fixture_teardown);
+        g_test_add ("/GFBGraph/Store/TornRecord", GFBGraphTestStoreFixture, NULL,
+                    gfbgraph_test_store_fixture_setup, gfbgraph_test_store_torn_record, gfbgraph_test_store_fixture_teardown);
+        g_test_add ("/GFBGraph/Store/MistypedRecord", GFBGraphTestStoreFixture, NULL,
+                    gfbgraph_test_store_fixture_setup, gfbgraph_test_store_mistyped_record, gfbgraph_test_store_fixture_teardown);
+
+        return g_test_run ();
+}
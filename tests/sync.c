@@ -0,0 +1,237 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the synchronization, against canned Graph API responses */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+/* 2014-01-01, 2014-01-02 and 2014-01-03 at 00:00 UTC */
+#define TIME_DAY_1 G_GINT64_CONSTANT (1388534400)
+#define TIME_DAY_2 G_GINT64_CONSTANT (1388620800)
+#define TIME_DAY_3 G_GINT64_CONSTANT (1388707200)
+#define TIME_DAY_4 G_GINT64_CONSTANT (1388793600)
+
+#define PHOTOS_PATH "/1/photos"
+
+#define GRAPH_ERROR "{\"error\": {\"message\": \"Internal error\", \"type\": \"OAuthException\", \"code\": 2}}"
+
+typedef struct {
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphAlbum *album;
+        GFBGraphSync *sync;
+} GFBGraphTestFixture;
+
+static GFBGraphTestServer *server = NULL;
+
+static void
+gfbgraph_test_fixture_setup (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        fixture->authorizer = gfbgraph_simple_authorizer_new ("token");
+        fixture->album = gfbgraph_album_new ();
+        g_object_set (fixture->album, "id", "1", NULL);
+        fixture->sync = gfbgraph_sync_new (GFBGRAPH_NODE (fixture->album), GFBGRAPH_TYPE_PHOTO);
+}
+
+static void
+gfbgraph_test_fixture_teardown (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        g_object_unref (fixture->sync);
+        g_object_unref (fixture->album);
+        g_object_unref (fixture->authorizer);
+
+        gfbgraph_test_server_clear (server);
+}
+
+static void
+gfbgraph_test_server_add_since (gint64 since, const gchar *body)
+{
+        gchar *query;
+
+        query = g_strdup_printf ("since=%" G_GINT64_FORMAT, since);
+        gfbgraph_test_server_add (server, PHOTOS_PATH, query, SOUP_STATUS_OK, body);
+        g_free (query);
+}
+
+static gboolean
+gfbgraph_test_sync_run (GFBGraphTestFixture *fixture, GError **error)
+{
+        return gfbgraph_sync_run (fixture->sync, GFBGRAPH_AUTHORIZER (fixture->authorizer), error);
+}
+
+static void
+gfbgraph_test_assert_ids (GPtrArray *nodes, const gchar *ids)
+{
+        gchar **expected;
+        guint i;
+
+        expected = g_strsplit (ids, ",", -1);
+        g_assert_cmpuint (nodes->len, ==, g_strv_length (expected));
+        for (i = 0; i < nodes->len; i++)
+                g_assert_cmpstr (gfbgraph_node_get_id (GFBGRAPH_NODE (g_ptr_array_index (nodes, i))), ==, expected[i]);
+        g_strfreev (expected);
+}
+
+static void
+gfbgraph_test_sync_changes (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+
+        /* The first run reports everything as added, following the pages */
+        gfbgraph_test_server_add (server, PHOTOS_PATH, NULL, SOUP_STATUS_OK,
+                                  "{\"data\": ["
+                                  "{\"id\": \"p1\", \"created_time\": \"2014-01-01T00:00:00+0000\"},"
+                                  "{\"id\": \"p2\", \"created_time\": \"2014-01-02T00:00:00+0000\"}],"
+                                  "\"paging\": {\"next\": \"https://graph.facebook.com/v2.3/1/photos?page=2\"}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=2", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p3\", \"created_time\": \"2014-01-03T00:00:00+0000\"}]}");
+
+        g_assert (gfbgraph_test_sync_run (fixture, &error));
+        g_assert_no_error (error);
+        gfbgraph_test_assert_ids (gfbgraph_sync_get_added (fixture->sync), "p1,p2,p3");
+        g_assert_cmpuint (gfbgraph_sync_get_changed (fixture->sync)->len, ==, 0);
+        g_assert_cmpuint (gfbgraph_sync_get_removed (fixture->sync)->len, ==, 0);
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_3);
+
+        /* An unmodified known node is skipped, the modified one is changed, and
+         * the one missing from the listing of the IDs is removed */
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add_since (TIME_DAY_3,
+                                        "{\"data\": ["
+                                        "{\"id\": \"p1\", \"created_time\": \"2014-01-01T00:00:00+0000\"},"
+                                        "{\"id\": \"p2\", \"created_time\": \"2014-01-02T00:00:00+0000\","
+                                        " \"updated_time\": \"2014-01-04T00:00:00+0000\"},"
+                                        "{\"id\": \"p4\", \"created_time\": \"2014-01-04T00:00:00+0000\"}]}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "fields=id", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p2\"}, {\"id\": \"p3\"}, {\"id\": \"p4\"}]}");
+
+        g_assert (gfbgraph_test_sync_run (fixture, &error));
+        g_assert_no_error (error);
+        gfbgraph_test_assert_ids (gfbgraph_sync_get_added (fixture->sync), "p4");
+        gfbgraph_test_assert_ids (gfbgraph_sync_get_changed (fixture->sync), "p2");
+        g_assert_cmpuint (gfbgraph_sync_get_removed (fixture->sync)->len, ==, 1);
+        g_assert_cmpstr (g_ptr_array_index (gfbgraph_sync_get_removed (fixture->sync), 0), ==, "p1");
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_4);
+}
+
+static void
+gfbgraph_test_sync_retry (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GError *error = NULL;
+
+        gfbgraph_test_server_add (server, PHOTOS_PATH, NULL, SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p1\", \"created_time\": \"2014-01-01T00:00:00+0000\"}]}");
+        g_assert (gfbgraph_test_sync_run (fixture, &error));
+        g_assert_no_error (error);
+
+        /* Fails on the second page of the changes */
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add_since (TIME_DAY_1,
+                                        "{\"data\": [{\"id\": \"p5\", \"created_time\": \"2014-01-02T00:00:00+0000\"}],"
+                                        "\"paging\": {\"next\": \"https://graph.facebook.com/v2.3/1/photos?page=2\"}}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "page=2", SOUP_STATUS_INTERNAL_SERVER_ERROR, GRAPH_ERROR);
+
+        g_assert (!gfbgraph_test_sync_run (fixture, &error));
+        g_assert (error != NULL);
+        g_clear_error (&error);
+        g_assert_cmpuint (gfbgraph_sync_get_added (fixture->sync)->len, ==, 0);
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_1);
+
+        /* Fails listing the IDs */
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add_since (TIME_DAY_1,
+                                        "{\"data\": [{\"id\": \"p5\", \"created_time\": \"2014-01-02T00:00:00+0000\"}]}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "fields=id", SOUP_STATUS_INTERNAL_SERVER_ERROR, GRAPH_ERROR);
+
+        g_assert (!gfbgraph_test_sync_run (fixture, &error));
+        g_assert (error != NULL);
+        g_clear_error (&error);
+        g_assert_cmpuint (gfbgraph_sync_get_added (fixture->sync)->len, ==, 0);
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_1);
+
+        /* The retry still reports the node as added */
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_add_since (TIME_DAY_1,
+                                        "{\"data\": [{\"id\": \"p5\", \"created_time\": \"2014-01-02T00:00:00+0000\"}]}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "fields=id", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p1\"}, {\"id\": \"p5\"}]}");
+
+        g_assert (gfbgraph_test_sync_run (fixture, &error));
+        g_assert_no_error (error);
+        gfbgraph_test_assert_ids (gfbgraph_sync_get_added (fixture->sync), "p5");
+        g_assert_cmpuint (gfbgraph_sync_get_changed (fixture->sync)->len, ==, 0);
+        g_assert_cmpuint (gfbgraph_sync_get_removed (fixture->sync)->len, ==, 0);
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_2);
+}
+
+static void
+gfbgraph_test_sync_old_unknown (GFBGraphTestFixture *fixture, gconstpointer user_data)
+{
+        GVariant *state;
+        GError *error = NULL;
+
+        /* A state that knows p1 only, with a mark after the creation of p2 */
+        state = g_variant_new ("(x^as)", TIME_DAY_3, (const gchar *[]) { "p1", NULL });
+        g_assert (gfbgraph_sync_load_state (fixture->sync, g_variant_ref_sink (state)));
+        g_variant_unref (state);
+
+        gfbgraph_test_server_add_since (TIME_DAY_3,
+                                        "{\"data\": ["
+                                        "{\"id\": \"p1\", \"created_time\": \"2014-01-01T00:00:00+0000\"},"
+                                        "{\"id\": \"p2\", \"created_time\": \"2014-01-02T00:00:00+0000\"}]}");
+        gfbgraph_test_server_add (server, PHOTOS_PATH, "fields=id", SOUP_STATUS_OK,
+                                  "{\"data\": [{\"id\": \"p1\"}, {\"id\": \"p2\"}]}");
+
+        /* Older than the mark, but never seen before */
+        g_assert (gfbgraph_test_sync_run (fixture, &error));
+        g_assert_no_error (error);
+        gfbgraph_test_assert_ids (gfbgraph_sync_get_added (fixture->sync), "p2");
+        g_assert_cmpuint (gfbgraph_sync_get_changed (fixture->sync)->len, ==, 0);
+        g_assert_cmpint (gfbgraph_sync_get_high_water_mark (fixture->sync), ==, TIME_DAY_3);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add ("/GFBGraph/Sync/Changes", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_sync_changes, gfbgraph_test_fixture_teardown);
+        g_test_add ("/GFBGraph/Sync/Retry", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_sync_retry, gfbgraph_test_fixture_teardown);
+        g_test_add ("/GFBGraph/Sync/OldUnknown", GFBGraphTestFixture, NULL,
+                    gfbgraph_test_fixture_setup, gfbgraph_test_sync_old_unknown, gfbgraph_test_fixture_teardown);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}
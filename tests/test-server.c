@@ -0,0 +1,303 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A local HTTP server answering the Graph API requests of the tests with
+ * canned JSON payloads, so they don't need network access nor credentials.
+ *
+ * It serves from its own thread, and gfbgraph_test_server_new() points the
+ * library to it with gfbgraph_transfer_set_endpoint(), so it has to be created
+ * before the first request of the test program. */
+
+#include <libsoup/soup.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph-private.h>
+
+#include "test-server.h"
+
+typedef struct {
+        gchar *path;
+        /* The params the request must have, a response with more of them
+         * is preferred over one with less */
+        GHashTable *query;
+        guint status;
+        gchar *body;
+} GFBGraphTestResponse;
+
+struct _GFBGraphTestServer {
+        SoupServer *server;
+        gchar *endpoint;
+        GMainContext *context;
+        GMainLoop *loop;
+        GThread *thread;
+
+        GMutex mutex;
+        GList *responses;
+        guint requests;
+        guint delay_ms;
+        gboolean compress;
+};
+
+static void
+gfbgraph_test_response_free (GFBGraphTestResponse *response)
+{
+        g_free (response->path);
+        if (response->query)
+                g_hash_table_unref (response->query);
+        g_free (response->body);
+        g_free (response);
+}
+
+static gboolean
+gfbgraph_test_response_matches (GFBGraphTestResponse *response, const gchar *path, GHashTable *query)
+{
+        GHashTableIter iter;
+        gpointer key;
+        gpointer value;
+
+        if (g_strcmp0 (response->path, path) != 0)
+                return FALSE;
+
+        if (response->query == NULL)
+                return TRUE;
+
+        g_hash_table_iter_init (&iter, response->query);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+                if (query == NULL || g_strcmp0 (g_hash_table_lookup (query, key), value) != 0)
+                        return FALSE;
+        }
+
+        return TRUE;
+}
+
+static GBytes*
+gfbgraph_test_server_gzip (const gchar *body)
+{
+        GZlibCompressor *compressor;
+        GOutputStream *memory;
+        GOutputStream *stream;
+        GBytes *bytes;
+
+        compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+        memory = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+        stream = g_converter_output_stream_new (memory, G_CONVERTER (compressor));
+
+        g_assert (g_output_stream_write_all (stream, body, strlen (body), NULL, NULL, NULL));
+        g_assert (g_output_stream_close (stream, NULL, NULL));
+        bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (memory));
+
+        g_object_unref (stream);
+        g_object_unref (memory);
+        g_object_unref (compressor);
+
+        return bytes;
+}
+
+static void
+gfbgraph_test_server_handler (SoupServer *soup_server, SoupMessage *msg, const char *path, GHashTable *query,
+                              SoupClientContext *client, gpointer user_data)
+{
+        GFBGraphTestServer *server;
+        GFBGraphTestResponse *best;
+        guint delay_ms;
+        GList *l;
+
+        server = (GFBGraphTestServer *) user_data;
+
+        g_mutex_lock (&server->mutex);
+
+        server->requests++;
+
+        best = NULL;
+        for (l = server->responses; l != NULL; l = l->next) {
+                GFBGraphTestResponse *response = l->data;
+
+                if (!gfbgraph_test_response_matches (response, path, query))
+                        continue;
+
+                if (best == NULL
+                    || (response->query ? g_hash_table_size (response->query) : 0) > (best->query ? g_hash_table_size (best->query) : 0))
+                        best = response;
+        }
+
+        if (best != NULL && server->compress
+            && soup_message_headers_header_contains (msg->request_headers, "Accept-Encoding", "gzip")) {
+                GBytes *bytes;
+
+                bytes = gfbgraph_test_server_gzip (best->body);
+                soup_message_set_status (msg, best->status);
+                soup_message_headers_append (msg->response_headers, "Content-Encoding", "gzip");
+                soup_message_set_response (msg, "application/json", SOUP_MEMORY_COPY,
+                                           g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+                g_bytes_unref (bytes);
+        } else if (best != NULL) {
+                soup_message_set_status (msg, best->status);
+                soup_message_set_response (msg, "application/json", SOUP_MEMORY_COPY, best->body, strlen (best->body));
+        } else {
+                const gchar *body = "{\"error\": {\"message\": \"No canned response\", \"type\": \"GraphMethodException\", \"code\": 100}}";
+
+                soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+                soup_message_set_response (msg, "application/json", SOUP_MEMORY_STATIC, body, strlen (body));
+        }
+
+        delay_ms = server->delay_ms;
+
+        g_mutex_unlock (&server->mutex);
+
+        /* Keeps the request in flight, to let others join it */
+        if (delay_ms > 0)
+                g_usleep (delay_ms * 1000);
+}
+
+static gpointer
+gfbgraph_test_server_thread (gpointer user_data)
+{
+        GFBGraphTestServer *server;
+
+        server = (GFBGraphTestServer *) user_data;
+
+        g_main_context_push_thread_default (server->context);
+        g_main_loop_run (server->loop);
+        g_main_context_pop_thread_default (server->context);
+
+        return NULL;
+}
+
+GFBGraphTestServer*
+gfbgraph_test_server_new (void)
+{
+        GFBGraphTestServer *server;
+        GSList *uris;
+        GError *error = NULL;
+
+        server = g_new0 (GFBGraphTestServer, 1);
+        g_mutex_init (&server->mutex);
+        server->context = g_main_context_new ();
+        server->loop = g_main_loop_new (server->context, FALSE);
+
+        /* The listening socket is attached to the thread default context */
+        g_main_context_push_thread_default (server->context);
+        server->server = soup_server_new (NULL, NULL);
+        soup_server_add_handler (server->server, NULL, gfbgraph_test_server_handler, server, NULL);
+        soup_server_listen_local (server->server, 0, SOUP_SERVER_LISTEN_IPV4_ONLY, &error);
+        g_main_context_pop_thread_default (server->context);
+        g_assert_no_error (error);
+
+        uris = soup_server_get_uris (server->server);
+        g_assert (uris != NULL);
+        server->endpoint = soup_uri_to_string (uris->data, FALSE);
+        g_slist_free_full (uris, (GDestroyNotify) soup_uri_free);
+
+        /* Without the trailing slash, like the real endpoint */
+        if (g_str_has_suffix (server->endpoint, "/"))
+                server->endpoint[strlen (server->endpoint) - 1] = '\0';
+        gfbgraph_transfer_set_endpoint (server->endpoint);
+
+        server->thread = g_thread_new ("gfbgraph-test-server", gfbgraph_test_server_thread, server);
+
+        return server;
+}
+
+void
+gfbgraph_test_server_free (GFBGraphTestServer *server)
+{
+        g_main_loop_quit (server->loop);
+        g_thread_join (server->thread);
+
+        soup_server_disconnect (server->server);
+        g_object_unref (server->server);
+        g_main_loop_unref (server->loop);
+        g_main_context_unref (server->context);
+
+        g_list_free_full (server->responses, (GDestroyNotify) gfbgraph_test_response_free);
+        g_mutex_clear (&server->mutex);
+        g_free (server->endpoint);
+        g_free (server);
+}
+
+/* Answers the requests to @path having every param of @query, a form encoded
+ * string or %NULL, with @status and the JSON @body */
+void
+gfbgraph_test_server_add (GFBGraphTestServer *server, const gchar *path, const gchar *query, guint status, const gchar *body)
+{
+        GFBGraphTestResponse *response;
+
+        response = g_new0 (GFBGraphTestResponse, 1);
+        response->path = g_strdup (path);
+        response->query = query != NULL ? soup_form_decode (query) : NULL;
+        response->status = status;
+        response->body = g_strdup (body);
+
+        g_mutex_lock (&server->mutex);
+        server->responses = g_list_prepend (server->responses, response);
+        g_mutex_unlock (&server->mutex);
+}
+
+void
+gfbgraph_test_server_clear (GFBGraphTestServer *server)
+{
+        g_mutex_lock (&server->mutex);
+        g_list_free_full (server->responses, (GDestroyNotify) gfbgraph_test_response_free);
+        server->responses = NULL;
+        server->requests = 0;
+        server->delay_ms = 0;
+        server->compress = FALSE;
+        g_mutex_unlock (&server->mutex);
+}
+
+/* Delays every response by @delay_ms milliseconds, until the next
+ * gfbgraph_test_server_clear() */
+void
+gfbgraph_test_server_set_delay (GFBGraphTestServer *server, guint delay_ms)
+{
+        g_mutex_lock (&server->mutex);
+        server->delay_ms = delay_ms;
+        g_mutex_unlock (&server->mutex);
+}
+
+/* Compresses the canned responses with gzip for the requests accepting it,
+ * until the next gfbgraph_test_server_clear() */
+void
+gfbgraph_test_server_set_compression (GFBGraphTestServer *server, gboolean compress)
+{
+        g_mutex_lock (&server->mutex);
+        server->compress = compress;
+        g_mutex_unlock (&server->mutex);
+}
+
+/* The number of requests served since the last gfbgraph_test_server_clear() */
+guint
+gfbgraph_test_server_get_requests (GFBGraphTestServer *server)
+{
+        guint requests;
+
+        g_mutex_lock (&server->mutex);
+        requests = server->requests;
+        g_mutex_unlock (&server->mutex);
+
+        return requests;
+}
+
+/* Returns the base URI of @server, without the trailing slash, to build the
+ * URIs of the downloads */
+const gchar*
+gfbgraph_test_server_get_uri (GFBGraphTestServer *server)
+{
+        return server->endpoint;
+}
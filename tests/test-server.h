@@ -0,0 +1,41 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GFBGRAPH_TEST_SERVER_H__
+#define __GFBGRAPH_TEST_SERVER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GFBGraphTestServer GFBGraphTestServer;
+
+GFBGraphTestServer* gfbgraph_test_server_new          (void);
+void                gfbgraph_test_server_free         (GFBGraphTestServer *server);
+void                gfbgraph_test_server_add          (GFBGraphTestServer *server, const gchar *path, const gchar *query,
+                                                       guint status, const gchar *body);
+void                gfbgraph_test_server_clear        (GFBGraphTestServer *server);
+void                gfbgraph_test_server_set_delay    (GFBGraphTestServer *server, guint delay_ms);
+void                gfbgraph_test_server_set_compression (GFBGraphTestServer *server, gboolean compress);
+guint               gfbgraph_test_server_get_requests (GFBGraphTestServer *server);
+const gchar*        gfbgraph_test_server_get_uri      (GFBGraphTestServer *server);
+
+G_END_DECLS
+
+#endif /* __GFBGRAPH_TEST_SERVER_H__ */
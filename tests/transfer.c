@@ -0,0 +1,154 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 8; tab-width: 8 -*-  */
+/*
+ * libgfbgraph - GObject library for Facebook Graph API
+ * Copyright (C) 2013 Álvaro Peña <alvaropg@gmail.com>
+ *
+ * GFBGraph is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * GFBGraph is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GFBGraph.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Offline tests of the HTTP layer, against the local test server */
+
+#include <glib.h>
+#include <string.h>
+
+#include <gfbgraph/gfbgraph.h>
+#include <gfbgraph/gfbgraph-simple-authorizer.h>
+
+#include "test-server.h"
+
+/* Nothing listens on it, the connections are refused at once */
+#define UNREACHABLE_URI "http://127.0.0.1:1/unreachable.jpg"
+
+static GFBGraphTestServer *server = NULL;
+
+/* One connection to the Graph API host and one per host of the URIs */
+static void
+gfbgraph_test_transfer_warmup (void)
+{
+        gchar *uris[3];
+        GError *error = NULL;
+
+        gfbgraph_test_server_clear (server);
+        uris[0] = g_strconcat (gfbgraph_test_server_get_uri (server), "/1.jpg", NULL);
+        uris[1] = g_strconcat (gfbgraph_test_server_get_uri (server), "/2.jpg", NULL);
+        uris[2] = NULL;
+
+        g_assert (gfbgraph_warmup ((const gchar * const *) uris, NULL, &error));
+        g_assert_no_error (error);
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 2);
+
+        g_free (uris[1]);
+        g_free (uris[0]);
+}
+
+/* An unreachable host fails the warmup, but the next hosts are warmed anyway */
+static void
+gfbgraph_test_transfer_warmup_unreachable (void)
+{
+        gchar *uris[4];
+        GError *error = NULL;
+
+        gfbgraph_test_server_clear (server);
+        uris[0] = g_strdup (UNREACHABLE_URI);
+        uris[1] = g_strconcat (gfbgraph_test_server_get_uri (server), "/1.jpg", NULL);
+        uris[2] = g_strconcat (gfbgraph_test_server_get_uri (server), "/2.jpg", NULL);
+        uris[3] = NULL;
+
+        g_assert (!gfbgraph_warmup ((const gchar * const *) uris, NULL, &error));
+        g_assert_error (error, G_IO_ERROR, G_IO_ERROR_FAILED);
+        g_clear_error (&error);
+        g_assert_cmpuint (gfbgraph_test_server_get_requests (server), ==, 2);
+
+        g_free (uris[2]);
+        g_free (uris[1]);
+        g_free (uris[0]);
+}
+
+/* Fetches the photo 42, named @name, and checks how the transfer stats grew */
+static void
+gfbgraph_test_transfer_fetch (const gchar *name, guint64 *wire_bytes, guint64 *decoded_bytes)
+{
+        GFBGraphSimpleAuthorizer *authorizer;
+        GFBGraphNode *node;
+        GError *error = NULL;
+        guint64 wire_before;
+        guint64 decoded_before;
+        gchar *body;
+
+        body = g_strdup_printf ("{\"id\": \"42\", \"name\": \"%s\"}", name);
+        gfbgraph_test_server_add (server, "/42", NULL, 200, body);
+        authorizer = gfbgraph_simple_authorizer_new ("token");
+
+        gfbgraph_get_transfer_stats (&wire_before, &decoded_before);
+        node = gfbgraph_node_new_from_id (GFBGRAPH_AUTHORIZER (authorizer), "42", GFBGRAPH_TYPE_PHOTO, &error);
+        g_assert_no_error (error);
+        g_assert_cmpstr (gfbgraph_photo_get_name (GFBGRAPH_PHOTO (node)), ==, name);
+        gfbgraph_get_transfer_stats (wire_bytes, decoded_bytes);
+        *wire_bytes -= wire_before;
+        *decoded_bytes -= decoded_before;
+
+        g_assert_cmpuint (*decoded_bytes, ==, strlen (body));
+
+        g_object_unref (node);
+        g_object_unref (authorizer);
+        g_free (body);
+}
+
+/* The responses are compressed when the server can, and the stats tell the
+ * bytes it saved */
+static void
+gfbgraph_test_transfer_compression (void)
+{
+        guint64 wire_bytes;
+        guint64 decoded_bytes;
+        GString *name;
+        guint i;
+
+        name = g_string_new (NULL);
+        for (i = 0; i < 100; i++)
+                g_string_append (name, "A photo of the album ");
+
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_transfer_fetch (name->str, &wire_bytes, &decoded_bytes);
+        g_assert_cmpuint (wire_bytes, ==, decoded_bytes);
+
+        gfbgraph_test_server_clear (server);
+        gfbgraph_test_server_set_compression (server, TRUE);
+        gfbgraph_test_transfer_fetch (name->str, &wire_bytes, &decoded_bytes);
+        g_assert_cmpuint (wire_bytes * 5, <, decoded_bytes);
+
+        g_string_free (name, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+        int result;
+
+        g_test_init (&argc, &argv, NULL);
+
+        /* Before any request, so the library uses it */
+        server = gfbgraph_test_server_new ();
+
+        g_test_add_func ("/GFBGraph/Transfer/Warmup", gfbgraph_test_transfer_warmup);
+        g_test_add_func ("/GFBGraph/Transfer/WarmupUnreachable", gfbgraph_test_transfer_warmup_unreachable);
+        g_test_add_func ("/GFBGraph/Transfer/Compression", gfbgraph_test_transfer_compression);
+
+        result = g_test_run ();
+
+        gfbgraph_test_server_free (server);
+
+        return result;
+}